@@ -6,7 +6,9 @@
  *
  * This file serves as the lesson and demonstration for a singly linked list.
  * It shows how to build one of the most fundamental dynamic data structures
- * from scratch using structs, pointers, and dynamic memory allocation.
+ * from scratch using structs, pointers, and dynamic memory allocation, and
+ * then how to make it fast: an unrolled list of cache-line-sized nodes,
+ * allocated from a pool.
  */
 
 /*
@@ -34,7 +36,9 @@
  */
 
 #include <stdio.h>
-#include <stdlib.h> // For malloc() and free()
+#include <stdlib.h> // For malloc(), aligned_alloc() and free()
+#include <string.h> // For strcmp(), memcpy() and memmove()
+#include <time.h>   // For timespec_get(), to time the benchmark
 
 // --- Part 1: The Building Block - The Node ---
 
@@ -122,11 +126,664 @@ void free_list(Node **head_ref)
     *head_ref = NULL;
 }
 
-int main(void)
+// --- Part 3: A Faster List - The Unrolled Linked List ---
+/*
+ * Our list works, but it is SLOW on a modern computer, for two reasons.
+ *
+ * 1. POINTER CHASING. The CPU doesn't read memory one int at a time; it reads
+ *    a whole CACHE LINE (64 bytes on almost every machine today) into its
+ *    fast cache. An array packs 16 ints into every line it reads. Our `Node`
+ *    holds ONE int per trip to memory, and the CPU can't start fetching the
+ *    next node until it has read the `next` pointer out of this one.
+ * 2. ONE MALLOC PER INT. Every node is a separate malloc() and free(), and
+ *    malloc() adds its own bookkeeping: a 16-byte `Node` really costs 32.
+ *
+ * An UNROLLED LINKED LIST fixes the first problem by storing MANY items in
+ * each node, as a small array. We size the node to be exactly one cache line:
+ * a `next` pointer, a count, and as many ints as fit in the rest (13 on a
+ * 64-bit machine). Walking the list now costs one pointer per 13 items, and
+ * the items inside a node sit side by side, just like an array.
+ *
+ * It keeps the linked list's strength, too: inserting in the middle only
+ * shifts the items of ONE node, never the whole list. If that node is full,
+ * we SPLIT it into two half-full nodes.
+ */
+
+#define CACHE_LINE_SIZE 64
+
+// How many ints fit in a cache line next to the `next` pointer and the count.
+#define ITEMS_PER_NODE ((CACHE_LINE_SIZE - sizeof(void *) - sizeof(int)) / sizeof(int))
+
+typedef struct UnrolledNode
+{
+    struct UnrolledNode *next;
+    int count;                  // How many of `items` are in use.
+    int items[ITEMS_PER_NODE];  // Kept in order, always packed at the front.
+} UnrolledNode;
+
+// A STATIC ASSERTION is checked by the compiler: if a node ever stopped
+// being exactly one cache line, the program would fail to compile.
+_Static_assert(sizeof(UnrolledNode) == CACHE_LINE_SIZE, "An UnrolledNode must fill exactly one cache line.");
+
+/*
+ * The second problem, one malloc() per node, is fixed with a NODE POOL.
+ * Instead of asking malloc() for each node, the pool asks for a SLAB of 64
+ * nodes at once (4 KB, one page of memory) and hands them out one by one.
+ * Deleted nodes aren't freed; they go onto a FREE LIST (a linked list of
+ * spare nodes, linked through their own `next` pointers) and are reused
+ * first. Nodes from the same slab sit next to each other in memory, and
+ * freeing the whole list is one free() per slab instead of one per node.
+ *
+ * aligned_alloc() (C11) gives us slabs that start on a cache-line boundary,
+ * so every node in them fills exactly one line instead of straddling two.
+ */
+
+#define NODES_PER_SLAB 64
+
+typedef struct
+{
+    UnrolledNode *free_list;  // Nodes given back by the list, reused first.
+    UnrolledNode *slabs;      // All slabs, chained through the first node of each.
+    UnrolledNode *next_fresh; // The next never-used node in the newest slab.
+    int fresh_left;           // How many never-used nodes that slab has left.
+    long slab_count;
+} NodePool;
+
+typedef struct
+{
+    UnrolledNode *head;
+    UnrolledNode *tail; // The last node, so appending doesn't walk the list.
+    long size;          // Items, not nodes.
+    NodePool pool;
+} UnrolledList;
+
+/**
+ * @brief Takes a node from the pool: a recycled one if there is one, or a fresh one.
+ */
+UnrolledNode *pool_alloc(NodePool *pool)
+{
+    UnrolledNode *node;
+
+    if (pool->free_list != NULL)
+    {
+        node = pool->free_list;
+        pool->free_list = node->next;
+    }
+    else
+    {
+        if (pool->fresh_left == 0)
+        {
+            UnrolledNode *slab = aligned_alloc(CACHE_LINE_SIZE, NODES_PER_SLAB * sizeof(UnrolledNode));
+            if (slab == NULL)
+            {
+                fprintf(stderr, "Error: Memory allocation failed!\n");
+                exit(1);
+            }
+            // The slab's first node is never handed out: its `next` pointer
+            // chains the slabs together so pool_destroy() can free them.
+            slab[0].next = pool->slabs;
+            pool->slabs = slab;
+            pool->next_fresh = &slab[1];
+            pool->fresh_left = NODES_PER_SLAB - 1;
+            pool->slab_count++;
+        }
+        node = pool->next_fresh++;
+        pool->fresh_left--;
+    }
+
+    node->next = NULL;
+    node->count = 0;
+    return node;
+}
+
+/**
+ * @brief Gives a node back to the pool. No free(): it goes on the free list.
+ */
+void pool_release(NodePool *pool, UnrolledNode *node)
+{
+    node->next = pool->free_list;
+    pool->free_list = node;
+}
+
+/**
+ * @brief Frees every slab, and with them every node the pool ever handed out.
+ */
+void pool_destroy(NodePool *pool)
+{
+    UnrolledNode *oldest = NULL;
+
+    // The chain starts at the newest slab. We reverse it and free the oldest
+    // first: malloc() can then merge each freed slab with the one before it,
+    // instead of returning memory to the operating system after every free().
+    while (pool->slabs != NULL)
+    {
+        UnrolledNode *slab = pool->slabs;
+
+        pool->slabs = slab[0].next;
+        slab[0].next = oldest;
+        oldest = slab;
+    }
+    while (oldest != NULL)
+    {
+        UnrolledNode *slab = oldest;
+
+        oldest = slab[0].next;
+        free(slab);
+    }
+    *pool = (NodePool){0};
+}
+
+/**
+ * @brief Adds `value` at the end of the list.
+ */
+void unrolled_append(UnrolledList *list, int value)
+{
+    // A full tail gets a new node after it. We don't split here: appending
+    // in order should leave every node full, not half full.
+    if (list->tail == NULL || list->tail->count == (int)ITEMS_PER_NODE)
+    {
+        UnrolledNode *node = pool_alloc(&list->pool);
+
+        if (list->tail == NULL)
+        {
+            list->head = node;
+        }
+        else
+        {
+            list->tail->next = node;
+        }
+        list->tail = node;
+    }
+    list->tail->items[list->tail->count++] = value;
+    list->size++;
+}
+
+/**
+ * @brief Finds the node holding item number `*index` of the list.
+ * @param index In: a position in the list (0 to size - 1). Out: the position
+ *              inside the returned node.
+ * @param previous Receives the node before it (NULL for the head).
+ */
+static UnrolledNode *find_node(const UnrolledList *list, long *index, UnrolledNode **previous)
+{
+    UnrolledNode *node = list->head;
+
+    *previous = NULL;
+    // We skip a whole node at a time, so this walk is 13 times shorter.
+    while (*index >= node->count)
+    {
+        *index -= node->count;
+        *previous = node;
+        node = node->next;
+    }
+    return node;
+}
+
+/**
+ * @brief Inserts `value` so that it becomes item number `index` (0 to size).
+ */
+void unrolled_insert(UnrolledList *list, long index, int value)
+{
+    UnrolledNode *previous;
+    UnrolledNode *node;
+
+    if (index >= list->size)
+    {
+        unrolled_append(list, value);
+        return;
+    }
+
+    node = find_node(list, &index, &previous);
+    if (node->count == (int)ITEMS_PER_NODE)
+    {
+        // The node is full: SPLIT it, moving its upper half to a new node.
+        UnrolledNode *new_node = pool_alloc(&list->pool);
+        int half = (int)ITEMS_PER_NODE / 2;
+
+        new_node->count = node->count - half;
+        memcpy(new_node->items, &node->items[half], (size_t)new_node->count * sizeof(int));
+        node->count = half;
+        new_node->next = node->next;
+        node->next = new_node;
+        if (list->tail == node)
+        {
+            list->tail = new_node;
+        }
+        if (index > half)
+        {
+            node = new_node;
+            index -= half;
+        }
+    }
+
+    // Shift the items after `index` up by one, like inserting into an array,
+    // but an array of at most 13 items.
+    memmove(&node->items[index + 1], &node->items[index], (size_t)(node->count - index) * sizeof(int));
+    node->items[index] = value;
+    node->count++;
+    list->size++;
+}
+
+/**
+ * @brief Removes item number `index` (0 to size - 1) and returns it.
+ */
+int unrolled_delete(UnrolledList *list, long index)
+{
+    UnrolledNode *previous;
+    UnrolledNode *node = find_node(list, &index, &previous);
+    UnrolledNode *next = node->next;
+    int value = node->items[index];
+
+    memmove(&node->items[index], &node->items[index + 1], (size_t)(node->count - index - 1) * sizeof(int));
+    node->count--;
+    list->size--;
+
+    if (node->count == 0)
+    {
+        // The node is empty: unlink it and give it back to the pool.
+        if (previous == NULL)
+        {
+            list->head = next;
+        }
+        else
+        {
+            previous->next = next;
+        }
+        if (list->tail == node)
+        {
+            list->tail = previous;
+        }
+        pool_release(&list->pool, node);
+    }
+    else if (node->count < (int)ITEMS_PER_NODE / 2 && next != NULL && node->count + next->count <= (int)ITEMS_PER_NODE)
+    {
+        // A node less than half full is MERGED with the next one when they
+        // fit together, so deletions can't leave a chain of nearly empty nodes.
+        memcpy(&node->items[node->count], next->items, (size_t)next->count * sizeof(int));
+        node->count += next->count;
+        node->next = next->next;
+        if (list->tail == next)
+        {
+            list->tail = node;
+        }
+        pool_release(&list->pool, next);
+    }
+    return value;
+}
+
+/*
+ * To visit every item without caring where the nodes begin and end, we use
+ * an ITERATOR: a small struct that remembers where we are. Each call to
+ * unrolled_next() hands out one item and moves on.
+ */
+typedef struct
+{
+    const UnrolledNode *node;
+    int index;
+} UnrolledIterator;
+
+UnrolledIterator unrolled_begin(const UnrolledList *list)
+{
+    return (UnrolledIterator){list->head, 0};
+}
+
+/**
+ * @brief Stores the next item in `*value`. Returns 0 when there are no more.
+ */
+int unrolled_next(UnrolledIterator *iterator, int *value)
+{
+    while (iterator->node != NULL && iterator->index >= iterator->node->count)
+    {
+        iterator->node = iterator->node->next;
+        iterator->index = 0;
+    }
+    if (iterator->node == NULL)
+    {
+        return 0;
+    }
+    *value = iterator->node->items[iterator->index++];
+    return 1;
+}
+
+/**
+ * @brief Prints the list one node at a time, so you can see how it is packed.
+ */
+void print_unrolled_list(const UnrolledList *list)
+{
+    for (const UnrolledNode *node = list->head; node != NULL; node = node->next)
+    {
+        printf("[");
+        for (int i = 0; i < node->count; i++)
+        {
+            printf(i == 0 ? "%d" : " %d", node->items[i]);
+        }
+        printf("] -> ");
+    }
+    printf("NULL\n");
+}
+
+/**
+ * @brief Frees the whole list. With a pool, that's just freeing the slabs.
+ */
+void free_unrolled_list(UnrolledList *list)
+{
+    pool_destroy(&list->pool);
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+}
+
+// --- Part 4: Measuring the Difference ---
+/*
+ * Run `./20_linked_lists --benchmark 1000000` to race three containers of a
+ * million ints: our one-int-per-node list, the unrolled list, and a plain
+ * DYNAMIC ARRAY (a malloc'd array that doubles in size with realloc() when
+ * it fills up). Each is built, walked from end to end, and then given
+ * inserts at random positions in the middle.
+ *
+ * One caveat makes the simple list look BETTER here than in real programs:
+ * we allocate all its nodes in one go, so malloc() places them one after
+ * another and the CPU can guess where the next one is. In a long-running
+ * program, nodes end up scattered across the heap and the gap grows.
+ */
+
+#define BENCHMARK_INSERTS 1000
+#define BENCHMARK_PASSES 5 // Traversals are timed as the best of several passes.
+
+typedef struct
+{
+    int *items;
+    long count;
+    long capacity;
+} IntArray;
+
+void array_push(IntArray *array, int value)
+{
+    if (array->count == array->capacity)
+    {
+        long new_capacity = array->capacity ? array->capacity * 2 : 16;
+        int *grown = realloc(array->items, (size_t)new_capacity * sizeof(int));
+
+        if (grown == NULL)
+        {
+            fprintf(stderr, "Error: Memory allocation failed!\n");
+            exit(1);
+        }
+        array->items = grown;
+        array->capacity = new_capacity;
+    }
+    array->items[array->count++] = value;
+}
+
+// Inserting into an array shifts EVERY later item up by one.
+void array_insert(IntArray *array, long index, int value)
+{
+    array_push(array, 0); // Make room at the end.
+    memmove(&array->items[index + 1], &array->items[index], (size_t)(array->count - 1 - index) * sizeof(int));
+    array->items[index] = value;
+}
+
+int array_delete(IntArray *array, long index)
+{
+    int value = array->items[index];
+
+    memmove(&array->items[index], &array->items[index + 1], (size_t)(array->count - 1 - index) * sizeof(int));
+    array->count--;
+    return value;
+}
+
+// Inserting into the simple list: walk to the node before `index`, then link.
+void insert_at_position(Node **head_ref, long index, int data)
+{
+    Node *previous = *head_ref;
+    Node *new_node;
+
+    if (index == 0)
+    {
+        insert_at_beginning(head_ref, data);
+        return;
+    }
+    for (long i = 1; i < index; i++)
+    {
+        previous = previous->next;
+    }
+    new_node = create_node(data);
+    new_node->next = previous->next;
+    previous->next = new_node;
+}
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// A tiny random number generator, so every run inserts at the same places.
+static unsigned int next_random(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static long long sum_list(const Node *head)
+{
+    long long sum = 0;
+
+    for (const Node *node = head; node != NULL; node = node->next)
+    {
+        sum += node->data;
+    }
+    return sum;
+}
+
+static long long sum_unrolled(const UnrolledList *list)
+{
+    UnrolledIterator iterator = unrolled_begin(list);
+    long long sum = 0;
+    int value;
+
+    while (unrolled_next(&iterator, &value))
+    {
+        sum += value;
+    }
+    return sum;
+}
+
+static long long sum_array(const IntArray *array)
+{
+    long long sum = 0;
+
+    for (long i = 0; i < array->count; i++)
+    {
+        sum += array->items[i];
+    }
+    return sum;
+}
+
+// Returns 1 if the simple list holds exactly the array's items, in order.
+static int list_matches_array(const Node *head, const IntArray *array)
+{
+    long i = 0;
+
+    for (const Node *node = head; node != NULL; node = node->next)
+    {
+        if (i >= array->count || array->items[i++] != node->data)
+        {
+            return 0;
+        }
+    }
+    return i == array->count;
+}
+
+// Returns 1 if the unrolled list holds exactly the array's items, in order.
+static int unrolled_matches_array(const UnrolledList *list, const IntArray *array)
+{
+    UnrolledIterator iterator = unrolled_begin(list);
+    long i = 0;
+    int value;
+
+    while (unrolled_next(&iterator, &value))
+    {
+        if (i >= array->count || array->items[i++] != value)
+        {
+            return 0;
+        }
+    }
+    return i == array->count && list->size == array->count;
+}
+
+int run_benchmark(long count)
+{
+    Node *head = NULL;
+    UnrolledList unrolled = {0};
+    IntArray array = {0};
+    unsigned int seed = 2025;
+    double start, list_time, unrolled_time, array_time;
+    double best_list = 0, best_unrolled = 0, best_array = 0;
+    long long list_sum = 0, unrolled_sum = 0, array_sum = 0;
+    int ok;
+
+    printf("Benchmarking %ld ints (%d per unrolled node, %d-byte nodes).\n", count, (int)ITEMS_PER_NODE,
+           (int)sizeof(UnrolledNode));
+    printf("%-26s %14s %14s %14s\n", "", "linked list", "unrolled list", "dynamic array");
+
+    // Build: the simple list is filled from the front, so we count down
+    // to end up with the same order as the others.
+    start = now_seconds();
+    for (long i = count - 1; i >= 0; i--)
+    {
+        insert_at_beginning(&head, (int)i);
+    }
+    list_time = now_seconds() - start;
+    start = now_seconds();
+    for (long i = 0; i < count; i++)
+    {
+        unrolled_append(&unrolled, (int)i);
+    }
+    unrolled_time = now_seconds() - start;
+    start = now_seconds();
+    for (long i = 0; i < count; i++)
+    {
+        array_push(&array, (int)i);
+    }
+    array_time = now_seconds() - start;
+    printf("%-26s %14.2f %14.2f %14.2f\n", "Build (ns per int)", list_time * 1e9 / (double)count,
+           unrolled_time * 1e9 / (double)count, array_time * 1e9 / (double)count);
+
+    // Traverse: sum every item.
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++)
+    {
+        start = now_seconds();
+        list_sum = sum_list(head);
+        list_time = now_seconds() - start;
+        start = now_seconds();
+        unrolled_sum = sum_unrolled(&unrolled);
+        unrolled_time = now_seconds() - start;
+        start = now_seconds();
+        array_sum = sum_array(&array);
+        array_time = now_seconds() - start;
+        if (pass == 0 || list_time < best_list)
+        {
+            best_list = list_time;
+        }
+        if (pass == 0 || unrolled_time < best_unrolled)
+        {
+            best_unrolled = unrolled_time;
+        }
+        if (pass == 0 || array_time < best_array)
+        {
+            best_array = array_time;
+        }
+    }
+    printf("%-26s %14.2f %14.2f %14.2f\n", "Traverse (ns per int)", best_list * 1e9 / (double)count,
+           best_unrolled * 1e9 / (double)count, best_array * 1e9 / (double)count);
+
+    // Insert in the middle: the same random positions for all three.
+    list_time = unrolled_time = array_time = 0;
+    for (int i = 0; i < BENCHMARK_INSERTS; i++)
+    {
+        long index = (long)(next_random(&seed) % (unsigned long)(count + i + 1));
+
+        start = now_seconds();
+        insert_at_position(&head, index, -i);
+        list_time += now_seconds() - start;
+        start = now_seconds();
+        unrolled_insert(&unrolled, index, -i);
+        unrolled_time += now_seconds() - start;
+        start = now_seconds();
+        array_insert(&array, index, -i);
+        array_time += now_seconds() - start;
+    }
+    printf("%-26s %14.2f %14.2f %14.2f\n", "Insert (us per insert)", list_time * 1e6 / BENCHMARK_INSERTS,
+           unrolled_time * 1e6 / BENCHMARK_INSERTS, array_time * 1e6 / BENCHMARK_INSERTS);
+
+    // Memory: a Node is 16 bytes, plus what malloc() keeps for each block.
+    printf("%-26s %14.2f %14.2f %14.2f\n", "Memory (bytes per int)", (double)sizeof(Node),
+           (double)unrolled.pool.slab_count * NODES_PER_SLAB * sizeof(UnrolledNode) / (double)unrolled.size,
+           (double)array.capacity * sizeof(int) / (double)array.count);
+
+    // Before freeing anything, make sure all three agree. Then delete the
+    // same random items from the unrolled list and the array, and compare
+    // what's left.
+    ok = list_sum == unrolled_sum && unrolled_sum == array_sum && list_matches_array(head, &array) &&
+         unrolled_matches_array(&unrolled, &array);
+    for (int i = 0; ok && i < BENCHMARK_INSERTS; i++)
+    {
+        long index = (long)(next_random(&seed) % (unsigned long)array.count);
+
+        ok = unrolled_delete(&unrolled, index) == array_delete(&array, index);
+    }
+    ok = ok && unrolled_matches_array(&unrolled, &array);
+
+    // Free: one free() per node, against one per slab, against just one.
+    // (The simple list goes last: when its 32 MB are freed, malloc() hands
+    // that memory back to the operating system, and that takes time too.)
+    start = now_seconds();
+    free_unrolled_list(&unrolled);
+    unrolled_time = now_seconds() - start;
+    start = now_seconds();
+    free_list(&head);
+    list_time = now_seconds() - start;
+    start = now_seconds();
+    free(array.items);
+    array_time = now_seconds() - start;
+    printf("%-26s %14.2f %14.2f %14.2f\n", "Free (ms)", list_time * 1e3, unrolled_time * 1e3, array_time * 1e3);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Error: the unrolled list and the dynamic array disagree!\n");
+        return 1;
+    }
+    printf("All three lists agree, and the unrolled list still matches the array after %d inserts and %d deletes.\n", BENCHMARK_INSERTS,
+           BENCHMARK_INSERTS);
+    return 0;
+}
+
+int main(int argc, char *argv[])
 {
     // The HEAD pointer. This is our only entry point into the list.
     // An empty list is represented by a NULL head pointer.
     Node *head = NULL;
+    UnrolledList unrolled = {0}; // All zeros: no nodes and an empty pool.
+
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        long count = atol(argv[2]);
+
+        if (count < 1 || count > 1000000000L)
+        {
+            fprintf(stderr, "Error: the count must be between 1 and 1000000000.\n");
+            return 1;
+        }
+        return run_benchmark(count);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--benchmark <count>]\n", argv[0]);
+        return 1;
+    }
 
     printf("Building the linked list by inserting at the beginning...\n");
 
@@ -153,6 +810,25 @@ int main(void)
 
     printf("List after freeing:\n");
     print_list(head); // Should print "NULL"
+    printf("\n");
+
+    printf("Now an unrolled list of 1 to 30, %d items per node:\n", (int)ITEMS_PER_NODE);
+    for (int i = 1; i <= 30; i++)
+    {
+        unrolled_append(&unrolled, i);
+    }
+    print_unrolled_list(&unrolled);
+
+    printf("Inserting 100 at position 5 splits the first node:\n");
+    unrolled_insert(&unrolled, 5, 100);
+    print_unrolled_list(&unrolled);
+
+    printf("Deleting the first two items merges the first two nodes again:\n");
+    unrolled_delete(&unrolled, 0);
+    unrolled_delete(&unrolled, 0);
+    print_unrolled_list(&unrolled);
+
+    free_unrolled_list(&unrolled);
 
     return 0;
 }
@@ -174,11 +850,23 @@ int main(void)
  *     single node to prevent memory leaks.
  * 6.  To modify the head pointer from within a function, we must pass its
  *     address (a pointer to a pointer, or `Node **`).
+ * 7.  Memory arrives in CACHE LINES of 64 bytes. A list with one int per node
+ *     uses a few bytes of each line it fetches; an UNROLLED LIST packs a small
+ *     array into every node and uses all of it.
+ * 8.  A NODE POOL replaces a malloc() per node with a malloc() per slab of
+ *     nodes, and recycles deleted nodes through a FREE LIST.
+ * 9.  Measure: `./20_linked_lists --benchmark 1000000` compares both lists
+ *     with a plain dynamic array, which is often the best choice of all.
  *
  * You have just built one of the most fundamental data structures in all of
  * computer science. Understanding linked lists is key to tackling more complex
  * structures like trees, graphs, and hash tables.
  *
+ * Two more files continue this lesson. `20_skip_list.c` keeps the list
+ * sorted and adds express lanes, making it a fast ordered map. When you have
+ * met threads (Lesson 30), `20_lock_free_lists.c` shares the list between
+ * threads without any locks.
+ *
  * HOW TO COMPILE AND RUN THIS CODE:
  *
  * 1. Open a terminal or command prompt.
@@ -188,4 +876,7 @@ int main(void)
  * 4. Run the executable:
  *    - On Linux/macOS:   `./20_linked_lists`
  *    - On Windows:       `20_linked_lists.exe`
+ * 5. Race the lists against each other (add -O2 when compiling, for numbers
+ *    that mean something):
+ *    `./20_linked_lists --benchmark 1000000`
  */
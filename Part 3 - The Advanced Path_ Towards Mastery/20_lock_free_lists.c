@@ -0,0 +1,888 @@
+/**
+ * @file 20_lock_free_lists.c
+ * @brief Part 3, Lesson 20 (continued): Lock-Free Stacks and Queues
+ * @author dunamismax
+ * @date 10-18-2026
+ *
+ * This file continues the linked list lesson. It turns the `Node` list into
+ * containers that many threads can share without locks: a lock-free stack,
+ * a lock-free queue, and a bounded ring for one producer and one consumer.
+ */
+
+/*
+ * =====================================================================================
+ * |                                   - LESSON START -                                  |
+ * =====================================================================================
+ *
+ * A common job for threads is passing WORK ITEMS to each other: one thread
+ * reads requests, others handle them. The items need a shared container, and
+ * a linked list is the natural choice: adding and removing at the ends is
+ * just a matter of moving a pointer or two.
+ *
+ * The list from Lesson 20 is not safe to share, though. If two threads run
+ * insert_at_beginning() at once, both can read the same old `head`, and one
+ * of the two new nodes is lost: the RACE CONDITION of Lesson 30. The usual
+ * fix is a MUTEX around every operation. That works, but only one thread
+ * can touch the list at a time, and a thread that is paused by the operating
+ * system while holding the lock stops all the others.
+ *
+ * LOCK-FREE containers avoid locks entirely. They are built on ATOMIC
+ * operations (C11's <stdatomic.h>), which the CPU performs as one indivisible
+ * step, and above all on COMPARE-AND-SWAP (CAS):
+ *
+ *     atomic_compare_exchange_weak(&head, &expected, desired)
+ *
+ * means "if `head` still equals `expected`, set it to `desired` and return
+ * true; otherwise copy its current value into `expected` and return false".
+ * A lock-free operation reads the shared state, prepares its change, and
+ * uses a CAS to publish it, trying again if another thread got there first.
+ * Some thread always succeeds, so the container as a whole always makes
+ * progress, even if one thread is paused halfway.
+ *
+ * This lesson needs threads: compile it with `-pthread`.
+ */
+
+#include <pthread.h>
+#include <sched.h>     // For sched_yield()
+#include <stdatomic.h> // For atomic types, atomic_load() and compare-and-swap
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>      // For timespec_get(), to time the benchmark
+
+#define MAX_THREADS 16
+#define CACHE_LINE_SIZE 64
+
+// --- Part 1: The Shared Node ---
+
+// Lesson 20's Node, with one change: `next` is ATOMIC, because one thread
+// may read it while another writes it.
+typedef struct WorkNode
+{
+    int data;
+    _Atomic(struct WorkNode *) next;
+} WorkNode;
+
+WorkNode *create_node(int data)
+{
+    WorkNode *new_node = malloc(sizeof(WorkNode));
+
+    if (new_node == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        exit(1);
+    }
+    new_node->data = data;
+    atomic_init(&new_node->next, NULL);
+    return new_node;
+}
+
+// --- Part 2: Freeing Nodes Safely - Hazard Pointers ---
+/*
+ * Without locks there is a new danger. Thread A reads the stack's top node
+ * and is about to read `top->next`. Meanwhile thread B pops that same node
+ * and free()s it. When A continues, it reads freed memory. Worse, malloc()
+ * may hand the same address out again for a new node, and A's CAS, which
+ * only compares addresses, succeeds when it shouldn't (the "ABA problem").
+ *
+ * HAZARD POINTERS fix both. Before using a shared node, a thread publishes
+ * its address in one of its hazard slots: "I'm using this, don't free it".
+ * A thread that removes a node doesn't free it right away; it RETIRES it
+ * onto a private list. Now and then it scans every thread's hazard slots and
+ * frees only the retired nodes nobody has published. A node can't be freed,
+ * nor its address reused, while anyone might still look at it.
+ *
+ * Every thread gets a number from 0 to MAX_THREADS - 1 and its own record.
+ * `_Alignas` puts each record on its own cache line, so threads writing their
+ * own hazard slots don't slow each other down ("false sharing").
+ */
+
+#define HAZARDS_PER_THREAD 2
+// Scan once this many nodes are retired. It's twice the number of hazard
+// slots, so every scan frees at least half of them.
+#define RETIRE_LIMIT (2 * MAX_THREADS * HAZARDS_PER_THREAD)
+
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) _Atomic(WorkNode *) hazards[HAZARDS_PER_THREAD];
+    WorkNode *retired[RETIRE_LIMIT]; // Only ever touched by the owning thread.
+    int retired_count;
+} ThreadRecord;
+
+ThreadRecord g_threads[MAX_THREADS]; // Globals start as all zeros: no hazards.
+
+/**
+ * @brief Reads the node pointer in `source` and protects it with a hazard slot.
+ *
+ * Publishing the hazard takes a moment, and the node may be removed in that
+ * moment. So we read `source` again: if it still holds the same node, the
+ * node was in place when our hazard became visible, and it is now safe.
+ */
+WorkNode *protect(_Atomic(WorkNode *) *source, int thread, int slot)
+{
+    WorkNode *node = atomic_load(source);
+
+    for (;;)
+    {
+        WorkNode *again;
+
+        atomic_store(&g_threads[thread].hazards[slot], node);
+        again = atomic_load(source);
+        if (again == node)
+        {
+            return node;
+        }
+        node = again;
+    }
+}
+
+void clear_hazards(int thread)
+{
+    for (int slot = 0; slot < HAZARDS_PER_THREAD; slot++)
+    {
+        atomic_store(&g_threads[thread].hazards[slot], NULL);
+    }
+}
+
+static int is_hazardous(const WorkNode *node, WorkNode *const *hazards, int hazard_count)
+{
+    for (int i = 0; i < hazard_count; i++)
+    {
+        if (hazards[i] == node)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Frees `node` once no thread can be using it.
+ */
+void retire_node(int thread, WorkNode *node)
+{
+    ThreadRecord *record = &g_threads[thread];
+    WorkNode *hazards[MAX_THREADS * HAZARDS_PER_THREAD];
+    int hazard_count = 0;
+    int kept = 0;
+
+    record->retired[record->retired_count++] = node;
+    if (record->retired_count < RETIRE_LIMIT)
+    {
+        return;
+    }
+
+    // The scan. First take a snapshot of every hazard slot: reading them
+    // once is much cheaper than reading them all again for every node.
+    for (int other = 0; other < MAX_THREADS; other++)
+    {
+        for (int slot = 0; slot < HAZARDS_PER_THREAD; slot++)
+        {
+            WorkNode *hazard = atomic_load(&g_threads[other].hazards[slot]);
+
+            if (hazard != NULL)
+            {
+                hazards[hazard_count++] = hazard;
+            }
+        }
+    }
+
+    // Then free what's safe, and keep the rest for next time.
+    for (int i = 0; i < record->retired_count; i++)
+    {
+        if (is_hazardous(record->retired[i], hazards, hazard_count))
+        {
+            record->retired[kept++] = record->retired[i];
+        }
+        else
+        {
+            free(record->retired[i]);
+        }
+    }
+    record->retired_count = kept;
+}
+
+/**
+ * @brief Frees every retired node. Only call this when no other thread is running.
+ */
+void free_retired_nodes(void)
+{
+    for (int thread = 0; thread < MAX_THREADS; thread++)
+    {
+        for (int i = 0; i < g_threads[thread].retired_count; i++)
+        {
+            free(g_threads[thread].retired[i]);
+        }
+        g_threads[thread].retired_count = 0;
+    }
+}
+
+// --- Part 3: The Lock-Free Stack (Treiber Stack) ---
+/*
+ * Lesson 20's insert_at_beginning() is already most of a stack: push adds a
+ * node at the head, and pop takes it off again. The lock-free version, known
+ * as a TREIBER STACK, does each with a CAS on the head pointer ("top"):
+ *
+ * - push: point the new node at the current top, then CAS top from that
+ *   node to ours. If another thread changed top in between, the CAS fails,
+ *   we point our node at the new top, and try again.
+ * - pop: read top (protected by a hazard pointer), read its `next`, then CAS
+ *   top from the node to its next.
+ */
+
+typedef struct
+{
+    _Atomic(WorkNode *) top;
+} LockFreeStack;
+
+void stack_push(LockFreeStack *stack, int data)
+{
+    WorkNode *new_node = create_node(data);
+    WorkNode *top = atomic_load(&stack->top);
+
+    do
+    {
+        atomic_store(&new_node->next, top);
+        // On failure, the CAS loads the current top into `top` for us.
+    } while (!atomic_compare_exchange_weak(&stack->top, &top, new_node));
+}
+
+/**
+ * @brief Pops the top item into `*data`. Returns 0 if the stack was empty.
+ */
+int stack_pop(LockFreeStack *stack, int thread, int *data)
+{
+    for (;;)
+    {
+        WorkNode *top = protect(&stack->top, thread, 0);
+        WorkNode *next;
+
+        if (top == NULL)
+        {
+            clear_hazards(thread);
+            return 0;
+        }
+        next = atomic_load(&top->next); // Safe: our hazard keeps `top` alive.
+        if (atomic_compare_exchange_weak(&stack->top, &top, next))
+        {
+            *data = top->data;
+            clear_hazards(thread);
+            retire_node(thread, top);
+            return 1;
+        }
+    }
+}
+
+// --- Part 4: The Lock-Free Queue (Michael-Scott Queue) ---
+/*
+ * A queue is first in, first out: we add at the TAIL and remove at the HEAD,
+ * so two pointers are shared instead of one. The MICHAEL-SCOTT QUEUE keeps a
+ * DUMMY node at the head, so the queue is never truly empty and the head and
+ * tail never have to change together. The item at the front of the queue
+ * lives in the node AFTER the dummy; dequeuing it makes its node the new
+ * dummy.
+ *
+ * Enqueuing takes two steps: link the new node after the last one (a CAS on
+ * its `next`), then swing `tail` to it (a CAS on `tail`). Another thread can
+ * see the queue between the two steps, with `tail` one node behind. Instead
+ * of waiting, it HELPS: it swings `tail` forward itself and carries on. That
+ * helping is what keeps the queue lock-free: no thread ever waits for
+ * another to finish.
+ *
+ * This is an MPMC queue: Multiple Producers and Multiple Consumers may use
+ * it at once.
+ */
+
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) _Atomic(WorkNode *) head; // Consumers work here...
+    _Alignas(CACHE_LINE_SIZE) _Atomic(WorkNode *) tail; // ...and producers here.
+} LockFreeQueue;
+
+void queue_init(LockFreeQueue *queue)
+{
+    WorkNode *dummy = create_node(0);
+
+    atomic_init(&queue->head, dummy);
+    atomic_init(&queue->tail, dummy);
+}
+
+void queue_enqueue(LockFreeQueue *queue, int thread, int data)
+{
+    WorkNode *new_node = create_node(data);
+
+    for (;;)
+    {
+        WorkNode *tail = protect(&queue->tail, thread, 0);
+        WorkNode *next = atomic_load(&tail->next);
+
+        if (next != NULL)
+        {
+            // `tail` is lagging behind: help it along, then try again.
+            atomic_compare_exchange_weak(&queue->tail, &tail, next);
+            continue;
+        }
+        if (atomic_compare_exchange_weak(&tail->next, &next, new_node))
+        {
+            // Linked in. Swinging `tail` may fail if someone helped already.
+            atomic_compare_exchange_strong(&queue->tail, &tail, new_node);
+            clear_hazards(thread);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Dequeues the front item into `*data`. Returns 0 if the queue was empty.
+ */
+int queue_dequeue(LockFreeQueue *queue, int thread, int *data)
+{
+    for (;;)
+    {
+        WorkNode *head = protect(&queue->head, thread, 0);
+        WorkNode *tail = atomic_load(&queue->tail);
+        WorkNode *next = protect(&head->next, thread, 1);
+
+        // If `head` moved on while we protected `next`, `next` may already
+        // be retired. Start over.
+        if (head != atomic_load(&queue->head))
+        {
+            continue;
+        }
+        if (next == NULL)
+        {
+            clear_hazards(thread);
+            return 0; // Only the dummy is left.
+        }
+        if (head == tail)
+        {
+            // An enqueue is halfway done: help it, as enqueue does.
+            atomic_compare_exchange_weak(&queue->tail, &tail, next);
+            continue;
+        }
+        *data = next->data; // Read before the CAS: afterwards `next` is the dummy.
+        if (atomic_compare_exchange_weak(&queue->head, &head, next))
+        {
+            clear_hazards(thread);
+            retire_node(thread, head);
+            return 1;
+        }
+    }
+}
+
+/**
+ * @brief Frees every node still in the queue. Only call it when no other thread uses the queue.
+ */
+void queue_destroy(LockFreeQueue *queue)
+{
+    WorkNode *node = atomic_load(&queue->head);
+
+    while (node != NULL)
+    {
+        WorkNode *next = atomic_load(&node->next);
+
+        free(node);
+        node = next;
+    }
+}
+
+// --- Part 5: The SPSC Ring Buffer ---
+/*
+ * The queue above allocates a node for every item and needs CAS loops
+ * because any thread may show up at either end. Very often, though, exactly
+ * ONE thread produces and ONE thread consumes (SPSC). Then we can do much
+ * better with a fixed-size RING BUFFER: an array plus two counters. Only the
+ * producer writes `tail` and only the consumer writes `head`, so there is
+ * nothing to race on, and no CAS at all.
+ *
+ * What we do need is ORDERING. The producer writes the item and THEN
+ * advances `tail`; the consumer must never see the new `tail` before the
+ * item itself. The atomics elsewhere in this file use C's default, strictest
+ * ordering ("sequentially consistent"). Here we ask for exactly what we need:
+ * a RELEASE store of `tail` makes every earlier write visible to any thread
+ * that reads `tail` with an ACQUIRE load. It's cheaper, and on x86 it costs
+ * nothing extra at all.
+ *
+ * The counters only ever grow; `counter % RING_CAPACITY` is the slot. With a
+ * power-of-two capacity that is just `counter & (RING_CAPACITY - 1)`.
+ */
+
+#define RING_CAPACITY 1024
+
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head; // The next item to consume.
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail; // The next free slot.
+    _Alignas(CACHE_LINE_SIZE) int items[RING_CAPACITY];
+} SpscRing;
+
+/**
+ * @brief Adds an item. Only the producer thread may call this. Returns 0 if the ring is full.
+ */
+int ring_push(SpscRing *ring, int data)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed); // Ours: no ordering needed.
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head == RING_CAPACITY)
+    {
+        return 0;
+    }
+    ring->items[tail & (RING_CAPACITY - 1)] = data;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release); // Publish the item.
+    return 1;
+}
+
+/**
+ * @brief Takes an item. Only the consumer thread may call this. Returns 0 if the ring is empty.
+ */
+int ring_pop(SpscRing *ring, int *data)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return 0;
+    }
+    *data = ring->items[head & (RING_CAPACITY - 1)];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release); // Hand the slot back.
+    return 1;
+}
+
+// --- Part 6: The Contention Benchmark ---
+/*
+ * `./20_lock_free_lists --benchmark 200000` has 1, 2, 4 and 8 threads hammer
+ * each container at once. Every thread does pairs of operations, push then
+ * pop (or enqueue then dequeue), so they all fight over the same pointers.
+ * As a baseline, the same work goes through Lesson 20's list guarded by a
+ * mutex. Then one producer and one consumer pass items through the ring and
+ * through the queue.
+ *
+ * Results depend heavily on the machine: on one CPU the threads take turns
+ * and never truly collide, while on many cores the mutex queues threads up
+ * and the cache line holding `top` bounces between cores.
+ */
+
+// Lesson 20's list with a lock: the simple, safe way to share it.
+typedef struct Node
+{
+    int data;
+    struct Node *next;
+} Node;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    Node *head;
+} LockedStack;
+
+void locked_push(LockedStack *stack, int data)
+{
+    Node *new_node = malloc(sizeof(Node));
+
+    if (new_node == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        exit(1);
+    }
+    new_node->data = data;
+    pthread_mutex_lock(&stack->lock);
+    new_node->next = stack->head; // insert_at_beginning(), inside the lock.
+    stack->head = new_node;
+    pthread_mutex_unlock(&stack->lock);
+}
+
+int locked_pop(LockedStack *stack, int *data)
+{
+    Node *top;
+
+    pthread_mutex_lock(&stack->lock);
+    top = stack->head;
+    if (top != NULL)
+    {
+        stack->head = top->next;
+    }
+    pthread_mutex_unlock(&stack->lock);
+
+    if (top == NULL)
+    {
+        return 0;
+    }
+    *data = top->data;
+    free(top);
+    return 1;
+}
+
+typedef enum
+{
+    LOCKED_STACK,
+    LOCK_FREE_STACK,
+    LOCK_FREE_QUEUE
+} Container;
+
+// Everything one benchmark thread needs to know, and what it reports back.
+typedef struct
+{
+    int thread;
+    long pairs;
+    Container container;
+    LockedStack *locked_stack;
+    LockFreeStack *stack;
+    LockFreeQueue *queue;
+    long long pushed_sum;
+    long long popped_sum;
+} PairsWork;
+
+// A START GATE: threads wait here until all of them exist, so they start
+// the race together and thread creation isn't part of the timing.
+pthread_mutex_t g_gate_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t g_gate_open = PTHREAD_COND_INITIALIZER;
+int g_gate_is_open = 0;
+
+static void wait_at_gate(void)
+{
+    pthread_mutex_lock(&g_gate_lock);
+    while (!g_gate_is_open)
+    {
+        pthread_cond_wait(&g_gate_open, &g_gate_lock);
+    }
+    pthread_mutex_unlock(&g_gate_lock);
+}
+
+static void set_gate(int open)
+{
+    pthread_mutex_lock(&g_gate_lock);
+    g_gate_is_open = open;
+    pthread_cond_broadcast(&g_gate_open);
+    pthread_mutex_unlock(&g_gate_lock);
+}
+
+void *run_pairs(void *arg)
+{
+    PairsWork *work = arg;
+
+    wait_at_gate();
+    for (long i = 0; i < work->pairs; i++)
+    {
+        int data = (int)(work->thread * work->pairs + i);
+        int popped = 0;
+        int got = 0;
+
+        switch (work->container)
+        {
+        case LOCKED_STACK:
+            locked_push(work->locked_stack, data);
+            got = locked_pop(work->locked_stack, &popped);
+            break;
+        case LOCK_FREE_STACK:
+            stack_push(work->stack, data);
+            got = stack_pop(work->stack, work->thread, &popped);
+            break;
+        case LOCK_FREE_QUEUE:
+            queue_enqueue(work->queue, work->thread, data);
+            got = queue_dequeue(work->queue, work->thread, &popped);
+            break;
+        }
+        work->pushed_sum += data;
+        if (got)
+        {
+            work->popped_sum += popped;
+        }
+    }
+    return NULL;
+}
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Runs the pairs workload on `thread_count` threads.
+ * @return Millions of operations per second, or -1 if an item went missing.
+ */
+double benchmark_pairs(Container container, int thread_count, long pairs)
+{
+    LockedStack locked_stack = {.head = NULL};
+    LockFreeStack stack;
+    LockFreeQueue queue;
+    PairsWork work[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    long long pushed = 0, popped = 0;
+    double start, elapsed;
+    int data;
+
+    pthread_mutex_init(&locked_stack.lock, NULL);
+    atomic_init(&stack.top, NULL);
+    queue_init(&queue);
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        work[i] = (PairsWork){i, pairs, container, &locked_stack, &stack, &queue, 0, 0};
+        if (pthread_create(&threads[i], NULL, run_pairs, &work[i]) != 0)
+        {
+            fprintf(stderr, "Error: could not start a thread.\n");
+            exit(1);
+        }
+    }
+    start = now_seconds();
+    set_gate(1);
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_join(threads[i], NULL);
+        pushed += work[i].pushed_sum;
+        popped += work[i].popped_sum;
+    }
+    elapsed = now_seconds() - start;
+    set_gate(0);
+
+    // Every pushed item must have been popped by some thread, or still be
+    // in the container. (Thread 0's hazard slots are free again by now.)
+    while (locked_pop(&locked_stack, &data) || stack_pop(&stack, 0, &data) || queue_dequeue(&queue, 0, &data))
+    {
+        popped += data;
+    }
+    pthread_mutex_destroy(&locked_stack.lock);
+    queue_destroy(&queue);
+    free_retired_nodes();
+
+    if (pushed != popped)
+    {
+        return -1;
+    }
+    return (double)thread_count * (double)pairs * 2 / elapsed / 1e6;
+}
+
+typedef struct
+{
+    SpscRing *ring;       // Either the ring...
+    LockFreeQueue *queue; // ...or the queue.
+    long items;
+    int in_order;
+} SpscWork;
+
+void *run_producer(void *arg)
+{
+    SpscWork *work = arg;
+
+    wait_at_gate();
+    for (long i = 0; i < work->items; i++)
+    {
+        if (work->ring != NULL)
+        {
+            while (!ring_push(work->ring, (int)i))
+            {
+                sched_yield(); // Full: let the consumer run.
+            }
+        }
+        else
+        {
+            queue_enqueue(work->queue, 0, (int)i);
+        }
+    }
+    return NULL;
+}
+
+void *run_consumer(void *arg)
+{
+    SpscWork *work = arg;
+    long expected = 0;
+    int data;
+
+    wait_at_gate();
+    work->in_order = 1;
+    while (expected < work->items)
+    {
+        int got = work->ring != NULL ? ring_pop(work->ring, &data) : queue_dequeue(work->queue, 1, &data);
+
+        if (!got)
+        {
+            sched_yield(); // Empty: let the producer run.
+            continue;
+        }
+        if (data != expected)
+        {
+            work->in_order = 0;
+        }
+        expected++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Passes `items` items from one thread to another.
+ * @return Millions of items per second, or -1 if they arrived out of order.
+ */
+double benchmark_spsc(int use_ring, long items)
+{
+    static SpscRing ring; // 4 KB of items: static, rather than on the stack.
+    LockFreeQueue queue;
+    SpscWork work = {use_ring ? &ring : NULL, use_ring ? NULL : &queue, items, 0};
+    pthread_t producer, consumer;
+    double start, elapsed;
+
+    atomic_init(&ring.head, 0);
+    atomic_init(&ring.tail, 0);
+    queue_init(&queue);
+
+    if (pthread_create(&producer, NULL, run_producer, &work) != 0 ||
+        pthread_create(&consumer, NULL, run_consumer, &work) != 0)
+    {
+        fprintf(stderr, "Error: could not start a thread.\n");
+        exit(1);
+    }
+    start = now_seconds();
+    set_gate(1);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    elapsed = now_seconds() - start;
+    set_gate(0);
+
+    queue_destroy(&queue);
+    free_retired_nodes();
+    return work.in_order ? (double)items / elapsed / 1e6 : -1;
+}
+
+int run_benchmark(long pairs)
+{
+    const int thread_counts[] = {1, 2, 4, 8};
+    const char *names[] = {"mutex + list", "Treiber stack", "Michael-Scott queue"};
+    double ring_rate, queue_rate;
+
+    printf("Pairs of operations per thread: %ld. Results in millions of operations per second.\n", pairs);
+    printf("%-8s %16s %16s %20s\n", "threads", names[0], names[1], names[2]);
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+    {
+        double rates[3];
+
+        for (int container = LOCKED_STACK; container <= LOCK_FREE_QUEUE; container++)
+        {
+            rates[container] = benchmark_pairs((Container)container, thread_counts[t], pairs);
+            if (rates[container] < 0)
+            {
+                fprintf(stderr, "Error: the %s lost items with %d threads!\n", names[container], thread_counts[t]);
+                return 1;
+            }
+        }
+        printf("%-8d %16.2f %16.2f %20.2f\n", thread_counts[t], rates[0], rates[1], rates[2]);
+    }
+
+    ring_rate = benchmark_spsc(1, pairs * 4);
+    queue_rate = benchmark_spsc(0, pairs * 4);
+    if (ring_rate < 0 || queue_rate < 0)
+    {
+        fprintf(stderr, "Error: items arrived out of order!\n");
+        return 1;
+    }
+    printf("One producer, one consumer, %ld items: SPSC ring %.2f, Michael-Scott queue %.2f million items/s.\n",
+           pairs * 4, ring_rate, queue_rate);
+    printf("Every item was accounted for.\n");
+    return 0;
+}
+
+// --- Part 7: A Small Demonstration ---
+
+int main(int argc, char *argv[])
+{
+    LockFreeStack stack;
+    LockFreeQueue queue;
+    static SpscRing ring;
+    int data;
+
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        long pairs = atol(argv[2]);
+
+        if (pairs < 1 || pairs > 100000000L)
+        {
+            fprintf(stderr, "Error: the count must be between 1 and 100000000.\n");
+            return 1;
+        }
+        return run_benchmark(pairs);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--benchmark <pairs per thread>]\n", argv[0]);
+        return 1;
+    }
+
+    // Used from one thread, each container behaves like its plain version.
+    // We are "thread 0" for the hazard pointers.
+    atomic_init(&stack.top, NULL);
+    queue_init(&queue);
+    for (int i = 1; i <= 5; i++)
+    {
+        stack_push(&stack, i * 10);
+        queue_enqueue(&queue, 0, i * 10);
+        ring_push(&ring, i * 10);
+    }
+
+    printf("Pushed and enqueued 10, 20, 30, 40, 50.\n");
+    printf("The stack gives them back last in, first out:   ");
+    while (stack_pop(&stack, 0, &data))
+    {
+        printf("%d ", data);
+    }
+    printf("\nThe queue gives them back first in, first out:  ");
+    while (queue_dequeue(&queue, 0, &data))
+    {
+        printf("%d ", data);
+    }
+    printf("\nSo does the ring:                               ");
+    while (ring_pop(&ring, &data))
+    {
+        printf("%d ", data);
+    }
+    printf("\n\nNow 4 threads at once (see --benchmark for more):\n");
+
+    for (int container = LOCK_FREE_STACK; container <= LOCK_FREE_QUEUE; container++)
+    {
+        double rate = benchmark_pairs((Container)container, 4, 10000);
+
+        printf("%s: %s\n", container == LOCK_FREE_STACK ? "Treiber stack" : "Michael-Scott queue",
+               rate < 0 ? "an item went MISSING!" : "40000 pushes and pops, nothing lost.");
+    }
+
+    queue_destroy(&queue);
+    free_retired_nodes();
+    return 0;
+}
+
+/*
+ * =====================================================================================
+ * |                                    - LESSON END -                                   |
+ * =====================================================================================
+ *
+ * Key Takeaways:
+ *
+ * 1.  ATOMIC operations happen as one indivisible step. COMPARE-AND-SWAP
+ *     changes a value only if it still holds what we expect, and is the
+ *     building block of lock-free code.
+ * 2.  A LOCK-FREE operation prepares its change, publishes it with a CAS, and
+ *     retries if another thread won. Some thread always makes progress.
+ * 3.  The TREIBER STACK is Lesson 20's insert_at_beginning() with a CAS on
+ *     the head. The MICHAEL-SCOTT QUEUE adds a dummy node and has threads
+ *     HELP each other finish half-done enqueues.
+ * 4.  In a lock-free structure you can't just free() a removed node: another
+ *     thread may still be reading it. HAZARD POINTERS let threads announce
+ *     which nodes they are using, and removed nodes are freed only when no
+ *     one has announced them.
+ * 5.  With one producer and one consumer, a RING BUFFER needs no CAS at all,
+ *     just ACQUIRE and RELEASE ordering on its two counters.
+ * 6.  Lock-free is not automatically faster. Measure with `--benchmark`: a
+ *     mutex is hard to beat when threads rarely collide.
+ *
+ * HOW TO COMPILE AND RUN THIS CODE:
+ *
+ * 1. Compile the program (threads need the `-pthread` flag):
+ *    `gcc -Wall -Wextra -std=c11 -pthread -o 20_lock_free_lists 20_lock_free_lists.c`
+ * 2. Run the demonstration:
+ *    `./20_lock_free_lists`
+ * 3. Run the contention benchmark (add -O2 when compiling, for numbers that
+ *    mean something):
+ *    `./20_lock_free_lists --benchmark 200000`
+ */
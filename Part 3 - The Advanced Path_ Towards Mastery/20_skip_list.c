@@ -0,0 +1,992 @@
+/**
+ * @file 20_skip_list.c
+ * @brief Part 3, Lesson 20 (continued): Skip Lists
+ * @author dunamismax
+ * @date 10-18-2026
+ *
+ * This file continues the linked list lesson. It grows the `Node` list into
+ * a SKIP LIST: an ordered map with fast search, insert, delete and range
+ * queries, whose lookups can run in many threads at once.
+ */
+
+/*
+ * =====================================================================================
+ * |                                   - LESSON START -                                  |
+ * =====================================================================================
+ *
+ * Keep Lesson 20's list SORTED, and it becomes an ordered map: walk from the
+ * head to find a key, insert a new node after the last smaller one, and read
+ * a range of keys by walking from the first one. Everything is in order, and
+ * inserting never moves other items around the way a sorted array does.
+ *
+ * But finding anything means walking the list one node at a time: a million
+ * keys, half a million steps on average. A SKIP LIST adds EXPRESS LANES:
+ *
+ *   Level 2: head -------------------------> 40 -------------------------------> NULL
+ *   Level 1: head -------> 20 -------------> 40 -> 50 -------> 70 -------------> NULL
+ *   Level 0: head -> 10 -> 20 -> 30 -> 35 -> 40 -> 50 -> 60 -> 70 -> 80 -> 90 -> NULL
+ *
+ * Level 0 is our plain sorted list. Each level above it skips over some of
+ * the nodes below. To search, start on the top lane and go right while the
+ * next key is smaller than the one we want; then drop down a level and do
+ * it again. Each lane carries about a quarter of the nodes of the one below,
+ * so we skip ahead by bigger and bigger jumps: about log(n) steps in all,
+ * like a binary search, but on a linked list.
+ *
+ * Which lanes does a node join? We flip coins! Every node is on level 0;
+ * with probability 1/4 it is also on level 1; with 1/4 of that on level 2;
+ * and so on. No rebalancing is ever needed (compare with a balanced tree),
+ * and on average each node carries only 1.33 `next` pointers.
+ *
+ * This lesson needs threads for its benchmark: compile it with `-pthread`.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h> // For the pointers that readers share with the writer
+#include <stddef.h>    // For max_align_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>      // For timespec_get(), to time the benchmark
+
+#define MAX_LEVEL 16 // With 1/4 per level, enough lanes for billions of keys.
+
+// --- Part 1: The Node and Its Tower ---
+/*
+ * A node's `next` pointers form its TOWER: one pointer per level it is on.
+ * Towers have different heights, so `next` is a FLEXIBLE ARRAY MEMBER: the
+ * struct ends with an array of unspecified size, and we allocate as much
+ * room after the struct as this node's tower needs.
+ *
+ * The pointers are ATOMIC because of Part 4: lookups may follow them while
+ * another thread is changing them.
+ */
+typedef struct SkipNode
+{
+    int key;
+    _Atomic int value; // Replacing a value may happen while someone reads it.
+    int level;         // How many `next` pointers this node has.
+    _Atomic(struct SkipNode *) next[];
+} SkipNode;
+
+// --- Part 2: The Arena ---
+/*
+ * A skip list with millions of keys means millions of small nodes. Instead
+ * of a malloc() for each one, we take memory from an ARENA: a big block from
+ * which we hand out pieces just by moving an offset forward. When a block
+ * runs out we chain on another. Allocating is a few instructions, the nodes
+ * sit packed together in memory, and freeing the whole map is one free()
+ * per megabyte.
+ *
+ * The catch: an arena can't free a single node. A deleted node stays in the
+ * arena until the whole map is destroyed. As we'll see in Part 4, that is
+ * exactly what makes lock-free reading safe. (A map with endless deletes
+ * would need a way to reclaim them, like the hazard pointers of
+ * `20_lock_free_lists.c`.)
+ */
+#define ARENA_BLOCK_SIZE (1024 * 1024)
+
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *previous;
+    size_t used;
+    _Alignas(max_align_t) unsigned char data[ARENA_BLOCK_SIZE];
+} ArenaBlock;
+
+typedef struct
+{
+    ArenaBlock *current;
+    size_t blocks;
+} Arena;
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    void *memory;
+
+    // Round up, so the next piece is also aligned for a SkipNode.
+    size = (size + _Alignof(SkipNode) - 1) / _Alignof(SkipNode) * _Alignof(SkipNode);
+
+    if (arena->current == NULL || arena->current->used + size > ARENA_BLOCK_SIZE)
+    {
+        ArenaBlock *block = malloc(sizeof(ArenaBlock));
+
+        if (block == NULL)
+        {
+            fprintf(stderr, "Error: Memory allocation failed!\n");
+            exit(1);
+        }
+        block->previous = arena->current;
+        block->used = 0;
+        arena->current = block;
+        arena->blocks++;
+    }
+
+    memory = &arena->current->data[arena->current->used];
+    arena->current->used += size;
+    return memory;
+}
+
+void arena_free(Arena *arena)
+{
+    while (arena->current != NULL)
+    {
+        ArenaBlock *previous = arena->current->previous;
+
+        free(arena->current);
+        arena->current = previous;
+    }
+    arena->blocks = 0;
+}
+
+// --- Part 3: The Skip List ---
+
+typedef struct
+{
+    SkipNode *head;      // A node with no key and a full-height tower.
+    _Atomic int level;   // How many levels are in use right now.
+    long count;
+    unsigned int random; // The state of our coin-flipping random numbers.
+    Arena arena;
+    pthread_mutex_t write_lock; // Taken by insert and delete (see Part 4).
+} SkipList;
+
+static SkipNode *new_node(SkipList *list, int key, int value, int level)
+{
+    SkipNode *node = arena_alloc(&list->arena, sizeof(SkipNode) + (size_t)level * sizeof(node->next[0]));
+
+    node->key = key;
+    atomic_init(&node->value, value);
+    node->level = level;
+    for (int i = 0; i < level; i++)
+    {
+        atomic_init(&node->next[i], NULL);
+    }
+    return node;
+}
+
+void skiplist_init(SkipList *list)
+{
+    list->arena = (Arena){NULL, 0};
+    list->head = new_node(list, 0, 0, MAX_LEVEL);
+    atomic_init(&list->level, 1);
+    list->count = 0;
+    list->random = 98; // Any nonzero start works. This one gives the demo a nice shape.
+    pthread_mutex_init(&list->write_lock, NULL);
+}
+
+void skiplist_destroy(SkipList *list)
+{
+    arena_free(&list->arena); // Every node at once.
+    pthread_mutex_destroy(&list->write_lock);
+}
+
+// Flips coins: each extra level has a 1 in 4 chance.
+static int random_level(SkipList *list)
+{
+    int level = 1;
+
+    // XORSHIFT: a tiny, fast random number generator.
+    list->random ^= list->random << 13;
+    list->random ^= list->random >> 17;
+    list->random ^= list->random << 5;
+    for (unsigned int bits = list->random; level < MAX_LEVEL && (bits & 3) == 0; bits >>= 2)
+    {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief The heart of the skip list: finds the first node whose key is >= `key`.
+ * @param before If not NULL, receives the last node before that point on
+ *               every level: the nodes whose pointers an insert or delete
+ *               has to change.
+ */
+static SkipNode *find_greater_or_equal(const SkipList *list, int key, SkipNode **before)
+{
+    SkipNode *node = list->head;
+    SkipNode *next = NULL;
+
+    for (int level = atomic_load(&list->level) - 1; level >= 0; level--)
+    {
+        next = atomic_load_explicit(&node->next[level], memory_order_acquire);
+        // Go right while the next key is smaller...
+        while (next != NULL && next->key < key)
+        {
+            node = next;
+            next = atomic_load_explicit(&node->next[level], memory_order_acquire);
+        }
+        // ...then drop down a level.
+        if (before != NULL)
+        {
+            before[level] = node;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Looks `key` up. Returns 1 and stores its value in `*value` if it's there.
+ */
+int skiplist_search(const SkipList *list, int key, int *value)
+{
+    SkipNode *node = find_greater_or_equal(list, key, NULL);
+
+    if (node == NULL || node->key != key)
+    {
+        return 0;
+    }
+    *value = atomic_load(&node->value);
+    return 1;
+}
+
+/**
+ * @brief Adds `key` with `value`, or replaces its value. Returns 1 if the key is new.
+ */
+int skiplist_insert(SkipList *list, int key, int value)
+{
+    SkipNode *before[MAX_LEVEL];
+    SkipNode *found;
+    SkipNode *node;
+    int level, current_level;
+
+    pthread_mutex_lock(&list->write_lock);
+    found = find_greater_or_equal(list, key, before);
+    if (found != NULL && found->key == key)
+    {
+        atomic_store(&found->value, value);
+        pthread_mutex_unlock(&list->write_lock);
+        return 0;
+    }
+
+    level = random_level(list);
+    current_level = atomic_load(&list->level);
+    for (int i = current_level; i < level; i++)
+    {
+        before[i] = list->head; // New lanes start at the head.
+    }
+
+    // Fill in the new node completely, tower and all...
+    node = new_node(list, key, value, level);
+    for (int i = 0; i < level; i++)
+    {
+        atomic_store_explicit(&node->next[i], atomic_load(&before[i]->next[i]), memory_order_relaxed);
+    }
+    // ...and only then link it in, bottom level first. This is
+    // insert_at_beginning() from Lesson 20, done once per level, with
+    // `before[i]->next[i]` playing the part of `head`.
+    for (int i = 0; i < level; i++)
+    {
+        atomic_store_explicit(&before[i]->next[i], node, memory_order_release);
+    }
+    if (level > current_level)
+    {
+        atomic_store(&list->level, level);
+    }
+
+    list->count++;
+    pthread_mutex_unlock(&list->write_lock);
+    return 1;
+}
+
+/**
+ * @brief Removes `key`. Returns 1 if it was there.
+ */
+int skiplist_delete(SkipList *list, int key)
+{
+    SkipNode *before[MAX_LEVEL];
+    SkipNode *found;
+    int level;
+
+    pthread_mutex_lock(&list->write_lock);
+    found = find_greater_or_equal(list, key, before);
+    if (found == NULL || found->key != key)
+    {
+        pthread_mutex_unlock(&list->write_lock);
+        return 0;
+    }
+
+    // Unlink it from the top down. We don't touch the node's own pointers:
+    // a reader standing on it can still carry on to the rest of the list.
+    for (int i = found->level - 1; i >= 0; i--)
+    {
+        atomic_store_explicit(&before[i]->next[i], atomic_load(&found->next[i]), memory_order_release);
+    }
+
+    // Lanes that are now empty are dropped.
+    level = atomic_load(&list->level);
+    while (level > 1 && atomic_load(&list->head->next[level - 1]) == NULL)
+    {
+        level--;
+    }
+    atomic_store(&list->level, level);
+
+    list->count--;
+    pthread_mutex_unlock(&list->write_lock);
+    return 1;
+}
+
+/*
+ * RANGE QUERIES are where a skip list beats a hash table. Find the first key
+ * of the range with a normal search, then just walk level 0, which is a plain
+ * sorted linked list: every key comes out in order.
+ */
+typedef struct
+{
+    const SkipNode *node;
+} SkipIterator;
+
+// Returns an iterator positioned at the first key >= `key`.
+SkipIterator skiplist_seek(const SkipList *list, int key)
+{
+    return (SkipIterator){find_greater_or_equal(list, key, NULL)};
+}
+
+/**
+ * @brief Stores the next key and value, and moves on. Returns 0 at the end of the list.
+ */
+int skiplist_next(SkipIterator *iterator, int *key, int *value)
+{
+    if (iterator->node == NULL)
+    {
+        return 0;
+    }
+    *key = iterator->node->key;
+    *value = atomic_load(&iterator->node->value);
+    iterator->node = atomic_load_explicit(&iterator->node->next[0], memory_order_acquire);
+    return 1;
+}
+
+// Prints every lane, so you can see the express lanes of a small list.
+void print_skiplist(const SkipList *list)
+{
+    for (int level = atomic_load(&list->level) - 1; level >= 0; level--)
+    {
+        const SkipNode *lane = atomic_load(&list->head->next[level]);
+
+        printf("Level %d: head", level);
+        // Walk level 0, printing each key if it is on this lane, dashes if not.
+        for (const SkipNode *node = atomic_load(&list->head->next[0]); node != NULL;
+             node = atomic_load(&node->next[0]))
+        {
+            if (node == lane)
+            {
+                printf(" -> %2d", node->key);
+                lane = atomic_load(&node->next[level]);
+            }
+            else
+            {
+                printf(" ------");
+            }
+        }
+        printf(" -> NULL\n");
+    }
+}
+
+// --- Part 4: Reading While Another Thread Writes ---
+/*
+ * A map is usually read far more often than it is changed. So we let any
+ * number of threads SEARCH and ITERATE without taking any lock at all, while
+ * inserts and deletes take `write_lock` and so happen one at a time. Three
+ * things make the lock-free reads safe:
+ *
+ * 1. An insert fills in the new node completely BEFORE linking it in, and
+ *    links it with a RELEASE store; readers follow pointers with ACQUIRE
+ *    loads. A reader that finds the node therefore sees it fully built.
+ * 2. A delete only unlinks a node; it never changes the node's own `next`
+ *    pointers. A reader standing on a deleted node still finds its way to
+ *    the rest of the list.
+ * 3. Deleted nodes are never freed (Part 2's arena keeps them until the map
+ *    is destroyed), so no reader can ever follow a pointer into freed memory.
+ *
+ * A reader may miss a key inserted while it was searching, or still find one
+ * being deleted: it sees the map as it was a moment before.
+ */
+
+// --- Part 5: Measuring It ---
+/*
+ * `./20_skip_list --benchmark 2000000` fills a skip list, a SORTED ARRAY and
+ * a HASH TABLE with the same keys and times what each is good at:
+ *
+ * - The sorted array is built all at once with qsort(), searched with a
+ *   binary search, and reads a range as one contiguous run of memory. But
+ *   inserting or deleting one key shifts everything after it.
+ * - The hash table (open addressing with linear probing, like libcore's, but
+ *   with int keys) finds a key in about one step, but keeps no order: to read
+ *   a range it would have to look at every key it holds.
+ * - The skip list does everything in O(log n), and lets readers in while a
+ *   writer works.
+ *
+ * Keys are even numbers, shuffled. Odd numbers are "new" keys for the
+ * insert and delete tests. Each key's value is the key plus one.
+ */
+
+#define EXTRA_KEYS 1000
+#define RANGE_QUERIES 1000
+#define RANGE_KEYS 100 // Keys per range query.
+
+typedef struct
+{
+    int key;
+    int value;
+} Pair;
+
+typedef struct
+{
+    Pair *pairs;
+    long count;
+} SortedArray;
+
+static int compare_pairs(const void *a, const void *b)
+{
+    const Pair *left = a;
+    const Pair *right = b;
+
+    return (left->key > right->key) - (left->key < right->key);
+}
+
+// Returns the index of the first pair whose key is >= `key`.
+static long lower_bound(const SortedArray *array, int key)
+{
+    long low = 0;
+    long high = array->count;
+
+    while (low < high)
+    {
+        long middle = low + (high - low) / 2;
+
+        if (array->pairs[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// The array was allocated with room for the extra keys, so this never grows it.
+static void array_insert(SortedArray *array, int key, int value)
+{
+    long index = lower_bound(array, key);
+
+    memmove(&array->pairs[index + 1], &array->pairs[index], (size_t)(array->count - index) * sizeof(Pair));
+    array->pairs[index] = (Pair){key, value};
+    array->count++;
+}
+
+static void array_delete(SortedArray *array, int key)
+{
+    long index = lower_bound(array, key);
+
+    if (index < array->count && array->pairs[index].key == key)
+    {
+        memmove(&array->pairs[index], &array->pairs[index + 1], (size_t)(array->count - index - 1) * sizeof(Pair));
+        array->count--;
+    }
+}
+
+#define HASH_EMPTY (-1) // Our keys are never negative.
+
+typedef struct
+{
+    Pair *slots;
+    long capacity; // A power of two.
+    long count;
+} IntHashTable;
+
+static long hash_slot(const IntHashTable *table, int key)
+{
+    // FIBONACCI HASHING: multiply by 2^32 / golden ratio, keep the top bits.
+    return (long)(((unsigned int)key * 2654435769u) >> 7) & (table->capacity - 1);
+}
+
+static void hash_init(IntHashTable *table, long capacity)
+{
+    table->slots = malloc((size_t)capacity * sizeof(Pair));
+    if (table->slots == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        exit(1);
+    }
+    for (long i = 0; i < capacity; i++)
+    {
+        table->slots[i].key = HASH_EMPTY;
+    }
+    table->capacity = capacity;
+    table->count = 0;
+}
+
+static void hash_put(IntHashTable *table, int key, int value);
+
+static void hash_grow(IntHashTable *table)
+{
+    IntHashTable bigger;
+
+    hash_init(&bigger, table->capacity * 2);
+    for (long i = 0; i < table->capacity; i++)
+    {
+        if (table->slots[i].key != HASH_EMPTY)
+        {
+            hash_put(&bigger, table->slots[i].key, table->slots[i].value);
+        }
+    }
+    free(table->slots);
+    *table = bigger;
+}
+
+static void hash_put(IntHashTable *table, int key, int value)
+{
+    long i;
+
+    if ((table->count + 1) * 4 > table->capacity * 3)
+    {
+        hash_grow(table);
+    }
+    for (i = hash_slot(table, key); table->slots[i].key != HASH_EMPTY; i = (i + 1) & (table->capacity - 1))
+    {
+        if (table->slots[i].key == key)
+        {
+            table->slots[i].value = value;
+            return;
+        }
+    }
+    table->slots[i] = (Pair){key, value};
+    table->count++;
+}
+
+static int hash_get(const IntHashTable *table, int key, int *value)
+{
+    for (long i = hash_slot(table, key); table->slots[i].key != HASH_EMPTY; i = (i + 1) & (table->capacity - 1))
+    {
+        if (table->slots[i].key == key)
+        {
+            *value = table->slots[i].value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Deleting with linear probing moves later entries back into the gap
+// ("backward shift"), exactly as libcore's core_table_remove() does.
+static void hash_delete(IntHashTable *table, int key)
+{
+    long mask = table->capacity - 1;
+    long hole = hash_slot(table, key);
+
+    while (table->slots[hole].key != key)
+    {
+        if (table->slots[hole].key == HASH_EMPTY)
+        {
+            return;
+        }
+        hole = (hole + 1) & mask;
+    }
+    table->slots[hole].key = HASH_EMPTY;
+    table->count--;
+
+    for (long i = (hole + 1) & mask; table->slots[i].key != HASH_EMPTY; i = (i + 1) & mask)
+    {
+        long home = hash_slot(table, table->slots[i].key);
+
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            table->slots[hole] = table->slots[i];
+            table->slots[i].key = HASH_EMPTY;
+            hole = i;
+        }
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static unsigned int next_random(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 4;
+}
+
+// The keys 0, 2, 4, ... in a random order (a FISHER-YATES shuffle).
+static int *shuffled_even_keys(long count, unsigned int *seed)
+{
+    int *keys = malloc((size_t)count * sizeof(int));
+
+    if (keys == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        exit(1);
+    }
+    for (long i = 0; i < count; i++)
+    {
+        keys[i] = (int)(i * 2);
+    }
+    for (long i = count - 1; i > 0; i--)
+    {
+        long j = (long)(next_random(seed) % (unsigned int)(i + 1));
+        int swap = keys[i];
+
+        keys[i] = keys[j];
+        keys[j] = swap;
+    }
+    return keys;
+}
+
+// One reader thread for the concurrent test: it looks up keys that the
+// writer never touches, so every single lookup must succeed.
+typedef struct
+{
+    const SkipList *list;
+    const int *keys;
+    long key_count;
+    atomic_int *stop;
+    long lookups;
+    long errors;
+    double seconds;
+} ReaderWork;
+
+void *run_reader(void *arg)
+{
+    ReaderWork *work = arg;
+    double start = now_seconds();
+    long i = 0;
+
+    while (!atomic_load(work->stop))
+    {
+        // A batch between checks of the stop flag.
+        for (int batch = 0; batch < 256; batch++, i++)
+        {
+            int key = work->keys[i % work->key_count];
+            int value;
+
+            if (!skiplist_search(work->list, key, &value) || value != key + 1)
+            {
+                work->errors++;
+            }
+        }
+    }
+    work->lookups = i;
+    work->seconds = now_seconds() - start;
+    return NULL;
+}
+
+/**
+ * @brief Runs `readers` reader threads while this thread inserts and deletes odd keys.
+ * @return 1 if every reader found every key it looked for.
+ */
+static int benchmark_concurrent(SkipList *list, const int *keys, long count, int readers, long writes)
+{
+    ReaderWork work[8];
+    pthread_t threads[8];
+    atomic_int stop;
+    double start, write_seconds, read_rate = 0;
+    long errors = 0;
+
+    atomic_init(&stop, 0);
+    for (int r = 0; r < readers; r++)
+    {
+        // Each reader starts at a different place in the key list.
+        work[r] = (ReaderWork){list, keys + (count / readers) * r, count - (count / readers) * r, &stop, 0, 0, 0};
+        if (pthread_create(&threads[r], NULL, run_reader, &work[r]) != 0)
+        {
+            fprintf(stderr, "Error: could not start a thread.\n");
+            exit(1);
+        }
+    }
+
+    start = now_seconds();
+    for (long i = 0; i < writes; i++)
+    {
+        int key = (int)((i / 2) % count) * 2 + 1; // Odd: not one the readers look for.
+
+        if (i % 2 == 0)
+        {
+            skiplist_insert(list, key, key + 1);
+        }
+        else
+        {
+            skiplist_delete(list, key);
+        }
+    }
+    write_seconds = now_seconds() - start;
+    atomic_store(&stop, 1);
+
+    for (int r = 0; r < readers; r++)
+    {
+        pthread_join(threads[r], NULL);
+        errors += work[r].errors;
+        read_rate += (double)work[r].lookups / work[r].seconds;
+    }
+    printf("  %d reader%s: %7.2f M lookups/s while the writer did %7.2f K inserts and deletes/s\n", readers,
+           readers == 1 ? " " : "s", read_rate / 1e6, (double)writes / write_seconds / 1e3);
+    return errors == 0;
+}
+
+int run_benchmark(long count)
+{
+    unsigned int seed = 2025;
+    int *keys = shuffled_even_keys(count, &seed);
+    SkipList list;
+    SortedArray array;
+    IntHashTable table;
+    long long skip_sum = 0, array_sum = 0, hash_sum = 0;
+    double start, skip_time, array_time, hash_time;
+    int ok = 1;
+
+    printf("Benchmarking %ld keys, inserted in random order.\n", count);
+    printf("%-28s %12s %14s %12s\n", "", "skip list", "sorted array", "hash table");
+
+    // Insert everything. The array is filled and then sorted in one go.
+    start = now_seconds();
+    skiplist_init(&list);
+    for (long i = 0; i < count; i++)
+    {
+        skiplist_insert(&list, keys[i], keys[i] + 1);
+    }
+    skip_time = now_seconds() - start;
+    start = now_seconds();
+    array.pairs = malloc((size_t)(count + EXTRA_KEYS) * sizeof(Pair));
+    if (array.pairs == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        exit(1);
+    }
+    for (long i = 0; i < count; i++)
+    {
+        array.pairs[i] = (Pair){keys[i], keys[i] + 1};
+    }
+    array.count = count;
+    qsort(array.pairs, (size_t)count, sizeof(Pair), compare_pairs);
+    array_time = now_seconds() - start;
+    start = now_seconds();
+    hash_init(&table, 16);
+    for (long i = 0; i < count; i++)
+    {
+        hash_put(&table, keys[i], keys[i] + 1);
+    }
+    hash_time = now_seconds() - start;
+    printf("%-28s %12.1f %14.1f %12.1f\n", "Build (ns per key)", skip_time * 1e9 / (double)count,
+           array_time * 1e9 / (double)count, hash_time * 1e9 / (double)count);
+
+    // Look every key up, in a different random order.
+    for (long i = count - 1; i > 0; i--)
+    {
+        long j = (long)(next_random(&seed) % (unsigned int)(i + 1));
+        int swap = keys[i];
+
+        keys[i] = keys[j];
+        keys[j] = swap;
+    }
+    start = now_seconds();
+    for (long i = 0; i < count; i++)
+    {
+        int value = 0;
+
+        skiplist_search(&list, keys[i], &value);
+        skip_sum += value;
+    }
+    skip_time = now_seconds() - start;
+    start = now_seconds();
+    for (long i = 0; i < count; i++)
+    {
+        long index = lower_bound(&array, keys[i]);
+
+        array_sum += index < array.count && array.pairs[index].key == keys[i] ? array.pairs[index].value : 0;
+    }
+    array_time = now_seconds() - start;
+    start = now_seconds();
+    for (long i = 0; i < count; i++)
+    {
+        int value = 0;
+
+        hash_get(&table, keys[i], &value);
+        hash_sum += value;
+    }
+    hash_time = now_seconds() - start;
+    ok = ok && skip_sum == array_sum && array_sum == hash_sum;
+    printf("%-28s %12.1f %14.1f %12.1f\n", "Lookup (ns per key)", skip_time * 1e9 / (double)count,
+           array_time * 1e9 / (double)count, hash_time * 1e9 / (double)count);
+
+    // Range queries: RANGE_KEYS keys starting from a random key.
+    skip_sum = array_sum = 0;
+    start = now_seconds();
+    for (int q = 0; q < RANGE_QUERIES; q++)
+    {
+        SkipIterator iterator = skiplist_seek(&list, keys[q]);
+        int key, value;
+
+        for (int n = 0; n < RANGE_KEYS && skiplist_next(&iterator, &key, &value); n++)
+        {
+            skip_sum += value;
+        }
+    }
+    skip_time = now_seconds() - start;
+    start = now_seconds();
+    for (int q = 0; q < RANGE_QUERIES; q++)
+    {
+        for (long i = lower_bound(&array, keys[q]), n = 0; n < RANGE_KEYS && i < array.count; i++, n++)
+        {
+            array_sum += array.pairs[i].value;
+        }
+    }
+    array_time = now_seconds() - start;
+    ok = ok && skip_sum == array_sum;
+    printf("%-28s %12.2f %14.2f %12s\n", "Range of 100 keys (us)", skip_time * 1e6 / RANGE_QUERIES,
+           array_time * 1e6 / RANGE_QUERIES, "no order");
+
+    // Inserting and deleting in a structure that is already full.
+    start = now_seconds();
+    for (int i = 0; i < EXTRA_KEYS; i++)
+    {
+        skiplist_insert(&list, keys[i] + 1, keys[i] + 2);
+    }
+    for (int i = 0; i < EXTRA_KEYS; i++)
+    {
+        skiplist_delete(&list, keys[i] + 1);
+    }
+    skip_time = now_seconds() - start;
+    start = now_seconds();
+    for (int i = 0; i < EXTRA_KEYS; i++)
+    {
+        array_insert(&array, keys[i] + 1, keys[i] + 2);
+    }
+    for (int i = 0; i < EXTRA_KEYS; i++)
+    {
+        array_delete(&array, keys[i] + 1);
+    }
+    array_time = now_seconds() - start;
+    start = now_seconds();
+    for (int i = 0; i < EXTRA_KEYS; i++)
+    {
+        hash_put(&table, keys[i] + 1, keys[i] + 2);
+    }
+    for (int i = 0; i < EXTRA_KEYS; i++)
+    {
+        hash_delete(&table, keys[i] + 1);
+    }
+    hash_time = now_seconds() - start;
+    ok = ok && list.count == count && array.count == count && table.count == count;
+    printf("%-28s %12.2f %14.2f %12.2f\n", "Insert + delete (us per key)", skip_time * 1e6 / EXTRA_KEYS,
+           array_time * 1e6 / EXTRA_KEYS, hash_time * 1e6 / EXTRA_KEYS);
+
+    printf("%-28s %12.1f %14.1f %12.1f\n", "Memory (bytes per key)",
+           (double)list.arena.blocks * sizeof(ArenaBlock) / (double)count,
+           (double)(count + EXTRA_KEYS) * sizeof(Pair) / (double)count,
+           (double)table.capacity * sizeof(Pair) / (double)count);
+
+    printf("Lock-free lookups of the original keys while one thread inserts and deletes others:\n");
+    for (int readers = 1; ok && readers <= 4; readers *= 2)
+    {
+        ok = benchmark_concurrent(&list, keys, count, readers, 200000);
+    }
+
+    skiplist_destroy(&list);
+    free(array.pairs);
+    free(table.slots);
+    free(keys);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Error: the skip list, the sorted array and the hash table disagree!\n");
+        return 1;
+    }
+    printf("All three maps agreed, and no reader ever missed a key.\n");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    SkipList list;
+    SkipIterator iterator;
+    const int keys[] = {50, 20, 80, 10, 60, 30, 90, 40, 70, 35};
+    int key, value;
+
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        long count = atol(argv[2]);
+
+        // Keys go up to 2 * count, and must fit in an int.
+        if (count < RANGE_QUERIES || count > 500000000L)
+        {
+            fprintf(stderr, "Error: the key count must be between %d and 500000000.\n", RANGE_QUERIES);
+            return 1;
+        }
+        return run_benchmark(count);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--benchmark <keys>]\n", argv[0]);
+        return 1;
+    }
+
+    skiplist_init(&list);
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+    {
+        skiplist_insert(&list, keys[i], keys[i] * 100);
+    }
+    printf("A skip list of %ld keys, in order on every level:\n", list.count);
+    print_skiplist(&list);
+
+    printf("\nSearching for 60: ");
+    if (skiplist_search(&list, 60, &value))
+    {
+        printf("found, value %d\n", value);
+    }
+    printf("Searching for 65: %s\n", skiplist_search(&list, 65, &value) ? "found" : "not found");
+
+    printf("\nDeleting 40 and 80:\n");
+    skiplist_delete(&list, 40);
+    skiplist_delete(&list, 80);
+    print_skiplist(&list);
+
+    printf("\nThe keys from 25 up to (not including) 70:");
+    iterator = skiplist_seek(&list, 25);
+    while (skiplist_next(&iterator, &key, &value) && key < 70)
+    {
+        printf(" %d", key);
+    }
+    printf("\n");
+
+    skiplist_destroy(&list);
+    return 0;
+}
+
+/*
+ * =====================================================================================
+ * |                                    - LESSON END -                                   |
+ * =====================================================================================
+ *
+ * Key Takeaways:
+ *
+ * 1.  A SKIP LIST is a sorted linked list with EXPRESS LANES. Searching goes
+ *     right along a lane, then down a level, for about log(n) steps.
+ * 2.  A node's height is chosen by coin flips, so the list stays balanced
+ *     on average without any rebalancing.
+ * 3.  Level 0 is a plain sorted list, so RANGE QUERIES are a search followed
+ *     by a walk: something a hash table can't do.
+ * 4.  A FLEXIBLE ARRAY MEMBER lets each node carry a tower of its own height,
+ *     and an ARENA allocates those nodes with almost no overhead.
+ * 5.  Building a node completely before publishing it with a RELEASE store,
+ *     and never freeing unlinked nodes, lets readers search with no lock
+ *     while a writer changes the map.
+ * 6.  Each structure has its strengths: run `--benchmark` and compare lookups,
+ *     ranges and updates before you choose.
+ *
+ * HOW TO COMPILE AND RUN THIS CODE:
+ *
+ * 1. Compile the program (the benchmark uses threads, so add `-pthread`):
+ *    `gcc -Wall -Wextra -std=c11 -pthread -o 20_skip_list 20_skip_list.c`
+ * 2. Run the demonstration:
+ *    `./20_skip_list`
+ * 3. Run the benchmark (add -O2 when compiling, for numbers that mean
+ *    something):
+ *    `./20_skip_list --benchmark 2000000`
+ */
@@ -185,6 +185,14 @@ int main(void)
  *
  * This is a low-level but essential skill for any serious C programmer.
  *
+ * Three more files continue this lesson. `21_bitsets.c` scales the flag
+ * byte up to bitsets of billions of bits, combined with SIMD instructions,
+ * and to compressed Roaring bitmaps for sparse sets.
+ * `21_probabilistic_sketches.c` builds Bloom filters, count-min sketches and
+ * HyperLogLog from bits, masks and hashes. `21_integer_compression.c` packs
+ * lists of numbers into as few bits as they need, with varints, bit-packing
+ * and delta encoding.
+ *
  * HOW TO COMPILE AND RUN THIS CODE:
  *
  * 1. Open a terminal or command prompt.
@@ -0,0 +1,1632 @@
+/**
+ * @file 21_bitsets.c
+ * @brief Part 3, Lesson 21 (continued): Bitsets and Bitmap Indexes
+ * @author dunamismax
+ * @date 10-18-2026
+ *
+ * This file continues the bit manipulation lesson. It grows the flag byte
+ * into a BITSET of any size, with fast set operations, counting and
+ * iteration, and a compressed ROARING BITMAP for sparse sets.
+ */
+
+/*
+ * =====================================================================================
+ * |                                   - LESSON START -                                  |
+ * =====================================================================================
+ *
+ * Lesson 21 kept eight flags in one `uint8_t`. The same idea scales to
+ * millions or billions of flags: give every user, row or page a number, and
+ * keep one BIT per number in a long array of 64-bit words. That array is a
+ * BITSET (or BITMAP). Bit `i` lives in word `i / 64`, at position `i % 64`.
+ *
+ * A BITMAP INDEX keeps one bitset per property:
+ *
+ *   active:     1 1 0 1 1 1 0 1 ...   (bit i = "user i logged in this month")
+ *   in_europe:  0 1 1 1 0 1 0 0 ...
+ *   premium:    0 0 0 1 0 1 0 0 ...
+ *
+ * "Active users in Europe without premium" is then
+ * `active & in_europe & ~premium`, worked out 64 users per instruction, and
+ * with SIMD even 128 or 256 users per instruction. Databases and search
+ * engines use exactly this to filter rows.
+ *
+ * This lesson builds:
+ * - a BITSET with set, clear and test (the same masks as Lesson 21);
+ * - COUNTING and FINDING set bits a whole word at a time;
+ * - AND, OR, XOR and ANDNOT over whole bitsets, a byte at a time, a word at
+ *   a time, and with SIMD instructions;
+ * - a ROARING BITMAP, which stores sparse sets in far less memory.
+ *
+ * `./21_bitsets --benchmark 1000000000` measures all of them.
+ */
+
+#include <stdint.h> // For uint64_t and friends
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>   // For timespec_get(), to time the benchmark
+
+/*
+ * SIMD (Single Instruction, Multiple Data) instructions work on a whole
+ * VECTOR REGISTER at once: 128 bits with SSE2 (every x86-64 CPU has it),
+ * 256 bits with AVX2 (most CPUs since 2013, but only used when you compile
+ * with `-mavx2` or `-march=native`). The compiler tells us which ones it may
+ * use by defining macros such as __AVX2__ and __SSE2__. `#if` (Lesson 22)
+ * picks the widest, and the program falls back to plain 64-bit words on any
+ * other CPU.
+ *
+ * The `_mm..._si...` functions are INTRINSICS: C functions that the compiler
+ * turns into one instruction each. We hide them behind a few short names.
+ */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_NAME "AVX2, 256-bit"
+#define SIMD_WORDS 4 // 64-bit words per vector
+#define simd_load(address) _mm256_load_si256((const __m256i *)(address))
+#define simd_store(address, vector) _mm256_store_si256((__m256i *)(address), (vector))
+#define simd_and(x, y) _mm256_and_si256((x), (y))
+#define simd_or(x, y) _mm256_or_si256((x), (y))
+#define simd_xor(x, y) _mm256_xor_si256((x), (y))
+#define simd_andnot(x, y) _mm256_andnot_si256((y), (x)) // The instruction computes ~first & second.
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_NAME "SSE2, 128-bit"
+#define SIMD_WORDS 2
+#define simd_load(address) _mm_load_si128((const __m128i *)(address))
+#define simd_store(address, vector) _mm_store_si128((__m128i *)(address), (vector))
+#define simd_and(x, y) _mm_and_si128((x), (y))
+#define simd_or(x, y) _mm_or_si128((x), (y))
+#define simd_xor(x, y) _mm_xor_si128((x), (y))
+#define simd_andnot(x, y) _mm_andnot_si128((y), (x))
+#else
+#define SIMD_NAME "none, 64-bit words"
+#endif
+
+// --- Part 1: The Bitset ---
+/*
+ * The words come from aligned_alloc(), on a 64-byte boundary (the size of a
+ * cache line), and we round their number up to a multiple of 8 words (64
+ * bytes). Then every SIMD loop below can use ALIGNED loads and never needs a
+ * leftover loop for the last few words.
+ *
+ * The padding bits past `bit_count` are always 0. AND, OR, XOR and ANDNOT of
+ * zeros give zero, so they stay that way, and counting can include them.
+ */
+#define BITS_PER_WORD 64
+#define WORD_ALIGNMENT 64             // Bytes: one cache line, and enough for any vector.
+#define BITSET_NONE SIZE_MAX           // "No set bit found".
+
+typedef struct
+{
+    uint64_t *words;
+    size_t bit_count;
+    size_t word_count; // A multiple of 8, including the padding.
+} Bitset;
+
+int bitset_init(Bitset *set, size_t bit_count)
+{
+    size_t word_count = (bit_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    word_count = (word_count + 7) / 8 * 8;
+    if (word_count == 0)
+    {
+        word_count = 8; // aligned_alloc(..., 0) is not guaranteed to work.
+    }
+
+    set->words = aligned_alloc(WORD_ALIGNMENT, word_count * sizeof(uint64_t));
+    if (set->words == NULL)
+    {
+        return 0;
+    }
+    memset(set->words, 0, word_count * sizeof(uint64_t));
+    set->bit_count = bit_count;
+    set->word_count = word_count;
+    return 1;
+}
+
+void bitset_free(Bitset *set)
+{
+    free(set->words);
+    set->words = NULL;
+    set->bit_count = set->word_count = 0;
+}
+
+// The three operations of Lesson 21, on bit `bit % 64` of word `bit / 64`.
+void bitset_set(Bitset *set, size_t bit)
+{
+    set->words[bit / BITS_PER_WORD] |= UINT64_C(1) << (bit % BITS_PER_WORD);
+}
+
+void bitset_clear(Bitset *set, size_t bit)
+{
+    set->words[bit / BITS_PER_WORD] &= ~(UINT64_C(1) << (bit % BITS_PER_WORD));
+}
+
+int bitset_test(const Bitset *set, size_t bit)
+{
+    return (int)((set->words[bit / BITS_PER_WORD] >> (bit % BITS_PER_WORD)) & 1);
+}
+
+// --- Part 2: Counting and Finding Bits ---
+/*
+ * POPULATION COUNT ("popcount") is the number of 1 bits in a word. Checking
+ * the 64 bits one by one is slow. The portable version below adds bits up
+ * in parallel inside the word ("SWAR", SIMD Within A Register): first pairs
+ * of bits, then groups of 4, then bytes, and a multiplication adds the 8
+ * byte counts together into the top byte.
+ *
+ * Most CPUs also have a POPCNT instruction that does it in one step. GCC and
+ * Clang offer it as __builtin_popcountll(). Be careful: unless you compile
+ * with `-mpopcnt` or `-march=native`, the compiler can't assume your CPU has
+ * the instruction, and the builtin becomes a slower library call.
+ */
+int popcount_portable(uint64_t word)
+{
+    word = word - ((word >> 1) & UINT64_C(0x5555555555555555));                           // 2-bit counts
+    word = (word & UINT64_C(0x3333333333333333)) + ((word >> 2) & UINT64_C(0x3333333333333333)); // 4-bit counts
+    word = (word + (word >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);                               // Byte counts
+    return (int)((word * UINT64_C(0x0101010101010101)) >> 56);                                // Sum of the bytes
+}
+
+static inline int popcount(uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    return popcount_portable(word);
+#endif
+}
+
+/*
+ * The index of the lowest 1 bit ("count trailing zeros"). Only call it with
+ * a word that isn't 0. The portable version uses a neat trick:
+ * `word ^ (word - 1)` has ones from bit 0 up to and including the lowest
+ * set bit, so after dropping one of them, their count is the index.
+ */
+static inline int lowest_set_bit(uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    return popcount_portable((word ^ (word - 1)) >> 1);
+#endif
+}
+
+size_t count_bits(const uint64_t *words, size_t word_count)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < word_count; i++)
+    {
+        total += (size_t)popcount(words[i]);
+    }
+    return total;
+}
+
+size_t bitset_count(const Bitset *set)
+{
+    return count_bits(set->words, set->word_count);
+}
+
+#if defined(__AVX2__)
+/*
+ * Popcount for a whole vector, without any POPCNT instruction. A 16-entry
+ * table holds the bit count of every 4-bit value (a "nibble"). The SHUFFLE
+ * instruction looks up 32 bytes in that table at once, so two lookups (low
+ * and high nibbles) count the bits of 32 bytes. SAD ("sum of absolute
+ * differences" against zero) then adds each group of 8 byte counts into a
+ * 64-bit total. `word_count` must be a multiple of 4.
+ */
+size_t count_bits_avx2(const uint64_t *words, size_t word_count)
+{
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1,
+                                           2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+    __m256i totals = _mm256_setzero_si256();
+    uint64_t lanes[4];
+
+    for (size_t i = 0; i < word_count; i += 4)
+    {
+        __m256i vector = _mm256_load_si256((const __m256i *)(words + i));
+        __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(vector, low_nibbles));
+        __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(vector, 4), low_nibbles));
+
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, totals);
+    return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+#endif
+
+/*
+ * Returns the first set bit at or after `from`, or BITSET_NONE. Instead of
+ * testing bits one by one, we skip whole words of zeros, and find the bit
+ * within a word with lowest_set_bit(). In a sparse bitset that is up to 64
+ * times fewer steps. The usual loop over all set bits is:
+ *
+ *   for (size_t i = bitset_next_set(set, 0); i != BITSET_NONE; i = bitset_next_set(set, i + 1))
+ */
+size_t bitset_next_set(const Bitset *set, size_t from)
+{
+    size_t index = from / BITS_PER_WORD;
+    uint64_t word;
+
+    if (from >= set->bit_count)
+    {
+        return BITSET_NONE;
+    }
+
+    // Ignore the bits below `from` in its own word.
+    word = set->words[index] & (~UINT64_C(0) << (from % BITS_PER_WORD));
+    while (word == 0)
+    {
+        if (++index == set->word_count)
+        {
+            return BITSET_NONE;
+        }
+        word = set->words[index];
+    }
+    return index * BITS_PER_WORD + (size_t)lowest_set_bit(word); // Padding bits are 0, so this is < bit_count.
+}
+
+// --- Part 3: Set Operations ---
+/*
+ * Combining two bitsets is one bitwise operator per word:
+ *
+ *   AND     in both sets              (active AND in_europe)
+ *   OR      in either set
+ *   XOR     in exactly one of them
+ *   ANDNOT  in the first but not the second (a & ~b)
+ *
+ * We write it three ways, to see what each width buys. All three take the
+ * same arguments, so the benchmark can time them through a function
+ * pointer (Lesson 18). `dest` may be the same array as `a` or `b`, which
+ * allows the common `result = result AND filter`. The `switch` sits outside
+ * the loops, so no loop has to decide what to do on every step.
+ */
+typedef enum
+{
+    SET_AND,
+    SET_OR,
+    SET_XOR,
+    SET_ANDNOT
+} SetOp;
+
+typedef void (*CombineFunction)(uint64_t *dest, const uint64_t *a, const uint64_t *b, size_t word_count, SetOp op);
+
+// One byte (8 bits) per step: what Lesson 21's uint8_t flags would suggest.
+void combine_bytes(uint64_t *dest, const uint64_t *a, const uint64_t *b, size_t word_count, SetOp op)
+{
+    // Any object may be read and written as unsigned char, so these casts are safe.
+    unsigned char *out = (unsigned char *)dest;
+    const unsigned char *x = (const unsigned char *)a;
+    const unsigned char *y = (const unsigned char *)b;
+    size_t count = word_count * sizeof(uint64_t);
+
+    switch (op)
+    {
+    case SET_AND:
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = x[i] & y[i];
+        }
+        break;
+    case SET_OR:
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = x[i] | y[i];
+        }
+        break;
+    case SET_XOR:
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = x[i] ^ y[i];
+        }
+        break;
+    case SET_ANDNOT:
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = x[i] & (unsigned char)~y[i];
+        }
+        break;
+    }
+}
+
+// One 64-bit word per step: 8 times fewer steps. (An optimizing compiler
+// may vectorize these loops by itself; the benchmark shows whether it did.)
+void combine_words(uint64_t *dest, const uint64_t *a, const uint64_t *b, size_t word_count, SetOp op)
+{
+    switch (op)
+    {
+    case SET_AND:
+        for (size_t i = 0; i < word_count; i++)
+        {
+            dest[i] = a[i] & b[i];
+        }
+        break;
+    case SET_OR:
+        for (size_t i = 0; i < word_count; i++)
+        {
+            dest[i] = a[i] | b[i];
+        }
+        break;
+    case SET_XOR:
+        for (size_t i = 0; i < word_count; i++)
+        {
+            dest[i] = a[i] ^ b[i];
+        }
+        break;
+    case SET_ANDNOT:
+        for (size_t i = 0; i < word_count; i++)
+        {
+            dest[i] = a[i] & ~b[i];
+        }
+        break;
+    }
+}
+
+/*
+ * One vector (2 or 4 words) per step, spelled out with intrinsics so it
+ * doesn't depend on the optimizer. The arrays must be 16- or 32-byte aligned
+ * and `word_count` a multiple of SIMD_WORDS; our bitsets guarantee both.
+ */
+void combine_simd(uint64_t *dest, const uint64_t *a, const uint64_t *b, size_t word_count, SetOp op)
+{
+#if defined(SIMD_WORDS)
+    switch (op)
+    {
+    case SET_AND:
+        for (size_t i = 0; i < word_count; i += SIMD_WORDS)
+        {
+            simd_store(dest + i, simd_and(simd_load(a + i), simd_load(b + i)));
+        }
+        break;
+    case SET_OR:
+        for (size_t i = 0; i < word_count; i += SIMD_WORDS)
+        {
+            simd_store(dest + i, simd_or(simd_load(a + i), simd_load(b + i)));
+        }
+        break;
+    case SET_XOR:
+        for (size_t i = 0; i < word_count; i += SIMD_WORDS)
+        {
+            simd_store(dest + i, simd_xor(simd_load(a + i), simd_load(b + i)));
+        }
+        break;
+    case SET_ANDNOT:
+        for (size_t i = 0; i < word_count; i += SIMD_WORDS)
+        {
+            simd_store(dest + i, simd_andnot(simd_load(a + i), simd_load(b + i)));
+        }
+        break;
+    }
+#else
+    combine_words(dest, a, b, word_count, op);
+#endif
+}
+
+// `dest = a OP b`. Returns 0 if the three bitsets aren't the same size.
+int bitset_combine(Bitset *dest, const Bitset *a, const Bitset *b, SetOp op)
+{
+    if (dest->bit_count != a->bit_count || a->bit_count != b->bit_count)
+    {
+        return 0;
+    }
+    combine_simd(dest->words, a->words, b->words, a->word_count, op);
+    return 1;
+}
+
+/*
+ * Often we only want to know HOW MANY users match, not which. Doing the AND
+ * and the count in one pass reads the inputs once and never writes a result
+ * bitset at all: for big bitsets, memory traffic is the real cost.
+ */
+size_t bitset_and_count(const Bitset *a, const Bitset *b)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < a->word_count; i++)
+    {
+        total += (size_t)popcount(a->words[i] & b->words[i]);
+    }
+    return total;
+}
+
+// --- Part 4: Roaring Bitmaps for Sparse Sets ---
+/*
+ * A bitset costs one bit per POSSIBLE value. A set of 1000 user IDs out of
+ * 4 billion would still take 512 MB, almost all zeros. A ROARING BITMAP
+ * (Chambi, Lemire and others, used by Lucene, Spark and many databases)
+ * avoids that. It splits 32-bit values into CHUNKS of 65536 by their top 16
+ * bits, and stores each chunk that has any values in a CONTAINER:
+ *
+ * - an ARRAY of the values' low 16 bits, sorted, while the chunk holds at
+ *   most 4096 of them (2 bytes each, so at most 8 KB);
+ * - a BITMAP of 65536 bits (always 8 KB) once it holds more.
+ *
+ * Either way a container never takes more than 8 KB, and a sparse chunk
+ * takes only 2 bytes per value. The containers sit in an array sorted by
+ * their key, found by binary search. The two kinds share storage in a
+ * UNION (Lesson 23), and `kind` says which one is in use.
+ *
+ * Set operations work container by container: matching keys are combined,
+ * with a different method for each pair of kinds. Two bitmap containers
+ * reuse combine_simd() from Part 3. (Full Roaring implementations also have
+ * RUN containers for long stretches of consecutive values, and XOR and
+ * ANDNOT, which follow the same pattern as AND and OR below.)
+ */
+#define CHUNK_BITS 65536
+#define CHUNK_WORDS (CHUNK_BITS / BITS_PER_WORD)
+#define ARRAY_LIMIT 4096 // More values than this take less room as a bitmap.
+
+typedef enum
+{
+    CONTAINER_ARRAY,
+    CONTAINER_BITMAP
+} ContainerKind;
+
+typedef struct
+{
+    uint16_t key;         // The top 16 bits of every value in the container.
+    ContainerKind kind;
+    uint32_t cardinality; // How many values it holds (up to 65536).
+    uint32_t capacity;    // Room in `values`, for arrays.
+    union
+    {
+        uint16_t *values; // CONTAINER_ARRAY: the low 16 bits, sorted.
+        uint64_t *words;  // CONTAINER_BITMAP: CHUNK_WORDS words, aligned like a Bitset's.
+    } data;
+} Container;
+
+typedef struct
+{
+    Container *containers; // Sorted by key.
+    size_t count;
+    size_t capacity;
+} Roaring;
+
+void roaring_init(Roaring *roaring)
+{
+    roaring->containers = NULL;
+    roaring->count = roaring->capacity = 0;
+}
+
+static int container_init_array(Container *container, uint16_t key, uint32_t capacity)
+{
+    container->key = key;
+    container->kind = CONTAINER_ARRAY;
+    container->cardinality = 0;
+    container->capacity = capacity > 0 ? capacity : 1;
+    container->data.values = malloc(container->capacity * sizeof(uint16_t));
+    return container->data.values != NULL;
+}
+
+static int container_init_bitmap(Container *container, uint16_t key)
+{
+    container->key = key;
+    container->kind = CONTAINER_BITMAP;
+    container->cardinality = 0;
+    container->capacity = 0;
+    container->data.words = aligned_alloc(WORD_ALIGNMENT, CHUNK_WORDS * sizeof(uint64_t));
+    if (container->data.words == NULL)
+    {
+        return 0;
+    }
+    memset(container->data.words, 0, CHUNK_WORDS * sizeof(uint64_t));
+    return 1;
+}
+
+static void container_free(Container *container)
+{
+    if (container->kind == CONTAINER_ARRAY)
+    {
+        free(container->data.values);
+    }
+    else
+    {
+        free(container->data.words);
+    }
+}
+
+void roaring_free(Roaring *roaring)
+{
+    for (size_t i = 0; i < roaring->count; i++)
+    {
+        container_free(&roaring->containers[i]);
+    }
+    free(roaring->containers);
+    roaring_init(roaring);
+}
+
+// Rewrites an array container as a bitmap. On failure, it is left unchanged.
+static int container_to_bitmap(Container *container)
+{
+    Container bitmap;
+
+    if (!container_init_bitmap(&bitmap, container->key))
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < container->cardinality; i++)
+    {
+        uint16_t low = container->data.values[i];
+
+        bitmap.data.words[low / BITS_PER_WORD] |= UINT64_C(1) << (low % BITS_PER_WORD);
+    }
+    bitmap.cardinality = container->cardinality;
+    container_free(container);
+    *container = bitmap;
+    return 1;
+}
+
+// And back, for a bitmap that has become sparse. `word &= word - 1` clears
+// the lowest set bit, so the inner loop runs once per set bit.
+static int container_to_array(Container *container)
+{
+    Container array;
+
+    if (!container_init_array(&array, container->key, container->cardinality))
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < CHUNK_WORDS; i++)
+    {
+        for (uint64_t word = container->data.words[i]; word != 0; word &= word - 1)
+        {
+            array.data.values[array.cardinality++] = (uint16_t)(i * BITS_PER_WORD + (uint32_t)lowest_set_bit(word));
+        }
+    }
+    container_free(container);
+    *container = array;
+    return 1;
+}
+
+// Binary search for `low` in an array container: its index, or where it would go.
+static uint32_t find_value(const Container *container, uint16_t low)
+{
+    uint32_t first = 0, last = container->cardinality;
+
+    while (first < last)
+    {
+        uint32_t middle = first + (last - first) / 2;
+
+        if (container->data.values[middle] < low)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+static int container_contains(const Container *container, uint16_t low)
+{
+    if (container->kind == CONTAINER_BITMAP)
+    {
+        return (int)((container->data.words[low / BITS_PER_WORD] >> (low % BITS_PER_WORD)) & 1);
+    }
+    uint32_t index = find_value(container, low);
+    return index < container->cardinality && container->data.values[index] == low;
+}
+
+static int container_add(Container *container, uint16_t low)
+{
+    uint32_t index;
+
+    if (container->kind == CONTAINER_BITMAP)
+    {
+        uint64_t mask = UINT64_C(1) << (low % BITS_PER_WORD);
+
+        if ((container->data.words[low / BITS_PER_WORD] & mask) == 0)
+        {
+            container->data.words[low / BITS_PER_WORD] |= mask;
+            container->cardinality++;
+        }
+        return 1;
+    }
+
+    index = find_value(container, low);
+    if (index < container->cardinality && container->data.values[index] == low)
+    {
+        return 1; // Already there.
+    }
+    if (container->cardinality == ARRAY_LIMIT)
+    {
+        return container_to_bitmap(container) && container_add(container, low);
+    }
+    if (container->cardinality == container->capacity)
+    {
+        uint32_t capacity = container->capacity * 2 < ARRAY_LIMIT ? container->capacity * 2 : ARRAY_LIMIT;
+        uint16_t *values = realloc(container->data.values, capacity * sizeof(uint16_t));
+
+        if (values == NULL)
+        {
+            return 0;
+        }
+        container->data.values = values;
+        container->capacity = capacity;
+    }
+    memmove(&container->data.values[index + 1], &container->data.values[index],
+            (container->cardinality - index) * sizeof(uint16_t));
+    container->data.values[index] = low;
+    container->cardinality++;
+    return 1;
+}
+
+// Binary search for a container's key: its index, or where it would go.
+static size_t find_container(const Roaring *roaring, uint16_t key)
+{
+    size_t first = 0, last = roaring->count;
+
+    while (first < last)
+    {
+        size_t middle = first + (last - first) / 2;
+
+        if (roaring->containers[middle].key < key)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+static int insert_container(Roaring *roaring, size_t index, Container container)
+{
+    if (roaring->count == roaring->capacity)
+    {
+        size_t capacity = roaring->capacity > 0 ? roaring->capacity * 2 : 4;
+        Container *containers = realloc(roaring->containers, capacity * sizeof(Container));
+
+        if (containers == NULL)
+        {
+            return 0;
+        }
+        roaring->containers = containers;
+        roaring->capacity = capacity;
+    }
+    memmove(&roaring->containers[index + 1], &roaring->containers[index],
+            (roaring->count - index) * sizeof(Container));
+    roaring->containers[index] = container;
+    roaring->count++;
+    return 1;
+}
+
+// Adds `value` to the set. Returns 0 only if memory ran out.
+int roaring_add(Roaring *roaring, uint32_t value)
+{
+    uint16_t key = (uint16_t)(value >> 16);
+    size_t index = find_container(roaring, key);
+
+    if (index == roaring->count || roaring->containers[index].key != key)
+    {
+        Container container;
+
+        if (!container_init_array(&container, key, 4))
+        {
+            return 0;
+        }
+        if (!insert_container(roaring, index, container))
+        {
+            container_free(&container);
+            return 0;
+        }
+    }
+    return container_add(&roaring->containers[index], (uint16_t)value);
+}
+
+int roaring_contains(const Roaring *roaring, uint32_t value)
+{
+    uint16_t key = (uint16_t)(value >> 16);
+    size_t index = find_container(roaring, key);
+
+    return index < roaring->count && roaring->containers[index].key == key &&
+           container_contains(&roaring->containers[index], (uint16_t)value);
+}
+
+size_t roaring_cardinality(const Roaring *roaring)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < roaring->count; i++)
+    {
+        total += roaring->containers[i].cardinality;
+    }
+    return total;
+}
+
+// Bytes of heap memory the set uses.
+size_t roaring_memory(const Roaring *roaring)
+{
+    size_t bytes = roaring->capacity * sizeof(Container);
+
+    for (size_t i = 0; i < roaring->count; i++)
+    {
+        const Container *container = &roaring->containers[i];
+
+        bytes += container->kind == CONTAINER_ARRAY ? container->capacity * sizeof(uint16_t)
+                                                    : CHUNK_WORDS * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+// Calls `visit` for every value, in increasing order.
+void roaring_for_each(const Roaring *roaring, void (*visit)(uint32_t value, void *context), void *context)
+{
+    for (size_t i = 0; i < roaring->count; i++)
+    {
+        const Container *container = &roaring->containers[i];
+        uint32_t high = (uint32_t)container->key << 16;
+
+        if (container->kind == CONTAINER_ARRAY)
+        {
+            for (uint32_t j = 0; j < container->cardinality; j++)
+            {
+                visit(high | container->data.values[j], context);
+            }
+            continue;
+        }
+        for (uint32_t j = 0; j < CHUNK_WORDS; j++)
+        {
+            for (uint64_t word = container->data.words[j]; word != 0; word &= word - 1)
+            {
+                visit(high | (j * BITS_PER_WORD + (uint32_t)lowest_set_bit(word)), context);
+            }
+        }
+    }
+}
+
+/*
+ * Builds a Roaring bitmap holding the set bits of `set` (of at most 2^32
+ * bits). Adding them one by one would work, but a whole chunk at a time is
+ * much faster: count its bits, then copy its words into a bitmap container
+ * or collect them into an array. Returns 0 only if memory ran out.
+ */
+int roaring_from_bitset(Roaring *roaring, const Bitset *set)
+{
+    roaring_init(roaring);
+    for (size_t first = 0; first < set->word_count; first += CHUNK_WORDS)
+    {
+        const uint64_t *words = set->words + first;
+        size_t word_count = set->word_count - first < CHUNK_WORDS ? set->word_count - first : CHUNK_WORDS;
+        uint32_t cardinality = (uint32_t)count_bits(words, word_count);
+        uint16_t key = (uint16_t)(first / CHUNK_WORDS);
+        Container container;
+
+        if (cardinality == 0)
+        {
+            continue;
+        }
+        if (cardinality > ARRAY_LIMIT)
+        {
+            if (!container_init_bitmap(&container, key))
+            {
+                roaring_free(roaring);
+                return 0;
+            }
+            memcpy(container.data.words, words, word_count * sizeof(uint64_t));
+        }
+        else
+        {
+            if (!container_init_array(&container, key, cardinality))
+            {
+                roaring_free(roaring);
+                return 0;
+            }
+            for (uint32_t i = 0; i < word_count; i++)
+            {
+                for (uint64_t word = words[i]; word != 0; word &= word - 1)
+                {
+                    container.data.values[container.cardinality++] =
+                        (uint16_t)(i * BITS_PER_WORD + (uint32_t)lowest_set_bit(word));
+                }
+            }
+        }
+        container.cardinality = cardinality;
+        if (!insert_container(roaring, roaring->count, container))
+        {
+            container_free(&container);
+            roaring_free(roaring);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int container_copy(Container *copy, const Container *container)
+{
+    if (container->kind == CONTAINER_BITMAP)
+    {
+        if (!container_init_bitmap(copy, container->key))
+        {
+            return 0;
+        }
+        memcpy(copy->data.words, container->data.words, CHUNK_WORDS * sizeof(uint64_t));
+    }
+    else
+    {
+        if (!container_init_array(copy, container->key, container->cardinality))
+        {
+            return 0;
+        }
+        memcpy(copy->data.values, container->data.values, container->cardinality * sizeof(uint16_t));
+    }
+    copy->cardinality = container->cardinality;
+    return 1;
+}
+
+/*
+ * The values in both containers (which have the same key). On failure,
+ * nothing is left allocated.
+ */
+static int container_and(Container *result, const Container *a, const Container *b)
+{
+    if (a->kind == CONTAINER_BITMAP && b->kind == CONTAINER_BITMAP)
+    {
+        if (!container_init_bitmap(result, a->key))
+        {
+            return 0;
+        }
+        combine_simd(result->data.words, a->data.words, b->data.words, CHUNK_WORDS, SET_AND);
+        result->cardinality = (uint32_t)count_bits(result->data.words, CHUNK_WORDS);
+        if (result->cardinality <= ARRAY_LIMIT && !container_to_array(result))
+        {
+            container_free(result);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (a->kind == CONTAINER_BITMAP)
+    {
+        const Container *swap = a; // Make `a` the array.
+
+        a = b;
+        b = swap;
+    }
+    if (!container_init_array(result, a->key, a->cardinality))
+    {
+        return 0;
+    }
+    if (b->kind == CONTAINER_BITMAP)
+    {
+        // Keep the array values that are set in the bitmap.
+        for (uint32_t i = 0; i < a->cardinality; i++)
+        {
+            if (container_contains(b, a->data.values[i]))
+            {
+                result->data.values[result->cardinality++] = a->data.values[i];
+            }
+        }
+        return 1;
+    }
+
+    // Two sorted arrays: walk both, like the merge step of merge sort.
+    for (uint32_t i = 0, j = 0; i < a->cardinality && j < b->cardinality;)
+    {
+        if (a->data.values[i] < b->data.values[j])
+        {
+            i++;
+        }
+        else if (a->data.values[i] > b->data.values[j])
+        {
+            j++;
+        }
+        else
+        {
+            result->data.values[result->cardinality++] = a->data.values[i];
+            i++;
+            j++;
+        }
+    }
+    return 1;
+}
+
+// The values in either container (which have the same key).
+static int container_or(Container *result, const Container *a, const Container *b)
+{
+    if (a->kind == CONTAINER_ARRAY && b->kind == CONTAINER_ARRAY)
+    {
+        uint32_t i = 0, j = 0;
+
+        if (!container_init_array(result, a->key, a->cardinality + b->cardinality))
+        {
+            return 0;
+        }
+        while (i < a->cardinality || j < b->cardinality)
+        {
+            uint16_t next;
+
+            if (j == b->cardinality || (i < a->cardinality && a->data.values[i] < b->data.values[j]))
+            {
+                next = a->data.values[i++];
+            }
+            else if (i == a->cardinality || b->data.values[j] < a->data.values[i])
+            {
+                next = b->data.values[j++];
+            }
+            else
+            {
+                next = a->data.values[i++]; // In both: take it once.
+                j++;
+            }
+            result->data.values[result->cardinality++] = next;
+        }
+        if (result->cardinality > ARRAY_LIMIT && !container_to_bitmap(result))
+        {
+            container_free(result);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (a->kind == CONTAINER_ARRAY)
+    {
+        const Container *swap = a; // Make `a` a bitmap.
+
+        a = b;
+        b = swap;
+    }
+    if (!container_init_bitmap(result, a->key))
+    {
+        return 0;
+    }
+    if (b->kind == CONTAINER_BITMAP)
+    {
+        combine_simd(result->data.words, a->data.words, b->data.words, CHUNK_WORDS, SET_OR);
+    }
+    else
+    {
+        memcpy(result->data.words, a->data.words, CHUNK_WORDS * sizeof(uint64_t));
+        for (uint32_t i = 0; i < b->cardinality; i++)
+        {
+            result->data.words[b->data.values[i] / BITS_PER_WORD] |= UINT64_C(1) << (b->data.values[i] % BITS_PER_WORD);
+        }
+    }
+    result->cardinality = (uint32_t)count_bits(result->data.words, CHUNK_WORDS);
+    return 1;
+}
+
+// Adds a finished container at the end of `roaring`, or frees it if it is empty.
+static int append_container(Roaring *roaring, Container *container)
+{
+    if (container->cardinality == 0)
+    {
+        container_free(container);
+        return 1;
+    }
+    if (!insert_container(roaring, roaring->count, *container))
+    {
+        container_free(container);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * `result = a AND b`, and `result = a OR b`. `result` must not be `a` or `b`;
+ * it is initialized here. Both walk the two sorted key lists together, the
+ * way container_and() walks two arrays. Return 0 only if memory ran out (and
+ * then leave `result` empty).
+ */
+int roaring_and(Roaring *result, const Roaring *a, const Roaring *b)
+{
+    size_t i = 0, j = 0;
+
+    roaring_init(result);
+    while (i < a->count && j < b->count)
+    {
+        Container container;
+
+        if (a->containers[i].key < b->containers[j].key)
+        {
+            i++; // A chunk only `a` has can't be in the AND.
+        }
+        else if (a->containers[i].key > b->containers[j].key)
+        {
+            j++;
+        }
+        else
+        {
+            if (!container_and(&container, &a->containers[i++], &b->containers[j++]) ||
+                !append_container(result, &container))
+            {
+                roaring_free(result);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int roaring_or(Roaring *result, const Roaring *a, const Roaring *b)
+{
+    size_t i = 0, j = 0;
+
+    roaring_init(result);
+    while (i < a->count || j < b->count)
+    {
+        Container container;
+        int ok;
+
+        if (j == b->count || (i < a->count && a->containers[i].key < b->containers[j].key))
+        {
+            ok = container_copy(&container, &a->containers[i++]);
+        }
+        else if (i == a->count || b->containers[j].key < a->containers[i].key)
+        {
+            ok = container_copy(&container, &b->containers[j++]);
+        }
+        else
+        {
+            ok = container_or(&container, &a->containers[i++], &b->containers[j++]);
+        }
+        if (!ok || !append_container(result, &container))
+        {
+            roaring_free(result);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// --- Part 5: Measuring It ---
+/*
+ * `./21_bitsets --benchmark <bits>` builds bitsets of that many bits (up to
+ * 2^32, so every bit number fits in Roaring's 32-bit values) and times:
+ *
+ * 1. AND, OR, XOR and ANDNOT a byte, a word and a vector at a time. The
+ *    speed is in GB/s of memory touched: two inputs read, one result
+ *    written. Try a small size too (`--benchmark 1000000` fits in the CPU's
+ *    cache): there SIMD wins clearly. With a billion bits all the wider
+ *    versions run at the same speed, because the CPU is waiting for memory,
+ *    not computing.
+ * 2. Population count, portable and with the builtin (and the AVX2 table
+ *    lookup, if compiled with -mavx2), and AND + count in one pass.
+ * 3. Visiting every set bit: by testing each bit, with bitset_next_set(),
+ *    and with one loop over the words. next_set() shines on sparse sets, but
+ *    on dense ones its setup for every bit costs more than it saves.
+ * 4. Bitsets against Roaring bitmaps for sets from dense to very sparse:
+ *    memory, AND and OR.
+ *
+ * Every result is checked against the others. Note: the byte and word loops
+ * are plain C, so their speed depends on your compiler and flags.
+ */
+#define ROUNDS 3 // Each timing is the best of this many runs.
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// xorshift64: a fast pseudo-random generator, so every run sees the same data.
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// About half the bits set, at random. The padding stays 0.
+static void fill_random(Bitset *set, uint64_t *seed)
+{
+    size_t used_words = (set->bit_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    memset(set->words, 0, set->word_count * sizeof(uint64_t));
+    for (size_t i = 0; i < used_words; i++)
+    {
+        set->words[i] = next_random(seed);
+    }
+    if (set->bit_count % BITS_PER_WORD != 0)
+    {
+        set->words[used_words - 1] &= (UINT64_C(1) << (set->bit_count % BITS_PER_WORD)) - 1;
+    }
+}
+
+// About one bit in `spacing` set: the gaps between set bits average `spacing`.
+static void fill_sparse(Bitset *set, size_t spacing, uint64_t *seed)
+{
+    memset(set->words, 0, set->word_count * sizeof(uint64_t));
+    for (size_t bit = next_random(seed) % spacing; bit < set->bit_count;
+         bit += 1 + next_random(seed) % (2 * spacing - 1))
+    {
+        bitset_set(set, bit);
+    }
+}
+
+// Runs `combine` ROUNDS times and returns its speed in GB/s.
+static double time_combine(CombineFunction combine, Bitset *dest, const Bitset *a, const Bitset *b, SetOp op)
+{
+    double best = 0;
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        double start = now_seconds();
+        double elapsed;
+
+        combine(dest->words, a->words, b->words, a->word_count, op);
+        elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    return 3.0 * (double)a->word_count * sizeof(uint64_t) / best / 1e9;
+}
+
+static size_t count_portable(const uint64_t *words, size_t word_count)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < word_count; i++)
+    {
+        total += (size_t)popcount_portable(words[i]);
+    }
+    return total;
+}
+
+typedef size_t (*CountFunction)(const uint64_t *words, size_t word_count);
+
+// Runs `count` ROUNDS times and returns its speed in GB/s.
+static double time_count(CountFunction count, const Bitset *set, size_t *result)
+{
+    double best = 0;
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        double start = now_seconds();
+        double elapsed;
+
+        *result = count(set->words, set->word_count);
+        elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    return (double)set->word_count * sizeof(uint64_t) / best / 1e9;
+}
+
+// The two ways to visit every set bit. Each returns the sum of the bit
+// numbers, so the results can be compared.
+static uint64_t visit_by_testing(const Bitset *set)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < set->bit_count; i++)
+    {
+        if (bitset_test(set, i))
+        {
+            sum += i;
+        }
+    }
+    return sum;
+}
+
+static uint64_t visit_by_next_set(const Bitset *set)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = bitset_next_set(set, 0); i != BITSET_NONE; i = bitset_next_set(set, i + 1))
+    {
+        sum += i;
+    }
+    return sum;
+}
+
+// The fastest way to visit them all: one pass over the words, and
+// `word &= word - 1` to clear each set bit once we have seen it.
+static uint64_t visit_by_words(const Bitset *set)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < set->word_count; i++)
+    {
+        for (uint64_t word = set->words[i]; word != 0; word &= word - 1)
+        {
+            sum += i * BITS_PER_WORD + (size_t)lowest_set_bit(word);
+        }
+    }
+    return sum;
+}
+
+typedef struct
+{
+    const Bitset *expected;
+    size_t missing;
+} CheckContext;
+
+static void check_value(uint32_t value, void *context)
+{
+    CheckContext *check = context;
+
+    if (!bitset_test(check->expected, value))
+    {
+        check->missing++;
+    }
+}
+
+// 1 if `roaring` holds exactly the bits set in `expected`.
+static int roaring_matches(const Roaring *roaring, const Bitset *expected)
+{
+    CheckContext check = {expected, 0};
+
+    roaring_for_each(roaring, check_value, &check);
+    return check.missing == 0 && roaring_cardinality(roaring) == bitset_count(expected);
+}
+
+static int benchmark_set_operations(Bitset *a, Bitset *b, Bitset *dest, Bitset *expected)
+{
+    const char *names[] = {"AND", "OR", "XOR", "ANDNOT"};
+    int ok = 1;
+
+    printf("%-24s %10s %10s %10s\n", "Set operation (GB/s)", "bytes", "words", "SIMD");
+    for (SetOp op = SET_AND; op <= SET_ANDNOT; op++)
+    {
+        double bytes_speed, words_speed, simd_speed;
+
+        words_speed = time_combine(combine_words, expected, a, b, op);
+        bytes_speed = time_combine(combine_bytes, dest, a, b, op);
+        ok = ok && memcmp(dest->words, expected->words, dest->word_count * sizeof(uint64_t)) == 0;
+        simd_speed = time_combine(combine_simd, dest, a, b, op);
+        ok = ok && memcmp(dest->words, expected->words, dest->word_count * sizeof(uint64_t)) == 0;
+        printf("%-24s %10.2f %10.2f %10.2f\n", names[op], bytes_speed, words_speed, simd_speed);
+    }
+    return ok;
+}
+
+static int benchmark_counting(const Bitset *a, const Bitset *b, Bitset *dest)
+{
+    size_t portable, builtin, fused;
+    double portable_speed = time_count(count_portable, a, &portable);
+    double builtin_speed = time_count(count_bits, a, &builtin);
+    double start, separate_time, fused_time;
+    int ok = portable == builtin;
+
+    printf("\n%-24s %10s %10s %10s\n", "Popcount (GB/s)", "portable", "builtin", "AVX2");
+#if defined(__AVX2__)
+    {
+        size_t vector;
+        double vector_speed = time_count(count_bits_avx2, a, &vector);
+
+        ok = ok && vector == builtin;
+        printf("%-24s %10.2f %10.2f %10.2f\n", "", portable_speed, builtin_speed, vector_speed);
+    }
+#else
+    printf("%-24s %10.2f %10.2f %10s\n", "", portable_speed, builtin_speed, "-mavx2");
+#endif
+
+    start = now_seconds();
+    bitset_combine(dest, a, b, SET_AND);
+    builtin = bitset_count(dest);
+    separate_time = now_seconds() - start;
+    start = now_seconds();
+    fused = bitset_and_count(a, b);
+    fused_time = now_seconds() - start;
+    ok = ok && fused == builtin;
+    printf("How many in both: AND then count %.1f ms, AND + count in one pass %.1f ms\n", separate_time * 1e3,
+           fused_time * 1e3);
+    return ok;
+}
+
+static int benchmark_iteration(Bitset *set, uint64_t *seed)
+{
+    const size_t spacings[] = {2, 100, 10000};
+    int ok = 1;
+
+    printf("\n%-24s %10s %14s %14s %14s\n", "Visiting set bits (ms)", "set bits", "test each bit", "next_set()",
+           "word loop");
+    for (size_t s = 0; s < sizeof(spacings) / sizeof(spacings[0]); s++)
+    {
+        uint64_t tested_sum, found_sum, words_sum;
+        double start, tested_time, found_time, words_time;
+        char density[32];
+
+        if (spacings[s] == 2)
+        {
+            fill_random(set, seed);
+        }
+        else
+        {
+            fill_sparse(set, spacings[s], seed);
+        }
+        start = now_seconds();
+        tested_sum = visit_by_testing(set);
+        tested_time = now_seconds() - start;
+        start = now_seconds();
+        found_sum = visit_by_next_set(set);
+        found_time = now_seconds() - start;
+        start = now_seconds();
+        words_sum = visit_by_words(set);
+        words_time = now_seconds() - start;
+        ok = ok && tested_sum == found_sum && found_sum == words_sum;
+
+        snprintf(density, sizeof(density), "1 in %zu", spacings[s]);
+        printf("%-24s %10zu %14.1f %14.1f %14.1f\n", density, bitset_count(set), tested_time * 1e3,
+               found_time * 1e3, words_time * 1e3);
+    }
+    return ok;
+}
+
+// Bitsets against Roaring bitmaps, from dense to very sparse.
+static int benchmark_roaring(Bitset *a, Bitset *b, Bitset *dest, uint64_t *seed)
+{
+    const size_t spacings[] = {2, 100, 10000, 1000000};
+    int ok = 1;
+
+    printf("\n%-12s %12s %12s %10s %10s %10s %10s\n", "Density", "bitset MB", "Roaring MB", "bitset AND",
+           "Roaring AND", "bitset OR", "Roaring OR");
+    for (size_t s = 0; ok && s < sizeof(spacings) / sizeof(spacings[0]); s++)
+    {
+        Roaring x, y, result;
+        double start, bitset_and_time, roaring_and_time, bitset_or_time, roaring_or_time;
+        char density[32];
+
+        if (spacings[s] == 2)
+        {
+            fill_random(a, seed);
+            fill_random(b, seed);
+        }
+        else
+        {
+            fill_sparse(a, spacings[s], seed);
+            fill_sparse(b, spacings[s], seed);
+        }
+        if (!roaring_from_bitset(&x, a) || !roaring_from_bitset(&y, b))
+        {
+            fprintf(stderr, "Error: Memory allocation failed!\n");
+            exit(1);
+        }
+
+        start = now_seconds();
+        bitset_combine(dest, a, b, SET_AND);
+        bitset_and_time = now_seconds() - start;
+        start = now_seconds();
+        ok = roaring_and(&result, &x, &y);
+        roaring_and_time = now_seconds() - start;
+        ok = ok && roaring_matches(&result, dest);
+        roaring_free(&result);
+
+        start = now_seconds();
+        bitset_combine(dest, a, b, SET_OR);
+        bitset_or_time = now_seconds() - start;
+        start = now_seconds();
+        ok = ok && roaring_or(&result, &x, &y);
+        roaring_or_time = now_seconds() - start;
+        ok = ok && roaring_matches(&result, dest);
+        roaring_free(&result);
+
+        snprintf(density, sizeof(density), "1 in %zu", spacings[s]);
+        printf("%-12s %12.2f %12.2f %8.2fms %9.2fms %8.2fms %8.2fms\n", density,
+               (double)a->word_count * sizeof(uint64_t) / 1e6, (double)roaring_memory(&x) / 1e6,
+               bitset_and_time * 1e3, roaring_and_time * 1e3, bitset_or_time * 1e3, roaring_or_time * 1e3);
+        roaring_free(&x);
+        roaring_free(&y);
+    }
+    return ok;
+}
+
+int run_benchmark(size_t bit_count)
+{
+    Bitset a, b, dest, expected;
+    uint64_t seed = 2025;
+    int ok;
+
+    if (!bitset_init(&a, bit_count) || !bitset_init(&b, bit_count) || !bitset_init(&dest, bit_count) ||
+        !bitset_init(&expected, bit_count))
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        return 1;
+    }
+    fill_random(&a, &seed);
+    fill_random(&b, &seed);
+
+    printf("Bitsets of %zu bits (%.1f MB each). SIMD: %s. Best of %d runs.\n\n", bit_count,
+           (double)a.word_count * sizeof(uint64_t) / 1e6, SIMD_NAME, ROUNDS);
+    ok = benchmark_set_operations(&a, &b, &dest, &expected);
+    ok = ok && benchmark_counting(&a, &b, &dest);
+    ok = ok && benchmark_iteration(&dest, &seed);
+    ok = ok && benchmark_roaring(&a, &b, &dest, &seed);
+
+    bitset_free(&a);
+    bitset_free(&b);
+    bitset_free(&dest);
+    bitset_free(&expected);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Error: the bitset and Roaring results disagree!\n");
+        return 1;
+    }
+    printf("All bitset and Roaring results agreed.\n");
+    return 0;
+}
+
+// Prints the first `count` bits, bit 0 on the LEFT (so user 0 comes first).
+void print_bits(const char *name, const Bitset *set, size_t count)
+{
+    printf("%-28s", name);
+    for (size_t i = 0; i < count; i++)
+    {
+        printf("%d", bitset_test(set, i));
+    }
+    printf("\n");
+}
+
+// Prints values while `*context` (how many more to print) is above 0.
+static void print_value(uint32_t value, void *context)
+{
+    int *remaining = context;
+
+    if (*remaining > 0)
+    {
+        printf(" %u", (unsigned int)value);
+        (*remaining)--;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    enum { USERS = 200 };
+    Bitset active, in_europe, premium, result;
+    Roaring ids, odd_ids, both;
+    uint64_t seed = 21;
+
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        long long count = atoll(argv[2]);
+
+        // Bit numbers must fit in Roaring's 32-bit values.
+        if (count < 1000 || count > 4294967296LL)
+        {
+            fprintf(stderr, "Error: the bit count must be between 1000 and 4294967296.\n");
+            return 1;
+        }
+        return run_benchmark((size_t)count);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--benchmark <bits>]\n", argv[0]);
+        return 1;
+    }
+
+    printf("--- Part 1: A Bitmap Index ---\n");
+    if (!bitset_init(&active, USERS) || !bitset_init(&in_europe, USERS) || !bitset_init(&premium, USERS) ||
+        !bitset_init(&result, USERS))
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        return 1;
+    }
+    for (size_t user = 0; user < USERS; user++)
+    {
+        uint64_t coins = next_random(&seed);
+
+        if (coins & 3) // 3 chances in 4
+        {
+            bitset_set(&active, user);
+        }
+        if (coins & 4) // 1 in 2
+        {
+            bitset_set(&in_europe, user);
+        }
+        if ((coins & 24) == 0) // 1 in 4
+        {
+            bitset_set(&premium, user);
+        }
+    }
+    bitset_clear(&active, 0); // User 0 is a test account.
+
+    printf("%d users; the first 40 of each bitmap:\n", USERS);
+    print_bits("active", &active, 40);
+    print_bits("in_europe", &in_europe, 40);
+    print_bits("premium", &premium, 40);
+
+    bitset_combine(&result, &active, &in_europe, SET_AND);
+    bitset_combine(&result, &result, &premium, SET_ANDNOT);
+    print_bits("active, Europe, no premium", &result, 40);
+
+    printf("That query matches %zu users. The first ten:", bitset_count(&result));
+    for (size_t user = bitset_next_set(&result, 0), shown = 0; user != BITSET_NONE && shown < 10;
+         user = bitset_next_set(&result, user + 1), shown++)
+    {
+        printf(" %zu", user);
+    }
+    printf("\n");
+
+    bitset_combine(&result, &active, &premium, SET_OR);
+    printf("Active or premium: %zu users. ", bitset_count(&result));
+    bitset_combine(&result, &active, &premium, SET_XOR);
+    printf("Exactly one of the two: %zu. ", bitset_count(&result));
+    printf("Both (counted without a result bitset): %zu.\n", bitset_and_count(&active, &premium));
+
+    printf("\n--- Part 2: A Roaring Bitmap ---\n");
+    roaring_init(&ids);
+    roaring_init(&odd_ids);
+    roaring_add(&ids, 3);
+    roaring_add(&ids, 1);
+    roaring_add(&ids, 2);
+    roaring_add(&ids, 100001);
+    roaring_add(&ids, 100000);
+    for (uint32_t id = 200000; id < 210000; id++)
+    {
+        roaring_add(&ids, id); // 10000 IDs in one chunk: too many for an array.
+    }
+    for (uint32_t id = 1; id < 210000; id += 2)
+    {
+        roaring_add(&odd_ids, id);
+    }
+
+    printf("IDs 1, 2, 3, 100000, 100001 and 200000 to 209999, in %zu containers:\n", ids.count);
+    for (size_t i = 0; i < ids.count; i++)
+    {
+        const Container *container = &ids.containers[i];
+
+        printf("  chunk %u (values %u to %u): %s of %u values\n", (unsigned int)container->key,
+               (unsigned int)container->key << 16, ((unsigned int)container->key << 16) + 65535,
+               container->kind == CONTAINER_ARRAY ? "array" : "bitmap", (unsigned int)container->cardinality);
+    }
+    printf("Memory: %zu bytes, against %zu bytes for a bitset of 210000 bits.\n", roaring_memory(&ids),
+           (size_t)(210000 + 511) / 512 * 64);
+    printf("Contains 100001? %s. Contains 100002? %s.\n", roaring_contains(&ids, 100001) ? "yes" : "no",
+           roaring_contains(&ids, 100002) ? "yes" : "no");
+
+    if (roaring_and(&both, &ids, &odd_ids))
+    {
+        int remaining = 6;
+
+        printf("AND with the odd IDs below 210000: %zu IDs:", roaring_cardinality(&both));
+        roaring_for_each(&both, print_value, &remaining);
+        printf(" ...\n");
+        roaring_free(&both);
+    }
+
+    roaring_free(&ids);
+    roaring_free(&odd_ids);
+    bitset_free(&active);
+    bitset_free(&in_europe);
+    bitset_free(&premium);
+    bitset_free(&result);
+    return 0;
+}
+
+/*
+ * =====================================================================================
+ * |                                    - LESSON END -                                   |
+ * =====================================================================================
+ *
+ * Key Takeaways:
+ *
+ * 1.  A BITSET stores one bit per possible value: bit `i` is bit `i % 64` of
+ *     word `i / 64`. Setting, clearing and testing are Lesson 21's masks.
+ * 2.  A BITMAP INDEX answers filters like "active AND in Europe AND NOT
+ *     premium" with AND, OR, XOR and ANDNOT over whole bitsets, 64 rows per
+ *     instruction, and more with SIMD.
+ * 3.  Work a WORD at a time: popcount counts a word's bits in one step, and
+ *     lowest_set_bit() finds its first set bit without a loop.
+ * 4.  SIMD intrinsics work on 128 or 256 bits at once, but big bitsets soon
+ *     run at the speed of memory. Doing two things in one pass (AND + count)
+ *     saves memory traffic, which often matters more.
+ * 5.  For SPARSE sets, a ROARING BITMAP keeps each 65536-value chunk as a
+ *     sorted array or a bitmap, whichever is smaller.
+ *
+ * HOW TO COMPILE AND RUN THIS CODE:
+ *
+ * 1. Compile the program:
+ *    `gcc -Wall -Wextra -std=c11 -o 21_bitsets 21_bitsets.c`
+ * 2. Run the demonstration:
+ *    `./21_bitsets`
+ * 3. Run the benchmark with optimization. `-march=native` lets the compiler
+ *    use AVX2 and POPCNT if your CPU has them; try it with and without:
+ *    `gcc -Wall -Wextra -std=c11 -O2 -march=native -o 21_bitsets 21_bitsets.c`
+ *    `./21_bitsets --benchmark 1000000000`
+ */
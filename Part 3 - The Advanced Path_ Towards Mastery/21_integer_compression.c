@@ -0,0 +1,908 @@
+/**
+ * @file 21_integer_compression.c
+ * @brief Part 3, Lesson 21 (continued): Compressing Integers
+ * @author dunamismax
+ * @date 10-18-2026
+ *
+ * This file continues the bit manipulation lesson. It stores lists of
+ * integers in fewer bits: variable-length integers (varints), zigzag
+ * encoding, frame-of-reference bit-packing and delta encoding, with SIMD
+ * decoders for the formats built to allow them.
+ */
+
+/*
+ * =====================================================================================
+ * |                                   - LESSON START -                                  |
+ * =====================================================================================
+ *
+ * A `uint32_t` always takes 32 bits, even when it holds 7. Databases keep
+ * columns of numbers, and search engines keep POSTING LISTS (for each word,
+ * the sorted list of documents that contain it), and most of those numbers
+ * are small or close to their neighbours. Storing them in fewer bits saves
+ * memory and disk, and, because reading memory is often slower than
+ * computing, can even make programs FASTER: the CPU unpacks the numbers
+ * while it would otherwise wait for them.
+ *
+ * This lesson builds these CODECS (enCOder/DECoder pairs):
+ *
+ * - VARINT (LEB128): 7 bits per byte, so small numbers take one byte.
+ * - ZIGZAG: maps small NEGATIVE numbers to small positive ones first.
+ * - STREAM VBYTE: a varint layout that SIMD instructions can decode.
+ * - FRAME OF REFERENCE (FOR): blocks of 128 numbers, each stored as its
+ *   distance from the block's smallest, in exactly as many bits as the
+ *   biggest distance needs.
+ * - DELTA encoding: store the GAPS between sorted numbers, which are small.
+ *
+ * `./21_integer_compression --benchmark 10000000` measures how small each
+ * one makes four kinds of data, and how fast it decodes them.
+ */
+
+#include <stdint.h> // For uint32_t and friends
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>   // For timespec_get(), to time the benchmark
+
+/*
+ * The SIMD decoders use intrinsics (see `21_bitsets.c`). SSE2 is on every
+ * x86-64 CPU. Stream VByte needs the SHUFFLE instruction of SSSE3, which the
+ * compiler only uses with `-mssse3` or `-march=native`. Without them, or on
+ * other CPUs, the plain C decoders do all the work.
+ */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+// --- Part 1: Zigzag and Varints ---
+/*
+ * A VARINT (the LEB128 format of DWARF, WebAssembly and Protocol Buffers)
+ * stores 7 bits of the number in each byte, lowest bits first. The top bit
+ * of a byte (0x80) says "another byte follows":
+ *
+ *   5     = 0000101                 -> 00000101             (1 byte)
+ *   300   = 0000010 0101100         -> 10101100 00000010    (2 bytes)
+ *
+ * Numbers below 128 take one byte, below 16384 two, and a full 64-bit
+ * number at most ten.
+ *
+ * Negative numbers are a problem: -1 is all ones, so it would take ten
+ * bytes. ZIGZAG encoding interleaves them with the positives first,
+ *
+ *   0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3, 2 -> 4, ...
+ *
+ * by moving the sign into bit 0: shift left by one, and flip every bit if
+ * the number was negative.
+ */
+uint64_t zigzag_encode(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (value < 0 ? UINT64_MAX : 0);
+}
+
+int64_t zigzag_decode(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); // XOR with 0 or with all ones
+}
+
+// The same on 32 bits, reading `value` as a two's complement int32_t.
+static inline uint32_t zigzag_encode32(uint32_t value)
+{
+    return (value << 1) ^ (0u - (value >> 31));
+}
+
+static inline uint32_t zigzag_decode32(uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+// Writes `value` as a varint. Returns the number of bytes (1 to 10).
+size_t varint_put(uint64_t value, uint8_t *out)
+{
+    size_t length = 0;
+
+    while (value >= 0x80)
+    {
+        out[length++] = (uint8_t)(value | 0x80); // The low 7 bits, and "more to come".
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+// Reads one varint and moves `*cursor` past it. (A decoder for untrusted
+// data would also reject a varint longer than 10 bytes; we just stop.)
+uint64_t varint_get(const uint8_t **cursor)
+{
+    const uint8_t *byte = *cursor;
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        value |= (uint64_t)(*byte & 0x7f) << shift;
+        if (*byte++ < 0x80)
+        {
+            break;
+        }
+    }
+    *cursor = byte;
+    return value;
+}
+
+/*
+ * Every codec below has the same three functions, so the benchmark can
+ * treat them alike through function pointers (Lesson 18). `out` must have
+ * room for the worst case: 5 bytes per value, plus a little.
+ */
+size_t varint_encode(const uint32_t *values, size_t count, uint8_t *out)
+{
+    size_t size = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size += varint_put(values[i], out + size);
+    }
+    return size;
+}
+
+void varint_decode(const uint8_t *in, size_t count, uint32_t *out)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (*in < 0x80)
+        {
+            out[i] = *in++; // The common one-byte case, without a loop.
+        }
+        else
+        {
+            out[i] = (uint32_t)varint_get(&in);
+        }
+    }
+}
+
+// --- Part 2: Stream VByte ---
+/*
+ * Varints are hard to decode quickly. To know where value i+1 starts, we
+ * must look at every byte of value i, one at a time, and the CPU keeps
+ * guessing wrong about how many bytes there will be.
+ *
+ * STREAM VBYTE (Lemire, Kurz and Rupp) stores the same information in a
+ * different layout. Each 32-bit value takes 1 to 4 whole bytes, and its
+ * LENGTH goes into 2 bits of a separate CONTROL byte, which covers 4 values:
+ *
+ *   values:   5        300         70000             16777216
+ *   lengths:  1        2           3                 4
+ *   control:  (4-1)<<6 | (3-1)<<4 | (2-1)<<2 | (1-1) = 0b11100100
+ *   data:     05 | 2c 01 | 70 11 01 | 00 00 00 01      (10 bytes)
+ *
+ * All the control bytes come first, then all the data. From one control
+ * byte, the decoder knows where 4 values lie without looking at their
+ * bytes. With SSSE3, it loads 16 bytes of data and uses one SHUFFLE
+ * instruction (`pshufb`) to move each value's bytes into its own 32-bit
+ * lane, zero-filling the rest. The shuffle pattern for each of the 256
+ * control bytes comes from a table, built once.
+ *
+ * The encoder adds 16 zero bytes at the end, so that the decoder's 16-byte
+ * loads never read past the buffer.
+ */
+#define STREAM_VBYTE_PADDING 16
+
+#if defined(__SSSE3__)
+static uint8_t stream_vbyte_shuffles[256][16];
+static uint8_t stream_vbyte_lengths[256]; // Data bytes for each control byte.
+static int stream_vbyte_tables_ready = 0;
+
+static void build_stream_vbyte_tables(void)
+{
+    for (int control = 0; control < 256; control++)
+    {
+        int position = 0;
+
+        for (int lane = 0; lane < 4; lane++)
+        {
+            int length = ((control >> (2 * lane)) & 3) + 1;
+
+            for (int byte = 0; byte < 4; byte++)
+            {
+                // 0x80 in a shuffle pattern means "put a zero byte here".
+                stream_vbyte_shuffles[control][lane * 4 + byte] = byte < length ? (uint8_t)(position + byte) : 0x80;
+            }
+            position += length;
+        }
+        stream_vbyte_lengths[control] = (uint8_t)position;
+    }
+    stream_vbyte_tables_ready = 1;
+}
+#endif
+
+static inline int byte_length(uint32_t value)
+{
+    return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+size_t stream_vbyte_encode(const uint32_t *values, size_t count, uint8_t *out)
+{
+    uint8_t *controls = out;
+    uint8_t *data = out + (count + 3) / 4;
+
+    memset(controls, 0, (count + 3) / 4);
+    for (size_t i = 0; i < count; i++)
+    {
+        int length = byte_length(values[i]);
+
+        controls[i / 4] |= (uint8_t)((length - 1) << (2 * (i % 4)));
+        for (int byte = 0; byte < length; byte++)
+        {
+            *data++ = (uint8_t)(values[i] >> (8 * byte)); // Little-endian: lowest byte first.
+        }
+    }
+    memset(data, 0, STREAM_VBYTE_PADDING);
+    return (size_t)(data - out) + STREAM_VBYTE_PADDING;
+}
+
+// Decodes values `first` to `count - 1` one at a time.
+static void stream_vbyte_decode_from(const uint8_t *controls, const uint8_t *data, size_t first, size_t count,
+                                     uint32_t *out)
+{
+    for (size_t i = first; i < count; i++)
+    {
+        int length = ((controls[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+
+        for (int byte = 0; byte < length; byte++)
+        {
+            value |= (uint32_t)data[byte] << (8 * byte);
+        }
+        out[i] = value;
+        data += length;
+    }
+}
+
+void stream_vbyte_decode(const uint8_t *in, size_t count, uint32_t *out)
+{
+    stream_vbyte_decode_from(in, in + (count + 3) / 4, 0, count, out);
+}
+
+#if defined(__SSSE3__)
+void stream_vbyte_decode_simd(const uint8_t *in, size_t count, uint32_t *out)
+{
+    const uint8_t *controls = in;
+    const uint8_t *data = in + (count + 3) / 4;
+    size_t groups = count / 4;
+
+    if (!stream_vbyte_tables_ready)
+    {
+        build_stream_vbyte_tables();
+    }
+    for (size_t g = 0; g < groups; g++)
+    {
+        uint8_t control = controls[g];
+        __m128i bytes = _mm_loadu_si128((const __m128i *)data);
+        __m128i pattern = _mm_loadu_si128((const __m128i *)stream_vbyte_shuffles[control]);
+
+        _mm_storeu_si128((__m128i *)(out + 4 * g), _mm_shuffle_epi8(bytes, pattern));
+        data += stream_vbyte_lengths[control];
+    }
+    stream_vbyte_decode_from(controls, data, groups * 4, count, out); // The last 0 to 3 values.
+}
+#endif
+
+// --- Part 3: Frame of Reference and Bit-Packing ---
+/*
+ * Lesson 21 packed 8 flags into one byte. BIT-PACKING does the same with
+ * numbers: if every number in a list fits in b bits, store each in exactly
+ * b bits, one after another, across word boundaries.
+ *
+ * FRAME OF REFERENCE (FOR) makes b small. Split the list into blocks of 128
+ * values, and store each value as its distance from the block's smallest
+ * value, the REFERENCE. Readings between 1000 and 1015 need only 4 bits
+ * each, not 32. A block is stored as two header words (reference and b) and
+ * then 128 * b bits: 4 * b words.
+ *
+ * The bits are laid out for SIMD (Lemire and Boytsov's "SIMD-BP128"). An SSE2
+ * register holds 4 words, so a block is split into 4 LANES: value i goes to
+ * lane i % 4, and each lane packs its 32 values into its own b words, which
+ * sit 4 words apart:
+ *
+ *   words:   [lane 0][lane 1][lane 2][lane 3] [lane 0][lane 1] ...
+ *   values:   0 4 8.. 1 5 9..  2 6 ..  3 7 ..  (continued)
+ *
+ * One SIMD shift then unpacks 4 values at once: values 4k to 4k+3, which are
+ * next to each other in the output, so they are stored with one instruction.
+ * The plain C decoder reads the same layout, one lane at a time.
+ */
+#define BLOCK_VALUES 128
+#define BLOCK_HEADER_WORDS 2
+
+// The number of bits needed for `value` (0 for 0).
+static int bits_needed(uint32_t value)
+{
+    int bits = 0;
+
+    while (value != 0)
+    {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+/*
+ * Packs exactly BLOCK_VALUES values. The lane's bits collect in a 64-bit
+ * BUFFER, and each time 32 of them are ready we write a word. Returns the
+ * number of words written.
+ */
+static size_t pack_block(const uint32_t *values, uint32_t *out)
+{
+    uint32_t low = values[0], high = values[0];
+    int bits;
+
+    for (int i = 1; i < BLOCK_VALUES; i++)
+    {
+        low = values[i] < low ? values[i] : low;
+        high = values[i] > high ? values[i] : high;
+    }
+    bits = bits_needed(high - low);
+    out[0] = low;
+    out[1] = (uint32_t)bits;
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        uint32_t *word = out + BLOCK_HEADER_WORDS + lane;
+        uint64_t buffer = 0;
+        int filled = 0;
+
+        for (int k = 0; k < BLOCK_VALUES / 4; k++)
+        {
+            buffer |= (uint64_t)(values[4 * k + lane] - low) << filled;
+            filled += bits;
+            if (filled >= 32)
+            {
+                *word = (uint32_t)buffer;
+                word += 4; // The lane's next word.
+                buffer >>= 32;
+                filled -= 32;
+            }
+        }
+    }
+    return BLOCK_HEADER_WORDS + 4 * (size_t)bits;
+}
+
+typedef void (*UnpackFunction)(const uint32_t *words, int bits, uint32_t reference, uint32_t *out);
+
+static void unpack_block(const uint32_t *words, int bits, uint32_t reference, uint32_t *out)
+{
+    uint32_t mask = bits == 32 ? UINT32_MAX : (1u << bits) - 1; // `1u << 32` would be undefined.
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        const uint32_t *word = words + lane;
+        uint64_t buffer = 0;
+        int available = 0;
+
+        for (int k = 0; k < BLOCK_VALUES / 4; k++)
+        {
+            if (available < bits)
+            {
+                buffer |= (uint64_t)*word << available;
+                word += 4;
+                available += 32;
+            }
+            out[4 * k + lane] = reference + ((uint32_t)buffer & mask);
+            buffer >>= bits;
+            available -= bits;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+/*
+ * The same, for all 4 lanes at once. `used` counts the bits of the current
+ * words already consumed. When a value runs past the end of a word, its
+ * high bits come from the start of the next one, shifted into place.
+ */
+static void unpack_block_simd(const uint32_t *words, int bits, uint32_t reference, uint32_t *out)
+{
+    const __m128i *next = (const __m128i *)words;
+    __m128i mask = _mm_set1_epi32((int)(bits == 32 ? UINT32_MAX : (1u << bits) - 1));
+    __m128i base = _mm_set1_epi32((int)reference);
+    __m128i current;
+    int used = 0;
+
+    if (bits == 0)
+    {
+        for (int k = 0; k < BLOCK_VALUES / 4; k++)
+        {
+            _mm_storeu_si128((__m128i *)(out + 4 * k), base); // Every value is the reference.
+        }
+        return;
+    }
+
+    current = _mm_loadu_si128(next++);
+    for (int k = 0; k < BLOCK_VALUES / 4; k++)
+    {
+        __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(used));
+
+        used += bits;
+        if (used >= 32 && k < BLOCK_VALUES / 4 - 1)
+        {
+            current = _mm_loadu_si128(next++);
+            used -= 32;
+            if (used > 0)
+            {
+                value = _mm_or_si128(value, _mm_sll_epi32(current, _mm_cvtsi32_si128(bits - used)));
+            }
+        }
+        _mm_storeu_si128((__m128i *)(out + 4 * k), _mm_add_epi32(_mm_and_si128(value, mask), base));
+    }
+}
+#endif
+
+// --- Part 4: Delta Encoding ---
+/*
+ * Sorted lists, such as posting lists and timestamps, hold big numbers
+ * that grow slowly: 1000000, 1000007, 1000012, 1000020, ... The GAPS
+ * between them (DELTAS) are small: 7, 5, 8, ... DELTA ENCODING stores the
+ * gaps (here with FOR bit-packing), and decoding adds them back up: a
+ * PREFIX SUM, where each output is the previous output plus a gap.
+ *
+ * A prefix sum looks hopelessly sequential, but SIMD can do 4 at once. With
+ * gaps (a, b, c, d) in a register, add a copy shifted by one lane, then a
+ * copy shifted by two lanes, then the last sum of the previous group:
+ *
+ *   (a, b, c, d) + (0, a, b, c)     = (a, a+b, b+c, c+d)
+ *                + (0, 0, a, a+b)   = (a, a+b, a+b+c, a+b+c+d)
+ *
+ * The first value of a list is no gap at all: it can be huge, and it would
+ * make its whole block take as many bits. So a delta stream starts with the
+ * first value as a plain word, and the gaps are measured from there.
+ *
+ * Gaps are computed with unsigned arithmetic, which wraps around, so even an
+ * unsorted list decodes correctly (it just doesn't shrink). For numbers that
+ * go up AND down, like sensor readings, the "delta + varint" codec ZIGZAGs
+ * the gaps first.
+ */
+typedef uint32_t (*PrefixSumFunction)(uint32_t *values, uint32_t previous);
+
+// Turns a block of gaps back into values. Returns the last value.
+static uint32_t prefix_sum(uint32_t *values, uint32_t previous)
+{
+    for (int i = 0; i < BLOCK_VALUES; i++)
+    {
+        previous += values[i];
+        values[i] = previous;
+    }
+    return previous;
+}
+
+#if defined(__SSE2__)
+static uint32_t prefix_sum_simd(uint32_t *values, uint32_t previous)
+{
+    __m128i carry = _mm_set1_epi32((int)previous);
+
+    for (int i = 0; i < BLOCK_VALUES; i += 4)
+    {
+        __m128i sums = _mm_loadu_si128((const __m128i *)(values + i));
+
+        sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 4)); // Shift by one 4-byte lane.
+        sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 8)); // And by two.
+        sums = _mm_add_epi32(sums, carry);
+        _mm_storeu_si128((__m128i *)(values + i), sums);
+        carry = _mm_shuffle_epi32(sums, 0xff); // The last sum, in all 4 lanes.
+    }
+    return values[BLOCK_VALUES - 1];
+}
+#endif
+
+/*
+ * The block codecs. A last, partial block is padded with copies of its last
+ * value (or gap), which never needs extra bits, and the padding is dropped
+ * again when decoding.
+ */
+static size_t encode_blocks(const uint32_t *values, size_t count, uint8_t *out, int delta)
+{
+    uint32_t *words = (uint32_t *)out; // malloc() memory is aligned for any type.
+    uint32_t previous = 0;
+    size_t size = 0;
+
+    if (delta && count > 0)
+    {
+        previous = values[0];
+        words[size++] = previous; // The starting point for the gaps.
+    }
+    for (size_t first = 0; first < count; first += BLOCK_VALUES)
+    {
+        uint32_t block[BLOCK_VALUES];
+        size_t length = count - first < BLOCK_VALUES ? count - first : BLOCK_VALUES;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            block[i] = delta ? values[first + i] - previous : values[first + i];
+            previous = values[first + i];
+        }
+        for (size_t i = length; i < BLOCK_VALUES; i++)
+        {
+            block[i] = block[length - 1];
+        }
+        size += pack_block(block, words + size);
+    }
+    return size * sizeof(uint32_t);
+}
+
+static void decode_blocks(const uint8_t *in, size_t count, uint32_t *out, UnpackFunction unpack,
+                          PrefixSumFunction sum)
+{
+    const uint32_t *words = (const uint32_t *)in;
+    uint32_t previous = 0;
+
+    if (sum != NULL && count > 0)
+    {
+        previous = *words++;
+    }
+    for (size_t first = 0; first < count; first += BLOCK_VALUES)
+    {
+        uint32_t block[BLOCK_VALUES];
+        uint32_t *target = count - first >= BLOCK_VALUES ? out + first : block; // Full blocks go straight to `out`.
+        int bits = (int)words[1];
+
+        unpack(words + BLOCK_HEADER_WORDS, bits, words[0], target);
+        if (sum != NULL)
+        {
+            previous = sum(target, previous);
+        }
+        if (target == block)
+        {
+            memcpy(out + first, block, (count - first) * sizeof(uint32_t));
+        }
+        words += BLOCK_HEADER_WORDS + 4 * (size_t)bits;
+    }
+}
+
+size_t for_encode(const uint32_t *values, size_t count, uint8_t *out)
+{
+    return encode_blocks(values, count, out, 0);
+}
+
+void for_decode(const uint8_t *in, size_t count, uint32_t *out)
+{
+    decode_blocks(in, count, out, unpack_block, NULL);
+}
+
+size_t delta_encode(const uint32_t *values, size_t count, uint8_t *out)
+{
+    return encode_blocks(values, count, out, 1);
+}
+
+void delta_decode(const uint8_t *in, size_t count, uint32_t *out)
+{
+    decode_blocks(in, count, out, unpack_block, prefix_sum);
+}
+
+#if defined(__SSE2__)
+void for_decode_simd(const uint8_t *in, size_t count, uint32_t *out)
+{
+    decode_blocks(in, count, out, unpack_block_simd, NULL);
+}
+
+void delta_decode_simd(const uint8_t *in, size_t count, uint32_t *out)
+{
+    decode_blocks(in, count, out, unpack_block_simd, prefix_sum_simd);
+}
+#endif
+
+// Gaps, zigzagged, as varints: for series that go up and down.
+size_t delta_varint_encode(const uint32_t *values, size_t count, uint8_t *out)
+{
+    uint32_t previous = 0;
+    size_t size = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size += varint_put(zigzag_encode32(values[i] - previous), out + size);
+        previous = values[i];
+    }
+    return size;
+}
+
+void delta_varint_decode(const uint8_t *in, size_t count, uint32_t *out)
+{
+    uint32_t previous = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        previous += zigzag_decode32((uint32_t)varint_get(&in));
+        out[i] = previous;
+    }
+}
+
+// --- Part 5: Measuring Them ---
+/*
+ * `./21_integer_compression --benchmark <count>` makes four lists of
+ * `count` numbers:
+ *
+ * - sorted IDs, like a posting list (gaps of 1 to 64);
+ * - small counts, mostly below 1000 with a few big ones;
+ * - sensor readings that wander up and down around 20000;
+ * - random 32-bit numbers, which nothing can compress.
+ *
+ * Every codec encodes each list, both decoders must give back exactly the
+ * original, and we print the COMPRESSION RATIO (original size / encoded
+ * size) and the DECODE SPEED in GB/s of decoded numbers (4 bytes each).
+ */
+#define ROUNDS 3 // Each timing is the best of this many runs.
+
+typedef struct
+{
+    const char *name;
+    size_t (*encode)(const uint32_t *values, size_t count, uint8_t *out);
+    void (*decode)(const uint8_t *in, size_t count, uint32_t *out);
+    void (*decode_simd)(const uint8_t *in, size_t count, uint32_t *out); // NULL if there is none.
+} Codec;
+
+static const Codec codecs[] = {
+    {"varint (LEB128)", varint_encode, varint_decode, NULL},
+#if defined(__SSSE3__)
+    {"Stream VByte", stream_vbyte_encode, stream_vbyte_decode, stream_vbyte_decode_simd},
+#else
+    {"Stream VByte", stream_vbyte_encode, stream_vbyte_decode, NULL},
+#endif
+#if defined(__SSE2__)
+    {"FOR bit-packing", for_encode, for_decode, for_decode_simd},
+    {"delta + bit-packing", delta_encode, delta_decode, delta_decode_simd},
+#else
+    {"FOR bit-packing", for_encode, for_decode, NULL},
+    {"delta + bit-packing", delta_encode, delta_decode, NULL},
+#endif
+    {"delta + zigzag varint", delta_varint_encode, delta_varint_decode, NULL},
+};
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void make_data(int kind, uint32_t *values, size_t count, uint64_t *seed)
+{
+    uint32_t current = kind == 2 ? 20000 : 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t random = next_random(seed);
+
+        switch (kind)
+        {
+        case 0: // Sorted IDs
+            current += 1 + (uint32_t)(random % 64);
+            values[i] = current;
+            break;
+        case 1: // Small counts: 9 in 10 below 1000, the rest up to a million
+            values[i] = (uint32_t)(random % 10 != 0 ? (random >> 8) % 1000 : (random >> 8) % 1000000);
+            break;
+        case 2: // Sensor readings: a random walk, 10 steps up or down at most
+            current += (uint32_t)(random % 21) - 10;
+            values[i] = current;
+            break;
+        default: // Random
+            values[i] = (uint32_t)(random >> 32);
+            break;
+        }
+    }
+}
+
+// Decodes ROUNDS times, checks the result, and returns the speed in GB/s
+// (or -1 if the decoder got it wrong).
+static double time_decode(void (*decode)(const uint8_t *, size_t, uint32_t *), const uint8_t *encoded,
+                          const uint32_t *values, size_t count, uint32_t *decoded)
+{
+    double best = 0;
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        double start, elapsed;
+
+        memset(decoded, 0, count * sizeof(uint32_t));
+        start = now_seconds();
+        decode(encoded, count, decoded);
+        elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    if (memcmp(decoded, values, count * sizeof(uint32_t)) != 0)
+    {
+        return -1;
+    }
+    return (double)count * sizeof(uint32_t) / best / 1e9;
+}
+
+int run_benchmark(size_t count)
+{
+    const char *kinds[] = {"sorted IDs (posting list)", "small counts", "sensor readings",
+                           "random 32-bit numbers"};
+    uint32_t *values = malloc(count * sizeof(uint32_t));
+    uint32_t *decoded = malloc(count * sizeof(uint32_t));
+    uint8_t *encoded = malloc(count * 5 + 1024); // Enough for the worst codec.
+    uint64_t seed = 2025;
+    int ok = 1;
+
+    if (values == NULL || decoded == NULL || encoded == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        free(values);
+        free(decoded);
+        free(encoded);
+        return 1;
+    }
+
+    printf("%zu numbers per list (%.1f MB as uint32_t). Decode speed in GB/s of numbers, best of %d runs.\n",
+           count, (double)count * sizeof(uint32_t) / 1e6, ROUNDS);
+    for (int kind = 0; kind < 4; kind++)
+    {
+        make_data(kind, values, count, &seed);
+        printf("\n%-28s %8s %12s %12s\n", kinds[kind], "ratio", "plain C", "SIMD");
+        for (size_t c = 0; c < sizeof(codecs) / sizeof(codecs[0]); c++)
+        {
+            size_t size = codecs[c].encode(values, count, encoded);
+            double plain = time_decode(codecs[c].decode, encoded, values, count, decoded);
+            double simd = codecs[c].decode_simd != NULL
+                              ? time_decode(codecs[c].decode_simd, encoded, values, count, decoded)
+                              : 0;
+
+            printf("  %-26s %7.2fx %12.2f", codecs[c].name, (double)count * sizeof(uint32_t) / (double)size,
+                   plain);
+            if (codecs[c].decode_simd != NULL)
+            {
+                printf(" %12.2f\n", simd);
+            }
+            else
+            {
+                printf(" %12s\n", "-");
+            }
+            if (plain < 0 || simd < 0)
+            {
+                fprintf(stderr, "Error: %s did not decode the %s correctly!\n", codecs[c].name, kinds[kind]);
+                ok = 0;
+            }
+        }
+    }
+
+    free(values);
+    free(decoded);
+    free(encoded);
+    if (!ok)
+    {
+        return 1;
+    }
+#if !defined(__SSSE3__)
+    printf("\n(Compile with -mssse3 or -march=native for the Stream VByte SIMD decoder.)\n");
+#endif
+    printf("Every codec gave back every list exactly.\n");
+    return 0;
+}
+
+static void print_bytes(const uint8_t *bytes, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        printf(" %02x", bytes[i]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const int64_t signed_values[] = {0, -1, 1, -2, 2, -64, 64};
+    const uint64_t varint_values[] = {1, 127, 128, 300, 16384, 4294967295u};
+    const uint32_t stream_values[] = {5, 300, 70000, 16777216};
+    uint32_t readings[BLOCK_VALUES], postings[BLOCK_VALUES], decoded[BLOCK_VALUES];
+    uint8_t buffer[BLOCK_VALUES * 5 + 64];
+    size_t size;
+
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        long long count = atoll(argv[2]);
+
+        if (count < 1000 || count > 200000000LL)
+        {
+            fprintf(stderr, "Error: the count must be between 1000 and 200000000.\n");
+            return 1;
+        }
+        return run_benchmark((size_t)count);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--benchmark <count>]\n", argv[0]);
+        return 1;
+    }
+
+    printf("--- Part 1: Zigzag and Varints ---\n");
+    printf("Zigzag:");
+    for (size_t i = 0; i < sizeof(signed_values) / sizeof(signed_values[0]); i++)
+    {
+        uint64_t encoded = zigzag_encode(signed_values[i]);
+
+        printf(" %lld -> %llu%s", (long long)signed_values[i], (unsigned long long)encoded,
+               zigzag_decode(encoded) == signed_values[i] ? "" : " (WRONG)");
+        printf(i + 1 < sizeof(signed_values) / sizeof(signed_values[0]) ? "," : "\n");
+    }
+    for (size_t i = 0; i < sizeof(varint_values) / sizeof(varint_values[0]); i++)
+    {
+        printf("Varint %10llu ->", (unsigned long long)varint_values[i]);
+        print_bytes(buffer, varint_put(varint_values[i], buffer));
+    }
+
+    printf("\n--- Part 2: Stream VByte ---\n");
+    size = stream_vbyte_encode(stream_values, 4, buffer) - STREAM_VBYTE_PADDING;
+    printf("5, 300, 70000 and 16777216: control byte 0x%02x, then %zu data bytes:", buffer[0], size - 1);
+    print_bytes(buffer + 1, size - 1);
+
+    printf("\n--- Part 3: Frame of Reference ---\n");
+    for (int i = 0; i < BLOCK_VALUES; i++)
+    {
+        readings[i] = 1000 + (uint32_t)((i * 7) % 16); // 128 readings from 1000 to 1015
+        postings[i] = 1000000 + (uint32_t)(i * 5 + i % 3);
+    }
+    size = for_encode(readings, BLOCK_VALUES, buffer);
+    for_decode(buffer, BLOCK_VALUES, decoded);
+    printf("128 readings from 1000 to 1015: reference %u, %u bits each, %zu bytes instead of %zu (%s).\n",
+           (unsigned int)((uint32_t *)buffer)[0], (unsigned int)((uint32_t *)buffer)[1], size,
+           sizeof(readings), memcmp(decoded, readings, sizeof(readings)) == 0 ? "decoded exactly" : "WRONG");
+
+    printf("\n--- Part 4: Delta Encoding ---\n");
+    printf("A posting list: %u %u %u %u %u ...\n", (unsigned int)postings[0], (unsigned int)postings[1],
+           (unsigned int)postings[2], (unsigned int)postings[3], (unsigned int)postings[4]);
+    printf("FOR alone: %zu bytes. ", for_encode(postings, BLOCK_VALUES, buffer));
+    size = delta_encode(postings, BLOCK_VALUES, buffer);
+    delta_decode(buffer, BLOCK_VALUES, decoded);
+    printf("The first value, then gaps %u, %u, %u, ... bit-packed: %zu bytes (%s).\n",
+           (unsigned int)(postings[1] - postings[0]), (unsigned int)(postings[2] - postings[1]),
+           (unsigned int)(postings[3] - postings[2]), size,
+           memcmp(decoded, postings, sizeof(postings)) == 0 ? "decoded exactly" : "WRONG");
+    return 0;
+}
+
+/*
+ * =====================================================================================
+ * |                                    - LESSON END -                                   |
+ * =====================================================================================
+ *
+ * Key Takeaways:
+ *
+ * 1.  Most stored numbers are small, or close to their neighbours. Storing
+ *     them in fewer bits saves memory, and reading less memory is often
+ *     faster, even with the decoding work.
+ * 2.  A VARINT uses 7 bits per byte plus a "more" bit; ZIGZAG first turns
+ *     small negative numbers into small positive ones.
+ * 3.  FRAME OF REFERENCE stores each block of numbers as distances from its
+ *     smallest, bit-packed in just enough bits. DELTA encoding stores the
+ *     gaps of a sorted list, and a prefix sum restores it.
+ * 4.  The LAYOUT decides whether SIMD can help: Stream VByte and the 4-lane
+ *     bit-packing put the information a decoder needs where it can reach
+ *     4 numbers at once.
+ * 5.  No codec wins everywhere. Measure them on YOUR data: random numbers
+ *     don't compress at all.
+ *
+ * HOW TO COMPILE AND RUN THIS CODE:
+ *
+ * 1. Compile the program:
+ *    `gcc -Wall -Wextra -std=c11 -o 21_integer_compression 21_integer_compression.c`
+ * 2. Run the demonstration:
+ *    `./21_integer_compression`
+ * 3. Run the benchmark with optimization (`-march=native` adds the Stream
+ *    VByte SIMD decoder, if your CPU has SSSE3):
+ *    `gcc -Wall -Wextra -std=c11 -O2 -march=native -o 21_integer_compression 21_integer_compression.c`
+ *    `./21_integer_compression --benchmark 10000000`
+ */
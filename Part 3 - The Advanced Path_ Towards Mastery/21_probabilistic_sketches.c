@@ -0,0 +1,900 @@
+/**
+ * @file 21_probabilistic_sketches.c
+ * @brief Part 3, Lesson 21 (continued): Bloom Filters and Other Sketches
+ * @author dunamismax
+ * @date 10-18-2026
+ *
+ * This file continues the bit manipulation lesson. It uses bits and masks to
+ * build PROBABILISTIC data structures: a Bloom filter that rejects misses
+ * cheaply, a count-min sketch that counts events, and a HyperLogLog that
+ * counts distinct items, each in a small, fixed amount of memory.
+ */
+
+/*
+ * =====================================================================================
+ * |                                   - LESSON START -                                  |
+ * =====================================================================================
+ *
+ * Some questions are expensive to answer exactly. "Is this key on disk?"
+ * costs a disk read. "How many different visitors did we have today?" needs
+ * a set of every visitor seen. A SKETCH answers such questions APPROXIMATELY,
+ * in a tiny, fixed amount of memory, with an error we can predict:
+ *
+ * - A BLOOM FILTER answers "might this key be in the set?". "No" is always
+ *   right; "maybe" is sometimes wrong (a FALSE POSITIVE), at a rate we
+ *   choose. Put one in front of a hash table or a disk, and most misses never
+ *   reach them.
+ * - A COUNT-MIN SKETCH estimates how often each key has been seen. It never
+ *   counts too low, and counts too high by at most a chosen fraction of all
+ *   the events.
+ * - A HYPERLOGLOG estimates how many DIFFERENT keys have been seen, to within
+ *   about 1%, in 16 KB, whether there were a thousand or a billion.
+ *
+ * All three are built from Lesson 21's tools: setting and testing bits with
+ * masks, shifts, and a few instructions that count bits.
+ *
+ * This lesson uses functions from <math.h>: compile it with `-lm`, like
+ * Lesson 32.
+ */
+
+#include <math.h>   // For exp(), log(), pow() and friends
+#include <stdint.h> // For uint64_t and friends
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>   // For timespec_get(), to time the benchmark
+
+// --- Part 1: Hashing Once ---
+/*
+ * Every sketch needs several "random" positions for each key. A good HASH
+ * FUNCTION gives them: it turns a key into 64 bits that look random, and a
+ * change to any bit of the key changes about half of the output bits.
+ *
+ * We hash each key ONCE, and the sketches take the hash, not the key. The
+ * caller can reuse the same hash for its hash table, too.
+ *
+ * mix64() is the finalizer of the "splitmix64" generator: it scrambles an
+ * integer key thoroughly in a few instructions. For strings, FNV-1a (as in
+ * libcore and Lesson 28) walks the bytes, and mix64() spreads the result.
+ */
+uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t hash_string(const char *text)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (const unsigned char *byte = (const unsigned char *)text; *byte != '\0'; byte++)
+    {
+        hash ^= *byte;
+        hash *= UINT64_C(1099511628211);
+    }
+    return mix64(hash);
+}
+
+/*
+ * A sketch often needs k positions per key, not one. Computing k hashes
+ * would be slow, but Kirsch and Mitzenmacher showed that two are enough:
+ * position i comes from `h1 + i * h2`. We take h1 as the hash itself and h2
+ * as the hash with its halves swapped (forced to be odd, so the steps never
+ * repeat early).
+ *
+ * To turn a hash into a position between 0 and size - 1, `hash % size`
+ * would work, but division is one of the slowest instructions. reduce()
+ * instead treats the top 32 bits as a fraction between 0 and 1 and
+ * multiplies it by the size: a multiply and a shift (Lemire's "fast range
+ * reduction"). We use the top bits because in `h1 + i * h2`, carries flow
+ * upward, so the top bits depend on all the others. Sizes must be below
+ * 2^32.
+ */
+static inline uint64_t second_hash(uint64_t hash)
+{
+    return (hash << 32 | hash >> 32) | 1;
+}
+
+static inline uint64_t reduce(uint64_t hash, uint64_t size)
+{
+    return ((hash >> 32) * size) >> 32;
+}
+
+// --- Part 2: The Bloom Filter ---
+/*
+ * A Bloom filter is a bitset of m bits, all 0 at first. To ADD a key, set k
+ * bits at positions chosen by its hash. To ask whether it MIGHT CONTAIN a
+ * key, test the same k bits: if any of them is 0, the key was never added.
+ * If all are 1, it probably was, but other keys could have set those bits
+ * by chance: a false positive.
+ *
+ * With n keys, the chance of a false positive is about
+ * (1 - e^(-k*n/m))^k. It is smallest for k = (m/n) * ln 2, about 0.69 bits
+ * per key, which gives roughly 1% with 10 bits per key, and 0.05% with 16.
+ * No matter how big the keys are, the filter needs only those few bits.
+ *
+ * The catch: the k positions are anywhere in the filter. In a big filter,
+ * each of them is a different CACHE LINE, and each one the CPU must fetch
+ * from memory is a CACHE MISS of around 100 ns.
+ */
+typedef struct
+{
+    uint64_t *words;
+    uint64_t bits;  // m, a multiple of 512 (whole cache lines).
+    int hashes;     // k, the number of bits per key.
+} BloomFilter;
+
+// Hashes per key for `bits_per_key`: (m/n) * ln 2, rounded, between 1 and 16.
+static int best_hash_count(double bits_per_key)
+{
+    int hashes = (int)(bits_per_key * 0.6931 + 0.5);
+
+    return hashes < 1 ? 1 : hashes > 16 ? 16 : hashes;
+}
+
+// The number of 512-bit blocks (cache lines) that hold `keys * bits_per_key` bits.
+static uint64_t blocks_for(size_t keys, double bits_per_key)
+{
+    uint64_t blocks = (uint64_t)ceil((double)keys * bits_per_key / 512);
+
+    return blocks > 0 ? blocks : 1;
+}
+
+/*
+ * A filter for `expected_keys` keys, with `bits_per_key` bits each (rounded
+ * up to whole cache lines). Returns 0 if memory ran out or the filter would
+ * need 2^32 bits or more.
+ */
+int bloom_init(BloomFilter *filter, size_t expected_keys, double bits_per_key)
+{
+    filter->bits = blocks_for(expected_keys, bits_per_key) * 512;
+    filter->hashes = best_hash_count(bits_per_key);
+    filter->words = NULL;
+    if (filter->bits >= (UINT64_C(1) << 32))
+    {
+        return 0;
+    }
+    filter->words = aligned_alloc(64, (size_t)filter->bits / 8);
+    if (filter->words == NULL)
+    {
+        return 0;
+    }
+    memset(filter->words, 0, (size_t)filter->bits / 8);
+    return 1;
+}
+
+void bloom_free(BloomFilter *filter)
+{
+    free(filter->words);
+    filter->words = NULL;
+}
+
+void bloom_add(BloomFilter *filter, uint64_t hash)
+{
+    uint64_t step = second_hash(hash);
+
+    for (int i = 0; i < filter->hashes; i++, hash += step)
+    {
+        uint64_t bit = reduce(hash, filter->bits);
+
+        filter->words[bit / 64] |= UINT64_C(1) << (bit % 64);
+    }
+}
+
+// 0 means "definitely not added"; 1 means "probably added".
+int bloom_may_contain(const BloomFilter *filter, uint64_t hash)
+{
+    uint64_t step = second_hash(hash);
+
+    for (int i = 0; i < filter->hashes; i++, hash += step)
+    {
+        uint64_t bit = reduce(hash, filter->bits);
+
+        if ((filter->words[bit / 64] & (UINT64_C(1) << (bit % 64))) == 0)
+        {
+            return 0; // Most misses stop at the first or second bit.
+        }
+    }
+    return 1;
+}
+
+// The expected false positive rate with `keys` keys: (1 - e^(-k*n/m))^k.
+double bloom_predicted_rate(const BloomFilter *filter, size_t keys)
+{
+    return pow(1.0 - exp(-(double)filter->hashes * (double)keys / (double)filter->bits), filter->hashes);
+}
+
+// --- Part 3: The Blocked Bloom Filter ---
+/*
+ * A BLOCKED Bloom filter (Putze, Sanders and Singler) splits the bits into
+ * BLOCKS of 512 bits: exactly one 64-byte cache line. The top bits of the
+ * hash choose a block, and all of the key's bits go into that block. Adding
+ * a key, or finding one that is there, costs ONE cache miss instead of k.
+ * (For a miss the gap is smaller: the standard filter usually stops at its
+ * first or second bit. The benchmark times both.)
+ *
+ * We use the "split block" layout of Apache Parquet and Impala: a block is
+ * 8 words of 64 bits, and a key sets exactly ONE bit in EACH word, so k is
+ * always 8. The bit in word w comes from multiplying 32 bits of the hash by
+ * a fixed odd number, a SALT, different for each word, and keeping the top 6
+ * bits of the product: a position from 0 to 63. The key's MASK is then 8
+ * words, built without a single branch, and we use Lesson 21's patterns on
+ * whole words:
+ *
+ *   add:    block[w] |= mask[w]                  (set bits)
+ *   test:   (mask[w] & ~block[w]) == 0 for all w (are all the mask bits set?)
+ *
+ * The test has no early exit either, so the CPU never mispredicts it. With
+ * `-march=native` the compiler does all 8 words with a few SIMD instructions.
+ *
+ * The price is a slightly higher false positive rate for the same memory:
+ * some blocks get more keys than others, and those fill up. Add a bit or
+ * two per key to make up for it.
+ */
+#define BLOCK_BITS 512
+#define BLOCK_WORDS (BLOCK_BITS / 64) // Also k: one bit per word.
+
+static const uint32_t block_salts[BLOCK_WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+typedef struct
+{
+    uint64_t *words;
+    uint64_t blocks; // Of 512 bits each.
+} BlockedBloomFilter;
+
+// The same size as bloom_init() would choose.
+int blocked_init(BlockedBloomFilter *filter, size_t expected_keys, double bits_per_key)
+{
+    filter->blocks = blocks_for(expected_keys, bits_per_key);
+    filter->words = NULL;
+    if (filter->blocks >= (UINT64_C(1) << 32))
+    {
+        return 0;
+    }
+    filter->words = aligned_alloc(64, (size_t)filter->blocks * (BLOCK_BITS / 8)); // Blocks = aligned cache lines.
+    if (filter->words == NULL)
+    {
+        return 0;
+    }
+    memset(filter->words, 0, (size_t)filter->blocks * (BLOCK_BITS / 8));
+    return 1;
+}
+
+void blocked_free(BlockedBloomFilter *filter)
+{
+    free(filter->words);
+    filter->words = NULL;
+}
+
+// The key's bit in word `w`. It uses the low 32 bits of the hash, so it
+// doesn't depend on the top bits that chose the block.
+static inline uint64_t block_mask(uint64_t hash, int w)
+{
+    return UINT64_C(1) << (((uint32_t)hash * block_salts[w]) >> 26);
+}
+
+static inline uint64_t *find_block(const BlockedBloomFilter *filter, uint64_t hash)
+{
+    return filter->words + reduce(hash, filter->blocks) * BLOCK_WORDS;
+}
+
+void blocked_add(BlockedBloomFilter *filter, uint64_t hash)
+{
+    uint64_t *block = find_block(filter, hash);
+
+    for (int w = 0; w < BLOCK_WORDS; w++)
+    {
+        block[w] |= block_mask(hash, w);
+    }
+}
+
+int blocked_may_contain(const BlockedBloomFilter *filter, uint64_t hash)
+{
+    const uint64_t *block = find_block(filter, hash);
+    uint64_t missing = 0;
+
+    for (int w = 0; w < BLOCK_WORDS; w++)
+    {
+        missing |= block_mask(hash, w) & ~block[w]; // Mask bits that are not set in the block.
+    }
+    return missing == 0;
+}
+
+/*
+ * The expected false positive rate. A block gets j keys with the POISSON
+ * probability e^(-λ) * λ^j / j!, where λ is the average number of keys per
+ * block. With j keys in a block, each of its words has a bit set with
+ * chance 1 - (1 - 1/64)^j, and a false positive needs all 8 of our bits
+ * set. We add up those rates for every j, weighted by how likely each j is.
+ */
+double blocked_predicted_rate(const BlockedBloomFilter *filter, size_t keys)
+{
+    double lambda = (double)keys / (double)filter->blocks;
+    double probability = exp(-lambda); // Of j = 0 keys in a block.
+    double rate = 0;
+
+    for (int j = 0; j < lambda * 3 + 100; j++)
+    {
+        rate += probability * pow(1.0 - pow(1.0 - 1.0 / 64, j), BLOCK_WORDS);
+        probability *= lambda / (j + 1);
+    }
+    return rate;
+}
+
+// --- Part 4: The Count-Min Sketch ---
+/*
+ * "How many times has this key been seen?" for millions of keys would need
+ * a counter per key. A COUNT-MIN SKETCH (Cormode and Muthukrishnan) keeps a
+ * small grid of counters instead: `depth` rows of `width` counters. Each row
+ * has its own position for each key:
+ *
+ *   add(key):      counter[row][position(row, key)] += 1, for every row
+ *   estimate(key): the SMALLEST of those counters
+ *
+ * Other keys share counters with ours, so each counter can only be too HIGH.
+ * Taking the minimum picks the row where our key had the least company. With
+ * N events, width = e/ε and depth = ln(1/δ), the estimate is too high by
+ * more than ε*N for at most a fraction δ of the keys.
+ *
+ * Counters are 32 bits; a stream of more than 4 billion events would need
+ * bigger ones.
+ */
+typedef struct
+{
+    uint32_t *counters; // depth rows of width counters.
+    int depth;
+    uint64_t width;
+    uint64_t events;    // N, the total of all the counts added.
+} CountMinSketch;
+
+// A sketch with error at most `epsilon * N`, except for a fraction `delta` of keys.
+int countmin_init(CountMinSketch *sketch, double epsilon, double delta)
+{
+    sketch->width = (uint64_t)ceil(exp(1.0) / epsilon);
+    sketch->depth = (int)ceil(log(1.0 / delta));
+    sketch->events = 0;
+    sketch->counters = calloc((size_t)sketch->depth * (size_t)sketch->width, sizeof(uint32_t));
+    return sketch->counters != NULL;
+}
+
+void countmin_free(CountMinSketch *sketch)
+{
+    free(sketch->counters);
+    sketch->counters = NULL;
+}
+
+void countmin_add(CountMinSketch *sketch, uint64_t hash, uint32_t count)
+{
+    uint64_t step = second_hash(hash);
+    uint32_t *row = sketch->counters;
+
+    for (int i = 0; i < sketch->depth; i++, hash += step, row += sketch->width)
+    {
+        row[reduce(hash, sketch->width)] += count;
+    }
+    sketch->events += count;
+}
+
+uint32_t countmin_estimate(const CountMinSketch *sketch, uint64_t hash)
+{
+    uint64_t step = second_hash(hash);
+    const uint32_t *row = sketch->counters;
+    uint32_t smallest = UINT32_MAX;
+
+    for (int i = 0; i < sketch->depth; i++, hash += step, row += sketch->width)
+    {
+        uint32_t counter = row[reduce(hash, sketch->width)];
+
+        if (counter < smallest)
+        {
+            smallest = counter;
+        }
+    }
+    return smallest;
+}
+
+// The error bound ε*N, with the ε our rounded-up width actually gives.
+double countmin_error_bound(const CountMinSketch *sketch)
+{
+    return exp(1.0) / (double)sketch->width * (double)sketch->events;
+}
+
+// --- Part 5: HyperLogLog ---
+/*
+ * How many DIFFERENT keys are in a stream? Look at the hashes: half of all
+ * hashes start with a 0 bit, a quarter with 00, one in 2^r with r zeros. If
+ * the most leading zeros we have seen is r, we have probably seen about 2^r
+ * different keys (repeats of a key have the same hash, so they don't count).
+ *
+ * One such guess is very rough, so HYPERLOGLOG (Flajolet and others) makes
+ * thousands. The first p bits of the hash pick one of m = 2^p REGISTERS,
+ * and each register remembers the longest run of leading zeros (plus one,
+ * the RANK) in the rest of the hashes that came to it. The estimate combines
+ * all registers with a HARMONIC MEAN, which tames the lucky ones:
+ *
+ *   estimate = α * m² / (2^-register[0] + ... + 2^-register[m-1])
+ *
+ * The typical error is 1.04 / sqrt(m): with p = 14, m = 16384 registers of
+ * one byte each, that is 0.81% in 16 KB. When many registers are still 0
+ * (few keys), LINEAR COUNTING, m * ln(m / empty registers), is more
+ * accurate, and we use it instead.
+ *
+ * Two sketches MERGE by taking the larger register of each pair: count the
+ * visitors on each server, then combine them as if one sketch saw it all.
+ */
+#define HLL_PRECISION 14
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+typedef struct
+{
+    uint8_t registers[HLL_REGISTERS];
+} HyperLogLog;
+
+// The number of 0 bits above the highest 1 bit. `word` must not be 0.
+static inline int leading_zeros(uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_clzll(word);
+#else
+    int zeros = 0;
+
+    while ((word & (UINT64_C(1) << 63)) == 0)
+    {
+        word <<= 1;
+        zeros++;
+    }
+    return zeros;
+#endif
+}
+
+void hll_init(HyperLogLog *hll)
+{
+    memset(hll->registers, 0, sizeof(hll->registers));
+}
+
+void hll_add(HyperLogLog *hll, uint64_t hash)
+{
+    size_t index = hash >> (64 - HLL_PRECISION);
+    // The remaining bits, moved to the top. The extra 1 bit below them stops
+    // the count of zeros at 64 - p, even if they are all 0.
+    uint64_t rest = hash << HLL_PRECISION | UINT64_C(1) << (HLL_PRECISION - 1);
+    uint8_t rank = (uint8_t)(leading_zeros(rest) + 1);
+
+    if (rank > hll->registers[index])
+    {
+        hll->registers[index] = rank;
+    }
+}
+
+void hll_merge(HyperLogLog *into, const HyperLogLog *other)
+{
+    for (size_t i = 0; i < HLL_REGISTERS; i++)
+    {
+        if (other->registers[i] > into->registers[i])
+        {
+            into->registers[i] = other->registers[i];
+        }
+    }
+}
+
+double hll_estimate(const HyperLogLog *hll)
+{
+    double m = HLL_REGISTERS;
+    double sum = 0;
+    double estimate;
+    size_t empty = 0;
+
+    for (size_t i = 0; i < HLL_REGISTERS; i++)
+    {
+        sum += ldexp(1.0, -hll->registers[i]); // 2^-register
+        empty += hll->registers[i] == 0;
+    }
+    estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum; // α for large m is 0.7213 / (1 + 1.079 / m).
+    if (estimate <= 2.5 * m && empty > 0)
+    {
+        estimate = m * log(m / (double)empty);
+    }
+    return estimate;
+}
+
+// --- Part 6: Measuring Them ---
+/*
+ * `./21_probabilistic_sketches --benchmark 10000000` checks every promise
+ * made above, and times each operation (including hashing the key):
+ *
+ * 1. Bloom filters of 8, 10 and 16 bits per key, standard and blocked:
+ *    no inserted key may be missing, and the false positive rate measured
+ *    on keys that were never inserted should match the prediction. With
+ *    millions of keys the filters are bigger than the CPU's caches, and the
+ *    blocked filter's single cache miss per add or hit shows.
+ * 2. Count-min sketches of three widths, over a skewed stream where a few
+ *    keys are very common (as in real traffic): no estimate may be too low,
+ *    and at most δ of them may exceed the bound.
+ * 3. HyperLogLog, counting from a thousand to all the keys: the error
+ *    should stay within a few times 1.04 / sqrt(m).
+ *
+ * A key's hash is mix64(key + a seed), so each test gets its own keys.
+ */
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static uint64_t key_hash(uint64_t key, uint64_t seed)
+{
+    return mix64(key + seed);
+}
+
+// Measured false positives may exceed the prediction by chance, but hardly
+// ever by 5 standard deviations.
+static int rate_is_plausible(double measured, double predicted, size_t trials)
+{
+    return measured <= predicted + 5.0 * sqrt(predicted / (double)trials) + 1.0 / (double)trials;
+}
+
+static int benchmark_bloom(size_t keys)
+{
+    const double bits_per_key[] = {8, 10, 16};
+    int ok = 1;
+
+    printf("Bloom filters: %zu keys added, then %zu other keys looked up.\n", keys, keys);
+    printf("%-10s %9s %7s %8s %13s %12s %10s %10s %10s\n", "Filter", "bits/key", "hashes", "MB", "predicted FP",
+           "measured FP", "add (ns)", "hit (ns)", "miss (ns)");
+    for (size_t b = 0; b < sizeof(bits_per_key) / sizeof(bits_per_key[0]); b++)
+    {
+        for (int blocked = 0; blocked <= 1; blocked++)
+        {
+            BloomFilter standard;
+            BlockedBloomFilter block;
+            size_t found = 0, false_positives = 0;
+            double start, add_time, hit_time, miss_time, predicted, megabytes, actual_bits_per_key;
+            int hashes;
+
+            if (blocked ? !blocked_init(&block, keys, bits_per_key[b]) : !bloom_init(&standard, keys, bits_per_key[b]))
+            {
+                fprintf(stderr, "Error: Memory allocation failed!\n");
+                exit(1);
+            }
+
+            start = now_seconds();
+            for (uint64_t key = 0; key < keys; key++)
+            {
+                if (blocked)
+                {
+                    blocked_add(&block, key_hash(key, 1));
+                }
+                else
+                {
+                    bloom_add(&standard, key_hash(key, 1));
+                }
+            }
+            add_time = now_seconds() - start;
+
+            start = now_seconds();
+            for (uint64_t key = 0; key < keys; key++)
+            {
+                found += blocked ? blocked_may_contain(&block, key_hash(key, 1))
+                                 : bloom_may_contain(&standard, key_hash(key, 1));
+            }
+            hit_time = now_seconds() - start;
+
+            start = now_seconds();
+            for (uint64_t key = keys; key < 2 * keys; key++)
+            {
+                false_positives += blocked ? blocked_may_contain(&block, key_hash(key, 1))
+                                           : bloom_may_contain(&standard, key_hash(key, 1));
+            }
+            miss_time = now_seconds() - start;
+
+            if (blocked)
+            {
+                predicted = blocked_predicted_rate(&block, keys);
+                megabytes = (double)block.blocks * (BLOCK_BITS / 8) / 1e6;
+                hashes = BLOCK_WORDS;
+                blocked_free(&block);
+            }
+            else
+            {
+                predicted = bloom_predicted_rate(&standard, keys);
+                megabytes = (double)standard.bits / 8 / 1e6;
+                hashes = standard.hashes;
+                bloom_free(&standard);
+            }
+            actual_bits_per_key = megabytes * 8e6 / (double)keys;
+
+            printf("%-10s %9.1f %7d %8.2f %12.3f%% %11.3f%% %10.1f %10.1f %10.1f\n", blocked ? "blocked" : "standard",
+                   actual_bits_per_key, hashes, megabytes, predicted * 100,
+                   (double)false_positives / (double)keys * 100, add_time * 1e9 / (double)keys,
+                   hit_time * 1e9 / (double)keys, miss_time * 1e9 / (double)keys);
+
+            if (found != keys)
+            {
+                fprintf(stderr, "Error: the filter lost %zu keys!\n", keys - found);
+                ok = 0;
+            }
+            if (!rate_is_plausible((double)false_positives / (double)keys, predicted, keys))
+            {
+                fprintf(stderr, "Error: far more false positives than predicted!\n");
+                ok = 0;
+            }
+        }
+    }
+    return ok;
+}
+
+/*
+ * A skewed stream of keys from 0 to `limit`: key k comes up about
+ * 1 / ((k + 1)(k + 2)) of the time, so key 0 is half of the stream and most
+ * keys are rare. (1/u for a uniform u between 0 and 1 gives that shape.)
+ */
+static uint64_t skewed_key(uint64_t *state, uint64_t limit)
+{
+    uint64_t key;
+    double uniform;
+
+    *state = mix64(*state + 1);
+    uniform = (double)((*state >> 11) + 1) / 9007199254740992.0; // 53 random bits, never 0.
+    key = (uint64_t)(1.0 / uniform) - 1;
+    return key < limit ? key : limit;
+}
+
+static int benchmark_countmin(size_t keys)
+{
+    const double epsilons[] = {0.01, 0.001, 0.0001};
+    const double delta = 0.01;
+    size_t events = keys * 4;
+    uint32_t *exact = calloc(keys + 1, sizeof(uint32_t));
+    uint64_t state = 99;
+    int ok = 1;
+
+    if (exact == NULL)
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < events; i++)
+    {
+        exact[skewed_key(&state, keys)]++;
+    }
+
+    printf("\nCount-min sketches: %zu events over keys 0 to %zu, δ = %.2f.\n", events, keys, delta);
+    printf("%-10s %6s %8s %12s %14s %14s %11s %11s\n", "ε", "depth", "KB", "bound ε*N", "average error",
+           "over bound", "add (ns)", "query (ns)");
+    for (size_t e = 0; e < sizeof(epsilons) / sizeof(epsilons[0]); e++)
+    {
+        CountMinSketch sketch;
+        size_t seen = 0, over_bound = 0, too_low = 0;
+        double start, add_time, query_time, bound, total_error = 0;
+
+        if (!countmin_init(&sketch, epsilons[e], delta))
+        {
+            fprintf(stderr, "Error: Memory allocation failed!\n");
+            exit(1);
+        }
+
+        state = 99; // Replay the same stream.
+        start = now_seconds();
+        for (size_t i = 0; i < events; i++)
+        {
+            countmin_add(&sketch, key_hash(skewed_key(&state, keys), 2), 1);
+        }
+        add_time = now_seconds() - start;
+        bound = countmin_error_bound(&sketch);
+
+        start = now_seconds();
+        for (uint64_t key = 0; key <= keys; key++)
+        {
+            uint32_t estimate = countmin_estimate(&sketch, key_hash(key, 2));
+
+            if (exact[key] == 0)
+            {
+                continue; // Only judge keys that appeared.
+            }
+            seen++;
+            too_low += estimate < exact[key];
+            over_bound += estimate - exact[key] > bound;
+            total_error += estimate - exact[key];
+        }
+        query_time = now_seconds() - start;
+
+        printf("%-10g %6d %8.1f %12.1f %14.2f %13.3f%% %11.1f %11.1f\n", epsilons[e], sketch.depth,
+               (double)sketch.depth * (double)sketch.width * sizeof(uint32_t) / 1e3, bound,
+               total_error / (double)seen, (double)over_bound / (double)seen * 100, add_time * 1e9 / (double)events,
+               query_time * 1e9 / (double)(keys + 1));
+
+        if (too_low > 0)
+        {
+            fprintf(stderr, "Error: %zu estimates were below the true count!\n", too_low);
+            ok = 0;
+        }
+        if (!rate_is_plausible((double)over_bound / (double)seen, delta, seen))
+        {
+            fprintf(stderr, "Error: too many estimates exceeded the error bound!\n");
+            ok = 0;
+        }
+        countmin_free(&sketch);
+    }
+    free(exact);
+    return ok;
+}
+
+static int benchmark_hyperloglog(size_t keys)
+{
+    HyperLogLog hll;
+    double typical = 1.04 / sqrt(HLL_REGISTERS);
+    size_t added = 0;
+    double start = now_seconds();
+    int ok = 1;
+
+    printf("\nHyperLogLog: %d registers (%zu KB), typical error %.2f%%.\n", HLL_REGISTERS,
+           sizeof(hll.registers) / 1024, typical * 100);
+    printf("%-14s %14s %10s\n", "Distinct keys", "Estimate", "Error");
+    hll_init(&hll);
+    for (size_t target = 1000; target <= keys; target = target * 10 <= keys || target == keys ? target * 10 : keys)
+    {
+        double estimate, error;
+
+        for (; added < target; added++)
+        {
+            hll_add(&hll, key_hash(added, 3));
+            hll_add(&hll, key_hash(added / 2, 3)); // A repeat: it must not count.
+        }
+        estimate = hll_estimate(&hll);
+        error = (estimate - (double)target) / (double)target;
+        printf("%-14zu %14.0f %9.2f%%\n", target, estimate, error * 100);
+        ok = ok && fabs(error) < 5 * typical;
+        if (target == keys)
+        {
+            break;
+        }
+    }
+    printf("%.1f ns per add. An exact set of %zu 8-byte keys needs at least %.1f MB.\n",
+           (now_seconds() - start) * 1e9 / (double)(2 * added), keys, (double)keys * 8 / 1e6);
+    if (!ok)
+    {
+        fprintf(stderr, "Error: the HyperLogLog estimate was too far off!\n");
+    }
+    return ok;
+}
+
+int run_benchmark(size_t keys)
+{
+    int ok = benchmark_bloom(keys);
+
+    ok = benchmark_countmin(keys) && ok;
+    ok = benchmark_hyperloglog(keys) && ok;
+    if (!ok)
+    {
+        return 1;
+    }
+    printf("All sketches stayed within their error bounds.\n");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *words[] = {"the", "cat", "sat", "on", "the", "mat", "and", "the", "dog", "sat", "on", "the", "cat"};
+    BlockedBloomFilter users;
+    CountMinSketch counts;
+    HyperLogLog monday, tuesday;
+    char name[32];
+    int found = 0, false_positives = 0;
+
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        long long keys = atoll(argv[2]);
+
+        if (keys < 1000 || keys > 100000000LL)
+        {
+            fprintf(stderr, "Error: the key count must be between 1000 and 100000000.\n");
+            return 1;
+        }
+        return run_benchmark((size_t)keys);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--benchmark <keys>]\n", argv[0]);
+        return 1;
+    }
+
+    printf("--- Part 1: A Bloom Filter of Usernames ---\n");
+    if (!blocked_init(&users, 1000, 10))
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        return 1;
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(name, sizeof(name), "user%d", i);
+        blocked_add(&users, hash_string(name));
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(name, sizeof(name), "user%d", i);
+        found += blocked_may_contain(&users, hash_string(name));
+    }
+    for (int i = 0; i < 10000; i++)
+    {
+        snprintf(name, sizeof(name), "guest%d", i);
+        false_positives += blocked_may_contain(&users, hash_string(name));
+    }
+    printf("1000 usernames in %zu bytes, with %d bits set for each.\n", (size_t)users.blocks * (BLOCK_BITS / 8),
+           BLOCK_WORDS);
+    printf("Found all %d usernames: a Bloom filter never forgets a key.\n", found);
+    printf("10000 names never added: %d false positives (%.2f%%, predicted %.2f%%).\n", false_positives,
+           false_positives / 100.0, blocked_predicted_rate(&users, 1000) * 100);
+    printf("Only those %d lookups would go on to the real user table.\n", false_positives);
+    blocked_free(&users);
+
+    printf("\n--- Part 2: Counting Words With a Count-Min Sketch ---\n");
+    if (!countmin_init(&counts, 0.1, 0.05))
+    {
+        fprintf(stderr, "Error: Memory allocation failed!\n");
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+    {
+        countmin_add(&counts, hash_string(words[i]), 1);
+    }
+    printf("%zu words in %d rows of %d counters. Estimated counts (never too low):\n",
+           sizeof(words) / sizeof(words[0]), counts.depth, (int)counts.width);
+    printf("  the: %u, cat: %u, sat: %u, mat: %u, bird: %u\n", countmin_estimate(&counts, hash_string("the")),
+           countmin_estimate(&counts, hash_string("cat")), countmin_estimate(&counts, hash_string("sat")),
+           countmin_estimate(&counts, hash_string("mat")), countmin_estimate(&counts, hash_string("bird")));
+    countmin_free(&counts);
+
+    printf("\n--- Part 3: Counting Visitors With HyperLogLog ---\n");
+    hll_init(&monday);
+    hll_init(&tuesday);
+    for (uint64_t visitor = 0; visitor < 300000; visitor++)
+    {
+        hll_add(&monday, key_hash(visitor, 0));
+        hll_add(&monday, key_hash(visitor, 0)); // Everyone visits twice.
+        hll_add(&tuesday, key_hash(visitor + 200000, 0));
+    }
+    printf("Monday: 300000 visitors, estimated %.0f.\n", hll_estimate(&monday));
+    printf("Tuesday: 300000 visitors, 100000 of them from Monday, estimated %.0f.\n", hll_estimate(&tuesday));
+    hll_merge(&monday, &tuesday);
+    printf("Both days (merged): 500000 visitors, estimated %.0f, in %zu bytes.\n", hll_estimate(&monday),
+           sizeof(monday.registers));
+    return 0;
+}
+
+/*
+ * =====================================================================================
+ * |                                    - LESSON END -                                   |
+ * =====================================================================================
+ *
+ * Key Takeaways:
+ *
+ * 1.  A SKETCH trades a small, predictable error for a huge saving in memory
+ *     and time. Know which way the error goes: a Bloom filter never says
+ *     "no" wrongly, and a count-min sketch never counts too low.
+ * 2.  Hash each key once, and derive every position you need from it with
+ *     `h1 + i * h2`. A multiply and a shift turn a hash into a position.
+ * 3.  A BLOOM FILTER sets k bits per key. About 10 bits per key give a 1%
+ *     false positive rate, whatever the size of the keys.
+ * 4.  A BLOCKED Bloom filter keeps each key's bits in one cache line, so an
+ *     add or a hit costs one cache miss, and tests them with whole-word masks.
+ * 5.  A COUNT-MIN SKETCH estimates counts as the minimum over a few rows of
+ *     shared counters; a HYPERLOGLOG estimates distinct keys from the
+ *     longest runs of leading zeros in their hashes.
+ *
+ * HOW TO COMPILE AND RUN THIS CODE:
+ *
+ * 1. Compile the program (it uses <math.h>, so add `-lm` at the end):
+ *    `gcc -Wall -Wextra -std=c11 -o 21_probabilistic_sketches 21_probabilistic_sketches.c -lm`
+ * 2. Run the demonstration:
+ *    `./21_probabilistic_sketches`
+ * 3. Run the benchmark (add -O2 when compiling, for numbers that mean
+ *    something):
+ *    `./21_probabilistic_sketches --benchmark 10000000`
+ */
@@ -44,6 +44,11 @@
 // library provides a powerful math library. Its header is `<math.h>`.
 // This gives us access to declarations for functions like `sqrt()` (square root)
 // and `pow()` (power).
+//
+// M_PI, used below, is not part of ISO C: it comes from POSIX. With a strict
+// `-std=c11` or `-std=c23`, <math.h> hides it unless we ask for the extras
+// first, before any #include.
+#define _DEFAULT_SOURCE 1
 #include <stdio.h>
 #include <math.h>
 
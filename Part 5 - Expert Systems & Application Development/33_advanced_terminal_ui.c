@@ -29,7 +29,11 @@
  *
  * NCURSES is the foundation for many classic terminal applications, like the
  * text editor `vim`, the system monitor `htop`, and many more. This lesson
- * will introduce you to the basic building blocks.
+ * will introduce you to the basic building blocks, and then look under the
+ * hood: we build a tiny double-buffered renderer of our own to see how a
+ * library like ncurses updates the screen without flickering, an event
+ * loop that lets a program keep working while it waits for a key, and a
+ * list that can scroll through millions of rows.
  *
  * IMPORTANT: This program will take over your terminal screen. It will look
  * different from our previous programs!
@@ -37,25 +41,191 @@
 
 // To use ncurses, you must include its header file.
 #include <ncurses.h>
-#include <unistd.h> // We'll use sleep() for a small delay.
+#include <errno.h>
+#include <fcntl.h>     // For making the resize pipe non-blocking
+#include <poll.h>      // For poll(), the heart of the event loop
+#include <signal.h>    // For hearing about terminal resizes (SIGWINCH)
+#include <stdio.h>
+#include <stdlib.h>    // For malloc() and free()
+#include <string.h>    // For strcmp() and memcpy()
+#include <sys/ioctl.h> // For asking the terminal how big it is
+#include <termios.h>   // For reading keys without waiting for Enter
+#include <time.h>      // For timespec_get(), to time our frames
+#include <unistd.h>
+
+// --- Constants ---
+#define FRAMES_PER_SECOND 60
+#define FRAME_NANOSECONDS (1000000000LL / FRAMES_PER_SECOND)
+#define LOADING_BAR_WIDTH 40
+#define STATUS_ROW 17 // Below the info window.
+#define BENCHMARK_ROWS 40
+#define BENCHMARK_COLS 120
+// The most bytes one cell can cost: a cursor move (up to 12 bytes), a color
+// change (up to 14) and the character itself.
+#define MAX_CELL_BYTES 32
+#define LIST_DEMO_ROWS 10000000L   // The virtual list's default size: ten million rows.
+#define LIST_ROW_SIZE 256          // Room for the text of one row.
+
+// --- Data Structures for Part 3 ---
+
+// One character cell of the screen: the character and which color it has.
+typedef struct
+{
+    char ch;
+    unsigned char color; // An index into color_codes[] below.
+} Cell;
+
+// A screen with two buffers. We draw the next frame into `back`, while
+// `front` remembers what the terminal shows right now.
+typedef struct
+{
+    int rows;
+    int cols;
+    Cell *front;
+    Cell *back;
+    // The escape sequences for one frame are collected here and sent to the
+    // terminal in a single write, so it never shows a half-drawn frame.
+    char *output;
+    size_t output_length;
+    int cursor_row; // Where the terminal's cursor is, or -1 if we don't know.
+    int cursor_col;
+    int color;      // The terminal's current color, or -1 if we don't know.
+} Screen;
+
+// --- Data Structures for Part 4 ---
+
+// What woke the event loop up.
+typedef enum
+{
+    EVENT_INPUT,  // There are keys to read.
+    EVENT_TIMER,  // The timer is due.
+    EVENT_RESIZE, // The terminal changed size.
+    EVENT_HANGUP  // The input is gone (e.g. the terminal was closed).
+} EventType;
+
+typedef struct
+{
+    int input_fd;              // Where keys come from, usually STDIN_FILENO.
+    long long timer_interval;  // Nanoseconds between timer events; 0 for no timer.
+    long long next_timer;      // When the timer is due next.
+} EventLoop;
+
+// --- Data Structures for Part 5 ---
+
+// A list asks its DATA SOURCE for the text of one row whenever it is about
+// to draw that row. `context` is whatever the data source needs; the list
+// just hands it back.
+typedef void (*RowSource)(void *context, long row, char *buffer, size_t size);
+
+// A scrolling list that can be millions of rows long. It stores no rows at
+// all: only which rows are on screen right now.
+typedef struct
+{
+    WINDOW *win;      // A bordered window; the rows go inside the border.
+    long row_count;
+    long top;         // The first row on screen.
+    long selected;    // The highlighted row.
+    RowSource source;
+    void *context;
+} VirtualList;
+
+// The demo's data source: student records made up from the row number.
+typedef struct
+{
+    long rows_fetched; // How many rows the list has asked for so far.
+} StudentRecords;
 
 // --- Function Prototypes ---
 // Good practice to declare our functions before main.
 void initialize_ncurses(void);
 void cleanup_ncurses(void);
-void draw_ui(void);
+void draw_ui(int animate);
+void wait_for_key(void);
+void resize_ncurses_screen(void);
+void animate_loading_bar(int row, int col);
+long long now_nanoseconds(void);
+void wait_for_next_frame(long long *deadline);
+Screen *screen_create(int rows, int cols);
+void screen_destroy(Screen *screen);
+void screen_clear(Screen *screen);
+void screen_put_text(Screen *screen, int row, int col, const char *text, unsigned char color);
+void screen_emit(Screen *screen, const char *text, size_t length);
+void screen_move_cursor(Screen *screen, int row, int col);
+size_t screen_present(Screen *screen, int full_repaint, FILE *terminal);
+void draw_bouncing_box(Screen *screen, int frame);
+void draw_wave(Screen *screen, int frame);
+int run_renderer_demo(void);
+int run_render_benchmark(int frames);
+void handle_resize_signal(int signal_number);
+int event_loop_init(EventLoop *loop, int input_fd, long long timer_interval);
+EventType event_loop_wait(EventLoop *loop);
+void event_loop_close(EventLoop *loop);
+int terminal_size(int *rows, int *cols);
+void list_init(VirtualList *list, WINDOW *win, long row_count, RowSource source, void *context);
+int list_visible_rows(const VirtualList *list);
+void list_move(VirtualList *list, long delta);
+int list_handle_key(VirtualList *list, int key);
+void list_draw(VirtualList *list);
+void student_record_row(void *context, long row, char *buffer, size_t size);
+int run_list_demo(long row_count);
+int run_list_benchmark(int scrolls);
 
 // --- The Main Function ---
 
-int main(void)
+int main(int argc, char *argv[])
 {
+    if (argc == 2 && strcmp(argv[1], "--double-buffer") == 0)
+    {
+        return run_renderer_demo();
+    }
+    if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        int frames = atoi(argv[2]);
+
+        if (frames < 1)
+        {
+            fprintf(stderr, "Error: the frame count must be a positive number.\n");
+            return 1;
+        }
+        return run_render_benchmark(frames);
+    }
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--list") == 0)
+    {
+        long row_count = argc == 3 ? atol(argv[2]) : LIST_DEMO_ROWS;
+
+        if (row_count < 1)
+        {
+            fprintf(stderr, "Error: the row count must be a positive number.\n");
+            return 1;
+        }
+        return run_list_demo(row_count);
+    }
+    if (argc == 3 && strcmp(argv[1], "--benchmark-list") == 0)
+    {
+        int scrolls = atoi(argv[2]);
+
+        if (scrolls < 1)
+        {
+            fprintf(stderr, "Error: the scroll count must be a positive number.\n");
+            return 1;
+        }
+        return run_list_benchmark(scrolls);
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--double-buffer | --benchmark <frames> | --list [rows] | --benchmark-list <scrolls>]\n",
+                argv[0]);
+        return 1;
+    }
+
     initialize_ncurses();
 
-    draw_ui();
+    draw_ui(1);
 
     // After drawing, we wait for the user to press any key before exiting.
-    // getch() is the ncurses function to get a single character of input.
-    getch();
+    // getch() would do that, but it freezes the program until the key comes.
+    // wait_for_key() keeps the screen alive while it waits (see Part 4).
+    wait_for_key();
 
     cleanup_ncurses();
 
@@ -121,7 +291,7 @@ void cleanup_ncurses(void)
  * in-memory representation of the screen first. Nothing appears on the actual
  * terminal until you call `refresh()`.
  */
-void draw_ui(void)
+void draw_ui(int animate)
 {
     // Clear the screen
     clear();
@@ -142,7 +312,12 @@ void draw_ui(void)
     // the physical terminal to show what we've drawn.
     refresh();
 
-    sleep(2); // Pause for 2 seconds to let the user see the first part.
+    // Instead of just pausing, we animate a loading bar for a moment. See
+    // animate_loading_bar() below for how an animation keeps a steady speed.
+    if (animate)
+    {
+        animate_loading_bar(4, 24);
+    }
 
     // --- Creating a WINDOW ---
     // A WINDOW is a rectangular subsection of the screen that you can draw on
@@ -173,6 +348,986 @@ void draw_ui(void)
 
     // To display the window, we must refresh IT.
     wrefresh(info_win);
+
+    // What the window drew stays on the screen after the WINDOW is deleted.
+    // draw_ui() makes a new one each time the screen is redrawn.
+    delwin(info_win);
+}
+
+/*
+ * An animation is a series of FRAMES, drawn one after another at a steady
+ * rate. 60 frames per second is smooth to the eye, so each frame gets
+ * 1/60th of a second (about 16.7 ms): we draw it, and then wait until the
+ * next frame is due. We wait for a DEADLINE rather than for a fixed time,
+ * so time spent drawing doesn't slow the animation down.
+ */
+void animate_loading_bar(int row, int col)
+{
+    long long deadline = now_nanoseconds();
+
+    for (int frame = 0; frame <= 2 * FRAMES_PER_SECOND; frame++) // Two seconds.
+    {
+        int filled = frame * LOADING_BAR_WIDTH / (2 * FRAMES_PER_SECOND);
+
+        mvprintw(row, col, "[");
+        for (int i = 0; i < LOADING_BAR_WIDTH; i++)
+        {
+            addch(i < filled ? '#' : ' ');
+        }
+        printw("] %3d%%", frame * 100 / (2 * FRAMES_PER_SECOND));
+        refresh(); // ncurses sends only the characters that changed.
+
+        wait_for_next_frame(&deadline);
+    }
+}
+
+/*
+ * timespec_get() is the standard C way to read the clock, with nanoseconds.
+ * (It reads the wall clock, which can jump if the system time is changed. On
+ * POSIX systems, clock_gettime(CLOCK_MONOTONIC) is the steadier choice.)
+ */
+long long now_nanoseconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Sleeps until `*deadline`, then moves the deadline one frame ahead. If we
+ * are already more than a frame late (the computer was busy), we don't rush
+ * through the missed frames to catch up; we simply continue from now.
+ */
+void wait_for_next_frame(long long *deadline)
+{
+    long long now = now_nanoseconds();
+
+    if (now < *deadline)
+    {
+        // napms() is ncurses' sleep, in milliseconds. Round up, so we never wake early.
+        napms((int)((*deadline - now + 999999) / 1000000));
+    }
+    *deadline += FRAME_NANOSECONDS;
+    if (*deadline < now)
+    {
+        *deadline = now + FRAME_NANOSECONDS;
+    }
+}
+
+// --- Part 3: Under the Hood, a Double-Buffered Renderer ---
+/*
+ * How does refresh() know what to send? ncurses keeps TWO copies of the
+ * screen: the one you draw on, and one that remembers what the terminal is
+ * showing right now. refresh() compares them and sends only the differences.
+ * This is called DOUBLE BUFFERING. It is why ncurses programs don't flicker:
+ * the screen is never wiped and redrawn in front of your eyes, and a frame
+ * that changes a few characters costs only a few bytes.
+ *
+ * Let's build a tiny version ourselves. A terminal is controlled with ESCAPE
+ * SEQUENCES: bytes starting with ESC (written `\x1b` in C) that the terminal
+ * treats as commands instead of text. We need only three of them:
+ *    "\x1b[<row>;<col>H"  Move the cursor (rows and columns count from 1).
+ *    "\x1b[<n>C"          Move the cursor n columns to the right.
+ *    "\x1b[0;36;40m"      Change the colors ("Select Graphic Rendition").
+ */
+
+// The escape sequences for our colors: the same combinations as the color
+// pairs in initialize_ncurses().
+static const char *const color_codes[] = {
+    "\x1b[0m",        // 0: the terminal's normal colors
+    "\x1b[0;1;33;40m", // 1: bold yellow on black
+    "\x1b[0;36;40m",   // 2: cyan on black
+    "\x1b[0;37;44m",   // 3: white on blue
+};
+
+Screen *screen_create(int rows, int cols)
+{
+    Screen *screen = malloc(sizeof(Screen));
+    size_t cells = (size_t)rows * (size_t)cols;
+
+    if (!screen)
+    {
+        return NULL;
+    }
+    screen->rows = rows;
+    screen->cols = cols;
+    screen->front = malloc(cells * sizeof(Cell));
+    screen->back = malloc(cells * sizeof(Cell));
+    // Big enough for the worst frame, so present() never has to check.
+    screen->output = malloc(cells * MAX_CELL_BYTES);
+    if (!screen->front || !screen->back || !screen->output)
+    {
+        screen_destroy(screen);
+        return NULL;
+    }
+
+    // We don't know what the terminal shows yet. A '\0' in `front` matches no
+    // character we draw, so the first frame repaints every cell.
+    for (size_t i = 0; i < cells; i++)
+    {
+        screen->front[i].ch = '\0';
+        screen->front[i].color = 0;
+    }
+    screen->output_length = 0;
+    screen->cursor_row = -1;
+    screen->cursor_col = -1;
+    screen->color = -1;
+    screen_clear(screen);
+    return screen;
+}
+
+void screen_destroy(Screen *screen)
+{
+    free(screen->front);
+    free(screen->back);
+    free(screen->output);
+    free(screen);
+}
+
+// Starts a new frame: fills the back buffer with blanks.
+void screen_clear(Screen *screen)
+{
+    size_t cells = (size_t)screen->rows * (size_t)screen->cols;
+
+    for (size_t i = 0; i < cells; i++)
+    {
+        screen->back[i].ch = ' ';
+        screen->back[i].color = 0;
+    }
+}
+
+// Draws text into the back buffer. Anything off the screen is cut off.
+void screen_put_text(Screen *screen, int row, int col, const char *text, unsigned char color)
+{
+    if (row < 0 || row >= screen->rows)
+    {
+        return;
+    }
+    for (; *text && col < screen->cols; text++, col++)
+    {
+        if (col >= 0)
+        {
+            Cell *cell = &screen->back[row * screen->cols + col];
+
+            cell->ch = *text;
+            cell->color = color;
+        }
+    }
+}
+
+// Adds bytes to the frame's output.
+void screen_emit(Screen *screen, const char *text, size_t length)
+{
+    memcpy(screen->output + screen->output_length, text, length);
+    screen->output_length += length;
+}
+
+/*
+ * Moves the terminal's cursor with the shortest sequence that works. Most of
+ * the time the cursor is already in the right place: after a character is
+ * printed, the cursor moves one column right by itself.
+ */
+void screen_move_cursor(Screen *screen, int row, int col)
+{
+    char sequence[MAX_CELL_BYTES];
+    int length;
+
+    if (row == screen->cursor_row && col == screen->cursor_col)
+    {
+        return;
+    }
+    if (row == screen->cursor_row && col > screen->cursor_col)
+    {
+        length = snprintf(sequence, sizeof(sequence), "\x1b[%dC", col - screen->cursor_col);
+    }
+    else
+    {
+        length = snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", row + 1, col + 1);
+    }
+    screen_emit(screen, sequence, (size_t)length);
+    screen->cursor_row = row;
+    screen->cursor_col = col;
+}
+
+/*
+ * Shows the back buffer on the terminal. Only cells that differ from `front`
+ * are sent (or every cell, with `full_repaint`, to compare the cost). Then
+ * `back` is copied to `front`, because that is what the terminal shows now.
+ * @return The number of bytes sent.
+ */
+size_t screen_present(Screen *screen, int full_repaint, FILE *terminal)
+{
+    size_t sent;
+
+    screen->output_length = 0;
+    for (int row = 0; row < screen->rows; row++)
+    {
+        for (int col = 0; col < screen->cols; col++)
+        {
+            const Cell *cell = &screen->back[row * screen->cols + col];
+            Cell *shown = &screen->front[row * screen->cols + col];
+
+            if (!full_repaint && cell->ch == shown->ch && cell->color == shown->color)
+            {
+                continue; // The terminal already shows this cell.
+            }
+
+            screen_move_cursor(screen, row, col);
+            if (cell->color != screen->color)
+            {
+                screen_emit(screen, color_codes[cell->color], strlen(color_codes[cell->color]));
+                screen->color = cell->color;
+            }
+            screen_emit(screen, &cell->ch, 1);
+            *shown = *cell;
+
+            // After the last column, terminals differ in where the cursor
+            // goes, so we forget where it is.
+            screen->cursor_col = col + 1 < screen->cols ? col + 1 : -1;
+        }
+    }
+
+    sent = screen->output_length;
+    if (sent > 0)
+    {
+        fwrite(screen->output, 1, sent, terminal);
+        fflush(terminal);
+    }
+    return sent;
+}
+
+/*
+ * A test picture: a box bouncing over a dotted background. Only the box
+ * moves, so most of the screen stays the same from one frame to the next.
+ */
+void draw_bouncing_box(Screen *screen, int frame)
+{
+    static const char *const box[] = {
+        "+--------------------+",
+        "|                    |",
+        "|  double buffered!  |",
+        "|                    |",
+        "+--------------------+",
+    };
+    const int box_rows = (int)(sizeof(box) / sizeof(box[0]));
+    const int box_cols = (int)strlen(box[0]);
+    int x_range = screen->cols > box_cols ? screen->cols - box_cols : 1;
+    int y_range = screen->rows > box_rows + 1 ? screen->rows - box_rows - 1 : 1;
+    // Walk back and forth: 0, 1, ..., range, range - 1, ..., 0, 1, ...
+    int x = frame % (2 * x_range);
+    int y = frame / 2 % (2 * y_range);
+
+    x = x < x_range ? x : 2 * x_range - x;
+    y = y < y_range ? y : 2 * y_range - y;
+
+    screen_clear(screen);
+    for (int row = 1; row < screen->rows; row++)
+    {
+        for (int col = row % 4; col < screen->cols; col += 4)
+        {
+            screen_put_text(screen, row, col, ".", 2);
+        }
+    }
+    for (int i = 0; i < box_rows; i++)
+    {
+        screen_put_text(screen, 1 + y + i, x, box[i], 3);
+    }
+}
+
+/*
+ * The worst case: a wave rolls across the whole screen, and every cell
+ * changes in every frame.
+ */
+void draw_wave(Screen *screen, int frame)
+{
+    static const char shades[] = " .:-=+*#%@";
+
+    for (int row = 0; row < screen->rows; row++)
+    {
+        for (int col = 0; col < screen->cols; col++)
+        {
+            int level = (row + col + frame) % 10;
+            Cell *cell = &screen->back[row * screen->cols + col];
+
+            cell->ch = shades[level];
+            cell->color = (unsigned char)(level < 5 ? 2 : 1);
+        }
+    }
+}
+
+/*
+ * Takes over the terminal with our own renderer until a key is pressed. The
+ * top line shows what the last frame cost. The event loop from Part 4 wakes
+ * us for every frame, for every key, and when the terminal is resized.
+ */
+int run_renderer_demo(void)
+{
+    struct termios saved_mode, key_mode;
+    int have_terminal = tcgetattr(STDIN_FILENO, &saved_mode) == 0;
+    int rows, cols, frames = 0, resizes = 0, running = 1;
+    long long total_nanoseconds = 0;
+    size_t total_bytes = 0, last_bytes = 0;
+    Screen *screen;
+    EventLoop loop;
+
+    terminal_size(&rows, &cols);
+    screen = screen_create(rows, cols);
+    if (!screen || !event_loop_init(&loop, STDIN_FILENO, FRAME_NANOSECONDS))
+    {
+        fprintf(stderr, "Error: could not set up the renderer.\n");
+        if (screen)
+        {
+            screen_destroy(screen);
+        }
+        return 1;
+    }
+
+    // ncurses' cbreak() and noecho(), done by hand: turn off "canonical" mode
+    // (waiting for Enter) and echoing, so each key arrives as it is pressed.
+    if (have_terminal)
+    {
+        key_mode = saved_mode;
+        key_mode.c_lflag &= ~(tcflag_t)(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &key_mode);
+    }
+    fputs("\x1b[?25l", stdout); // Hide the cursor while we draw.
+
+    while (running && screen)
+    {
+        char keys[64];
+        long long start;
+        char status[128];
+
+        switch (event_loop_wait(&loop))
+        {
+        case EVENT_TIMER:
+            start = now_nanoseconds();
+            draw_bouncing_box(screen, frames);
+            snprintf(status, sizeof(status), "Frame %d, last frame: %zu bytes, %d resizes. Press any key to stop.",
+                     frames + 1, last_bytes, resizes);
+            screen_put_text(screen, 0, 0, status, 1);
+            last_bytes = screen_present(screen, 0, stdout);
+
+            total_bytes += last_bytes;
+            total_nanoseconds += now_nanoseconds() - start;
+            frames++;
+            break;
+
+        case EVENT_RESIZE:
+            // Start over with buffers of the new size. Our `front` buffer no
+            // longer matches the terminal, so clear it and repaint everything.
+            screen_destroy(screen);
+            terminal_size(&rows, &cols);
+            screen = screen_create(rows, cols);
+            fputs("\x1b[0m\x1b[2J", stdout);
+            resizes++;
+            break;
+
+        case EVENT_INPUT:
+            if (read(STDIN_FILENO, keys, sizeof(keys)) < 0 && errno == EINTR)
+            {
+                break;
+            }
+            running = 0; // Any key (or the end of the input) stops the demo.
+            break;
+
+        case EVENT_HANGUP:
+            running = 0;
+            break;
+        }
+    }
+
+    // Put the terminal back the way we found it: normal colors, cleared, cursor on.
+    fputs("\x1b[0m\x1b[2J\x1b[H\x1b[?25h", stdout);
+    if (have_terminal)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_mode);
+    }
+    event_loop_close(&loop);
+    if (!screen)
+    {
+        fprintf(stderr, "Error: out of memory after a resize.\n");
+        return 1;
+    }
+
+    printf("Drew %d frames: %.1f us and %.0f bytes per frame on average.\n", frames,
+           frames ? total_nanoseconds / 1000.0 / frames : 0.0, frames ? (double)total_bytes / frames : 0.0);
+    screen_destroy(screen);
+    return 0;
+}
+
+/*
+ * Draws and presents `frames` frames of each test picture into a scratch
+ * file, with and without diffing, and reports the time and bytes per frame.
+ * No terminal is needed.
+ */
+int run_render_benchmark(int frames)
+{
+    static const char *const picture_names[] = {"Bouncing box", "Full-screen wave"};
+    FILE *scratch = tmpfile();
+
+    if (!scratch)
+    {
+        perror("Error creating a scratch file");
+        return 1;
+    }
+
+    printf("Rendering %d frames on a %dx%d screen.\n", frames, BENCHMARK_COLS, BENCHMARK_ROWS);
+    for (int picture = 0; picture < 2; picture++)
+    {
+        for (int full_repaint = 1; full_repaint >= 0; full_repaint--)
+        {
+            Screen *screen = screen_create(BENCHMARK_ROWS, BENCHMARK_COLS);
+            size_t bytes = 0;
+            long long start;
+            double nanoseconds;
+
+            if (!screen)
+            {
+                fclose(scratch);
+                return 1;
+            }
+            start = now_nanoseconds();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                if (picture == 0)
+                {
+                    draw_bouncing_box(screen, frame);
+                }
+                else
+                {
+                    draw_wave(screen, frame);
+                }
+                bytes += screen_present(screen, full_repaint, scratch);
+            }
+            nanoseconds = (double)(now_nanoseconds() - start);
+            screen_destroy(screen);
+
+            printf("%-16s %-13s %9.1f bytes/frame %9.1f us/frame\n", picture_names[picture],
+                   full_repaint ? "full repaint:" : "diff:", (double)bytes / frames, nanoseconds / 1000.0 / frames);
+        }
+    }
+    fclose(scratch);
+    return 0;
+}
+
+// --- Part 4: An Event Loop ---
+/*
+ * getch() BLOCKS: the program stops until a key arrives, so nothing on the
+ * screen can change while it waits. Real programs wait for several things at
+ * once: keys, a timer for the next animation frame, and the terminal being
+ * resized. They do it with an EVENT LOOP built on poll(), which sleeps until
+ * ANY of several file descriptors has something for us, or a timeout passes.
+ *
+ * Keys come from a file descriptor (standard input), and the timer becomes
+ * poll()'s timeout. A resize, though, arrives as a SIGNAL (SIGWINCH), which
+ * can interrupt the program anywhere. A signal handler may do very little
+ * safely, so ours just writes one byte into a PIPE. The other end of the
+ * pipe is one of the descriptors poll() watches, so the resize wakes the
+ * loop like any other event. This trick is called the "self-pipe".
+ */
+
+// The signal handler can only reach global variables.
+static int resize_pipe[2] = {-1, -1};
+
+void handle_resize_signal(int signal_number)
+{
+    int saved_errno = errno; // write() may change errno under the main program's feet.
+    char byte = 1;
+
+    (void)signal_number;
+    signal(SIGWINCH, handle_resize_signal); // Some systems reset the handler after each signal.
+    if (write(resize_pipe[1], &byte, 1) < 0)
+    {
+        // The pipe is full, so a resize is already waiting to be handled.
+    }
+    errno = saved_errno;
+}
+
+/*
+ * Sets up an event loop that reads keys from `input_fd` and, if
+ * `timer_interval` is not 0, has a timer that fires every `timer_interval`
+ * nanoseconds. Returns 1 on success, 0 on error.
+ */
+int event_loop_init(EventLoop *loop, int input_fd, long long timer_interval)
+{
+    if (pipe(resize_pipe) != 0)
+    {
+        return 0;
+    }
+    // Non-blocking, so the signal handler can never get stuck on a full pipe.
+    fcntl(resize_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(resize_pipe[1], F_SETFL, O_NONBLOCK);
+    signal(SIGWINCH, handle_resize_signal);
+
+    loop->input_fd = input_fd;
+    loop->timer_interval = timer_interval;
+    loop->next_timer = now_nanoseconds() + timer_interval;
+    return 1;
+}
+
+/*
+ * Sleeps until something happens and says what it was. A due timer comes
+ * first, so a flood of keys can't stop an animation.
+ */
+EventType event_loop_wait(EventLoop *loop)
+{
+    for (;;)
+    {
+        struct pollfd fds[2];
+        long long now = now_nanoseconds();
+        int timeout = -1; // -1 means "no timeout": wait as long as it takes.
+
+        if (loop->timer_interval > 0)
+        {
+            if (now >= loop->next_timer)
+            {
+                // Like wait_for_next_frame(): if we fell far behind, don't catch up.
+                loop->next_timer += loop->timer_interval;
+                if (loop->next_timer < now)
+                {
+                    loop->next_timer = now + loop->timer_interval;
+                }
+                return EVENT_TIMER;
+            }
+            timeout = (int)((loop->next_timer - now + 999999) / 1000000);
+        }
+
+        fds[0].fd = loop->input_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = resize_pipe[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, timeout) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue; // A signal arrived; its byte is in the pipe now.
+            }
+            return EVENT_HANGUP;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            char bytes[16];
+
+            // Several resizes may have piled up; one redraw handles them all.
+            while (read(resize_pipe[0], bytes, sizeof(bytes)) > 0)
+            {
+            }
+            return EVENT_RESIZE;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            return EVENT_INPUT;
+        }
+        if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL))
+        {
+            return EVENT_HANGUP;
+        }
+        // Otherwise poll() timed out, and the timer is due on the next pass.
+    }
+}
+
+void event_loop_close(EventLoop *loop)
+{
+    (void)loop;
+    signal(SIGWINCH, SIG_DFL);
+    close(resize_pipe[0]);
+    close(resize_pipe[1]);
+    resize_pipe[0] = resize_pipe[1] = -1;
+}
+
+// Asks the terminal how big it is; falls back to the classic 80x24.
+int terminal_size(int *rows, int *cols)
+{
+    struct winsize size;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0)
+    {
+        *rows = size.ws_row;
+        *cols = size.ws_col;
+        return 1;
+    }
+    *rows = 24;
+    *cols = 80;
+    return 0;
+}
+
+/*
+ * ncurses normally handles SIGWINCH itself. Our event loop replaced its
+ * handler with ours, so we tell ncurses about the new size ourselves.
+ */
+void resize_ncurses_screen(void)
+{
+    int rows, cols;
+
+    if (terminal_size(&rows, &cols))
+    {
+        resizeterm(rows, cols);
+    }
+}
+
+/*
+ * The event loop in action: while we wait for a key, a timer updates a
+ * status line every second, and a resize redraws the screen to fit.
+ */
+void wait_for_key(void)
+{
+    EventLoop loop;
+    int seconds = 0, resizes = 0;
+
+    if (!event_loop_init(&loop, STDIN_FILENO, 1000000000LL)) // A timer every second.
+    {
+        getch(); // No event loop; just wait the simple way.
+        return;
+    }
+    // In "no delay" mode, getch() returns ERR at once if there is no key,
+    // instead of waiting. poll() does the waiting now.
+    nodelay(stdscr, TRUE);
+
+    for (;;)
+    {
+        EventType event = event_loop_wait(&loop);
+
+        if (event == EVENT_HANGUP)
+        {
+            break;
+        }
+        if (event == EVENT_INPUT)
+        {
+            if (getch() != ERR)
+            {
+                break; // A key!
+            }
+            continue; // Only part of a key (like the start of an arrow key) so far.
+        }
+        if (event == EVENT_RESIZE)
+        {
+            resize_ncurses_screen();
+            draw_ui(0);
+            resizes++;
+        }
+        else
+        {
+            seconds++;
+        }
+
+        mvprintw(STATUS_ROW, 5, "Waited %d s for a key. The screen was resized %d times.", seconds, resizes);
+        clrtoeol();
+        refresh();
+    }
+
+    nodelay(stdscr, FALSE);
+    event_loop_close(&loop);
+}
+
+// --- Part 5: A Virtual List ---
+/*
+ * How would you show ten million lines, say the output of a big analysis,
+ * in a scrolling window? Formatting all of them first would take seconds
+ * and a lot of memory, and almost none of them would ever be seen: the
+ * window only has room for a few dozen.
+ *
+ * A VIRTUAL LIST formats only the rows that are on screen. It keeps just two
+ * numbers, the first row on screen (`top`) and the highlighted row
+ * (`selected`), and whenever it draws, it asks a DATA SOURCE callback for the
+ * text of each visible row. Scrolling is arithmetic on those two numbers, so
+ * moving one row or jumping to the end costs the same whether the list has
+ * a hundred rows or a billion. Where the rows come from is up to the data
+ * source: an array, a file, or (in our demo) a formula.
+ */
+
+void list_init(VirtualList *list, WINDOW *win, long row_count, RowSource source, void *context)
+{
+    list->win = win;
+    list->row_count = row_count;
+    list->top = 0;
+    list->selected = 0;
+    list->source = source;
+    list->context = context;
+}
+
+// How many rows fit inside the window's border.
+int list_visible_rows(const VirtualList *list)
+{
+    int rows = getmaxy(list->win) - 2;
+
+    return rows > 0 ? rows : 0;
+}
+
+/*
+ * Moves the highlight by `delta` rows (negative is up), stopping at either
+ * end, and scrolls just enough to keep it on screen. A `delta` of 0 only
+ * re-checks the scroll position, which is handy after a resize.
+ */
+void list_move(VirtualList *list, long delta)
+{
+    long visible = list_visible_rows(list);
+    long last_top = list->row_count - visible;
+
+    // Compare before adding, so a huge `delta` can't overflow.
+    if (delta < 0 && -delta > list->selected)
+    {
+        list->selected = 0;
+    }
+    else if (delta > 0 && delta > list->row_count - 1 - list->selected)
+    {
+        list->selected = list->row_count - 1;
+    }
+    else
+    {
+        list->selected += delta;
+    }
+
+    if (list->selected < list->top)
+    {
+        list->top = list->selected;
+    }
+    else if (visible > 0 && list->selected >= list->top + visible)
+    {
+        list->top = list->selected - visible + 1;
+    }
+    if (list->top > last_top)
+    {
+        list->top = last_top > 0 ? last_top : 0; // Don't leave empty space at the bottom.
+    }
+}
+
+// The usual scrolling keys. Returns 1 if the key was one of them.
+int list_handle_key(VirtualList *list, int key)
+{
+    long page = list_visible_rows(list) > 1 ? list_visible_rows(list) - 1 : 1;
+
+    switch (key)
+    {
+    case KEY_UP:
+        list_move(list, -1);
+        return 1;
+    case KEY_DOWN:
+        list_move(list, 1);
+        return 1;
+    case KEY_PPAGE:
+        list_move(list, -page);
+        return 1;
+    case KEY_NPAGE:
+        list_move(list, page);
+        return 1;
+    case KEY_HOME:
+        list_move(list, -list->row_count);
+        return 1;
+    case KEY_END:
+        list_move(list, list->row_count);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Draws the visible rows. This is the only place that asks the data source
+ * for rows, and it asks for at most one screenful.
+ */
+void list_draw(VirtualList *list)
+{
+    int visible = list_visible_rows(list);
+    int width = getmaxx(list->win) - 2;
+    char text[LIST_ROW_SIZE];
+
+    for (int i = 0; i < visible; i++)
+    {
+        long row = list->top + i;
+
+        if (row < list->row_count)
+        {
+            list->source(list->context, row, text, sizeof(text));
+        }
+        else
+        {
+            text[0] = '\0'; // The list is shorter than the window.
+        }
+
+        // Pad with spaces to the full width, which erases the old row without
+        // touching the border (wclrtoeol() would erase that too).
+        if (row == list->selected)
+        {
+            wattron(list->win, A_REVERSE);
+        }
+        mvwprintw(list->win, i + 1, 1, "%-*.*s", width, width, text);
+        wattroff(list->win, A_REVERSE);
+    }
+
+    box(list->win, 0, 0);
+    mvwprintw(list->win, 0, 2, " Row %ld of %ld ", list->selected + 1, list->row_count);
+    wnoutrefresh(list->win);
+}
+
+/*
+ * A data source with nothing behind it: each record is made up from its row
+ * number, so ten million of them cost no memory at all. A real data source
+ * would read the row from an array or seek to it in a file.
+ */
+void student_record_row(void *context, long row, char *buffer, size_t size)
+{
+    static const char *const first_names[] = {"Ada", "Alan", "Barbara", "Dennis", "Edsger", "Frances", "Grace",
+                                              "John", "Ken", "Linus", "Margaret", "Niklaus"};
+    static const char *const last_names[] = {"Allen", "Backus", "Dijkstra", "Hamilton", "Hopper", "Kernighan",
+                                             "Knuth", "Liskov", "Lovelace", "Ritchie", "Thompson", "Wirth"};
+    StudentRecords *records = context;
+    // Mix the bits of the row number, so neighbouring rows look different.
+    unsigned long long hash = ((unsigned long long)row + 1) * 0x9E3779B97F4A7C15ULL;
+
+    hash ^= hash >> 29;
+    records->rows_fetched++;
+    snprintf(buffer, size, "%10ld  %-9s %-10s  grade %3llu  year %llu", row + 1, first_names[hash % 12],
+             last_names[hash / 12 % 12], hash / 144 % 101, hash / 14544 % 4 + 1);
+}
+
+/*
+ * Browses `row_count` student records. The event loop from Part 4 wakes us
+ * for keys and resizes; nothing happens in between.
+ */
+int run_list_demo(long row_count)
+{
+    StudentRecords records = {0};
+    VirtualList list;
+    EventLoop loop;
+    int running = 1;
+
+    initialize_ncurses();
+    if (!event_loop_init(&loop, STDIN_FILENO, 0)) // No timer: the list only changes on a key.
+    {
+        cleanup_ncurses();
+        fprintf(stderr, "Error: could not set up the event loop.\n");
+        return 1;
+    }
+    nodelay(stdscr, TRUE);
+
+    list_init(&list, newwin(LINES - 1, COLS, 0, 0), row_count, student_record_row, &records);
+    keypad(list.win, TRUE);
+    nodelay(list.win, TRUE);
+
+    while (running)
+    {
+        int key;
+
+        // Draw, then say how many rows it took: always about one screenful.
+        list_draw(&list);
+        mvprintw(LINES - 1, 0, "Arrows, PgUp/PgDn, Home/End scroll; q quits. Rows formatted so far: %ld",
+                 records.rows_fetched);
+        clrtoeol();
+        wnoutrefresh(stdscr);
+        doupdate();
+
+        switch (event_loop_wait(&loop))
+        {
+        case EVENT_INPUT:
+            while ((key = wgetch(list.win)) != ERR)
+            {
+                if (key == 'q' || key == 'Q')
+                {
+                    running = 0;
+                }
+                list_handle_key(&list, key);
+            }
+            break;
+
+        case EVENT_RESIZE:
+            resize_ncurses_screen();
+            wresize(list.win, LINES - 1, COLS);
+            list_move(&list, 0);
+            clear();
+            wnoutrefresh(stdscr);
+            break;
+
+        case EVENT_TIMER:
+            break;
+
+        case EVENT_HANGUP:
+            running = 0;
+            break;
+        }
+    }
+
+    delwin(list.win);
+    event_loop_close(&loop);
+    cleanup_ncurses();
+    printf("Browsed %ld rows and formatted %ld of them.\n", row_count, records.rows_fetched);
+    return 0;
+}
+
+/*
+ * Scrolls lists of very different sizes `scrolls` times in the same way,
+ * drawing into a scratch file instead of a terminal, and reports the time
+ * per scroll and how many rows each scroll had to format. Both should stay
+ * flat as the list grows.
+ */
+int run_list_benchmark(int scrolls)
+{
+    static const long sizes[] = {1000L, 1000000L, 1000000000L};
+    FILE *terminal_output = tmpfile();
+    FILE *terminal_input = fopen("/dev/null", "r");
+    SCREEN *screen = NULL;
+
+    if (terminal_output && terminal_input)
+    {
+        // A fixed terminal type and size, so the numbers do not depend on the user's terminal.
+        screen = newterm("xterm", terminal_output, terminal_input);
+    }
+    if (!screen)
+    {
+        fprintf(stderr, "Error: could not set up a terminal for the list benchmark.\n");
+        if (terminal_output)
+        {
+            fclose(terminal_output);
+        }
+        if (terminal_input)
+        {
+            fclose(terminal_input);
+        }
+        return 1;
+    }
+    resizeterm(BENCHMARK_ROWS, BENCHMARK_COLS);
+
+    printf("Scrolling %d times on a %dx%d screen.\n", scrolls, BENCHMARK_COLS, BENCHMARK_ROWS);
+    for (int i = 0; i < 3; i++)
+    {
+        StudentRecords records = {0};
+        VirtualList list;
+        unsigned long long jump = 1;
+        long long start;
+        double nanoseconds;
+
+        list_init(&list, newwin(BENCHMARK_ROWS, BENCHMARK_COLS, 0, 0), sizes[i], student_record_row, &records);
+        start = now_nanoseconds();
+        for (int scroll = 0; scroll < scrolls; scroll++)
+        {
+            // Mostly single rows and pages, like a person would; every
+            // sixteenth scroll jumps somewhere random.
+            if (scroll % 16 == 15)
+            {
+                jump = jump * 6364136223846793005ULL + 1442695040888963407ULL;
+                list_move(&list, (long)(jump >> 33) % sizes[i] - list.selected);
+            }
+            else
+            {
+                list_handle_key(&list, scroll % 4 == 0 ? KEY_NPAGE : KEY_DOWN);
+            }
+            list_draw(&list);
+            doupdate();
+        }
+        nanoseconds = (double)(now_nanoseconds() - start);
+        delwin(list.win);
+
+        printf("%10ld rows: %6.2f us per scroll, %ld rows formatted per scroll.\n", sizes[i],
+               nanoseconds / 1000.0 / scrolls, records.rows_fetched / scrolls);
+    }
+
+    endwin();
+    delscreen(screen);
+    fclose(terminal_output);
+    fclose(terminal_input);
+    return 0;
 }
 
 /*
@@ -203,4 +1358,19 @@ void draw_ui(void)
  *
  *    Your terminal will clear and show the UI we just created! Press any
  *    key to return to your normal command prompt.
+ *
+ * 5. Try the double-buffered renderer from Part 3. The first command takes
+ *    over your terminal until you press a key (try resizing the window while
+ *    it runs); the second draws into a scratch file and compares repainting
+ *    everything with sending only the changes:
+ *
+ *    `./33_advanced_terminal_ui --double-buffer`
+ *    `./33_advanced_terminal_ui --benchmark 1000`
+ *
+ * 6. Browse ten million rows with the virtual list from Part 5 (or give your
+ *    own row count), and time scrolling lists from a thousand to a billion
+ *    rows:
+ *
+ *    `./33_advanced_terminal_ui --list`
+ *    `./33_advanced_terminal_ui --benchmark-list 10000`
  */
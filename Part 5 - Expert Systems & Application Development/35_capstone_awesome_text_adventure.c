@@ -23,14 +23,29 @@
  *
  * CONCEPTS YOU WILL USE IN THIS PROJECT:
  * - Foundational Logic: Variables, `if`/`else`, `for`/`while` loops, functions.
- * - Data Structures: `struct`s to model the game world, `enum`s for clarity.
- * - Memory Management: `malloc` and `free` to dynamically create the world.
- * - Pointers: The entire game world is connected by POINTERS. This is the ultimate
- *   demonstration of their power.
+ * - Data Structures: `struct`s to model the game world, `enum`s for clarity,
+ *   and a ring buffer that keeps the message log without any extra malloc().
+ * - Memory Management: `malloc`, `realloc` and `free` to dynamically create the
+ *   world. All rooms live in ONE growable array, and every description is
+ *   stored exactly once in a shared "string pool".
+ * - Pointers and Indices: Pointers find rooms in memory, while the map itself
+ *   is connected by small array INDICES that survive being written to a file.
  * - File I/O: The game world is loaded from an external data file (`world.map`).
- * - Parsing: `sscanf` is used to parse the world data file.
+ *   The whole file is pulled into memory with a few large `fread` calls.
+ * - Processes: The `save` command hands the slow disk write to a child
+ *   process made with `fork()`, so the game never waits for it.
+ * - Parsing: A hand-written tokenizer walks the world data one line at a time.
  * - Command-Line Arguments: The program takes the map file as an argument.
+ * - Binary Files: A map can be compiled into a binary "world image" that is
+ *   mapped straight into memory with `mmap`, so no text has to be parsed.
+ *   Huge images are kept in memory a few regions at a time (an LRU cache).
+ * - Networking: A server mode lets many players share one world over TCP,
+ *   all served by a single `poll()` loop (Lesson 26 showed the basics).
  * - External Libraries: We use the `ncurses` library for an advanced terminal UI.
+ *   While it waits for a command, an event loop (as in Lesson 33) keeps a clock
+ *   ticking and redraws the windows when the terminal is resized.
+ *   The game can also run "headless", without ncurses, reading commands from a
+ *   file so that it can be scripted, tested and benchmarked.
  * - Build Tooling: Lesson 31 introduced Makefiles, but this capstone stays in
  *   one source file so you can build it directly with a compiler command.
  * - Advanced Techniques: We'll even use an array of structs with function
@@ -40,21 +55,79 @@
  */
 
 // --- Standard and External Library Includes ---
+#define _DEFAULT_SOURCE 1 // For madvise(), which gives world regions back to the system.
+#include <arpa/inet.h> // For htons() and inet_pton() in the multiplayer server
 #include <ctype.h>  // For tolower()
 #include <errno.h>  // For robust numeric parsing
+#include <fcntl.h>  // For open() and non-blocking sockets
 #include <limits.h> // For INT_MIN and INT_MAX
 #include <ncurses.h> // For the advanced Terminal User Interface (TUI)
+#include <netinet/in.h> // For struct sockaddr_in
+#include <poll.h>       // For poll(), the heart of the server's event loop
+#include <signal.h>     // For stopping the server cleanly and for terminal resizes
+#include <stdint.h> // For the fixed-width integers in the world image format
 #include <stdio.h>
-#include <stdlib.h> // For malloc, free, exit
+#include <stdlib.h> // For malloc, free, exit, qsort, bsearch
 #include <string.h> // For string manipulation functions
+#include <sys/ioctl.h> // For asking the terminal its new size after a resize
+#include <sys/mman.h> // For mmap(), munmap() and madvise()
+#include <sys/socket.h> // For socket(), accept(), send() and recv()
+#include <sys/stat.h> // For fstat()
+#include <sys/wait.h> // For waitpid(), to collect the process that saves the game
+#include <time.h>     // For timespec_get() in the load benchmark
+#include <unistd.h>   // For close()
 
 // --- Game Constants and Enums ---
 #define MAX_DIRECTIONS 4
-#define MAX_ROOMS 100
-#define MAX_LOG_MESSAGES 10
+#define MAX_ROOMS 10000000
+#define INITIAL_ROOM_CAPACITY 64
+// How many messages the log remembers, and how many bytes of text it may use
+// to do so. Both can be changed at compile time, e.g. -DLOG_SCROLLBACK_LINES=10000.
+#ifndef LOG_SCROLLBACK_LINES
+#define LOG_SCROLLBACK_LINES 4096
+#endif
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE (256 * 1024)
+#endif
+#define LOG_MESSAGE_SIZE 1024 // Longer messages are cut short.
+#define UI_TIMER_NANOSECONDS 1000000000LL // The status bar clock ticks once a second.
+#define MIN_SCREEN_ROWS 8 // Smaller terminals keep the old window layout.
+#define MIN_SCREEN_COLS 30
+#define STATUS_LOCATION_FORMAT "Location: Room %d" // The left side of the status bar.
 #define INPUT_BUFFER_SIZE 100
 #define ROOM_DESCRIPTION_SIZE 512
 #define WORLD_LINE_BUFFER_SIZE 1024
+#define WORLD_READ_CHUNK_SIZE (64 * 1024)
+#define LOAD_BENCHMARK_REPETITIONS 5
+#define SCALE_BENCHMARK_COMMANDS 1000000 // Commands replayed at every size.
+#define SCALE_BENCHMARK_LINK_PERCENT 50
+#define INITIAL_OUTPUT_CAPACITY 4096
+#define COMMAND_HASH_BITS 5 // The command hash table has 1 << 5 = 32 slots.
+#define COMMAND_HASH_SIZE (1u << COMMAND_HASH_BITS)
+#define MAX_COMMAND_HASH_SEEDS 100000
+#define NOT_A_DIRECTION -1
+#define WORLD_IMAGE_MAGIC "ADVWORLD"
+#define WORLD_IMAGE_MAGIC_SIZE 8
+#define WORLD_IMAGE_VERSION 2
+#define NO_ROOM UINT32_MAX
+#define SAVE_FILE_MAGIC "ADVSAVE"
+#define SAVE_FILE_MAGIC_SIZE 8
+#define SAVE_FILE_VERSION 1
+#define INITIAL_STRING_POOL_SIZE 4096
+#define INITIAL_STRING_POOL_SLOTS 1024
+// A world image is kept in memory in regions of REGION_SIZE bytes, and at
+// most MAX_RESIDENT_REGIONS regions at a time (64 MiB by default).
+// REGION_SIZE must be a multiple of the system's page size.
+#ifndef REGION_SIZE
+#define REGION_SIZE (1024 * 1024)
+#endif
+#ifndef MAX_RESIDENT_REGIONS
+#define MAX_RESIDENT_REGIONS 64
+#endif
+#define REGION_TOUCH_STRIDE 4096 // Reading one byte per page loads the page.
+#define MAX_SESSIONS 10000                // Players one server can hold at once.
+#define SERVER_READ_SIZE 4096             // Bytes read from a player in one recv().
+#define MAX_OUTBOX_SIZE (1024 * 1024)     // Players who fall this far behind are dropped.
 
 // Using an enum makes direction-related code much more readable and safe.
 typedef enum
@@ -68,109 +141,392 @@ typedef enum
 // --- Core Data Structures ---
 // These structs are the blueprint for our entire game world.
 
-// Forward declaration is needed because GameState and Room reference each other.
+// Forward declaration is needed because the Command handlers take a GameState.
 struct GameState;
 
+// A room is just 24 bytes. Its description lives in the world's string pool,
+// so the room only remembers where (a byte offset) instead of holding a big
+// fixed-size character array that is mostly empty.
 typedef struct Room
 {
-    int id;
-    char description[ROOM_DESCRIPTION_SIZE];
-    // This is the key: an array of POINTERS to other Room structs.
-    // This is how we form the "graph" of our world map.
-    struct Room *exits[MAX_DIRECTIONS];
+    int32_t id;
+    uint32_t description; // Byte offset of the text in the string pool.
+    // This is the key: each exit holds the INDEX of another room in the
+    // world's room array, or NO_ROOM. This is how we form the "graph" of our
+    // world map. An index is half the size of a pointer on 64-bit machines and,
+    // unlike a pointer, still means the same thing after being saved to a file.
+    uint32_t exits[MAX_DIRECTIONS];
 } Room;
 
+// The string pool keeps every distinct description exactly once, back to back
+// in one buffer. Many rooms in a big world share text ("A damp corridor."),
+// and each of them pays only for a 4-byte offset.
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    // While loading we need to spot text we have already stored. These slots
+    // form a small open-addressing hash table of (offset + 1) values, where 0
+    // marks an empty slot.
+    uint32_t *slots;
+    size_t slot_count;
+    size_t used_slots;
+} StringPool;
+
+// The message log is a ring buffer: messages are copied back to back into one
+// fixed block of bytes, and when there is no room left the oldest messages are
+// simply forgotten. Adding a message never calls malloc() or moves other
+// messages around.
+typedef struct
+{
+    char bytes[LOG_BUFFER_SIZE];            // The text of every message, '\0'-terminated.
+    uint32_t starts[LOG_SCROLLBACK_LINES];  // Where each message begins in `bytes`, also a ring.
+    int first;                              // Index in `starts` of the oldest message.
+    int count;                              // How many messages are stored.
+    size_t head;                            // Where the next message will be written.
+    uint64_t total;                         // How many messages were ever added.
+} MessageLog;
+
+_Static_assert(LOG_BUFFER_SIZE >= LOG_MESSAGE_SIZE, "LOG_BUFFER_SIZE must hold at least one message");
+_Static_assert(LOG_BUFFER_SIZE <= UINT32_MAX, "LOG_BUFFER_SIZE must fit the 32-bit message offsets");
+
 typedef struct Player
 {
     Room *current_room; // A pointer to the room the player is currently in.
 } Player;
 
+// --- The Compiled World Image ---
+// A world image is the binary twin of a map file. Everything is already
+// parsed, and it is laid out exactly like the world in memory: the room array
+// (sorted by id) followed by the string pool.
+//
+//   [WorldImageHeader][Room x room_count][string pool bytes]
+//
+// The numbers are written in the byte order of the machine that compiled the
+// image, so an image is meant to be used on that same kind of machine.
+typedef struct
+{
+    char magic[WORLD_IMAGE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t room_count;
+    uint64_t string_pool_size;
+} WorldImageHeader;
+
+// The image format depends on Room having no hidden padding.
+_Static_assert(sizeof(Room) == 24, "Room must be 24 bytes to match the world image format");
+
+// --- Saved Games ---
+// Nothing in the world changes while you play: rooms, exits and descriptions
+// stay exactly as the map made them. So a saved game does not copy the world,
+// it only records how the game differs from a freshly loaded one, which is
+// where the player stands. The fingerprint makes sure a save is only loaded
+// into the world it was made in. The whole file is these 24 bytes.
+typedef struct
+{
+    char magic[SAVE_FILE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t world_fingerprint;
+    uint32_t room_count;
+    int32_t room_id; // The player's room.
+} SaveFile;
+
+// A link we have parsed but not yet connected. Links may name rooms that
+// appear later in the file, so we remember them and connect them at the end.
+typedef struct
+{
+    int from_id;
+    int to_id;
+    Direction direction;
+    int line_number;
+} PendingLink;
+
 typedef struct
 {
     char *command;
     // A function pointer! This lets us create a clean, data-driven command system.
     void (*handler)(struct GameState *game, char *argument);
+    // For words like "north" or "n": which way they go. NOT_A_DIRECTION otherwise.
+    int direction;
 } Command;
 
+// --- The Event Loop ---
+// Instead of freezing inside an input function, the ncurses game waits in
+// poll() for whichever comes first: a key, the next clock tick, or a resize
+// of the terminal (see event_loop_wait()).
+typedef enum
+{
+    EVENT_INPUT,  // There are keys to read.
+    EVENT_TIMER,  // The timer is due.
+    EVENT_RESIZE, // The terminal changed size.
+    EVENT_HANGUP  // The input is gone (e.g. the terminal was closed).
+} EventType;
+
+typedef struct
+{
+    int input_fd;             // Where keys come from, usually STDIN_FILENO.
+    long long timer_interval; // Nanoseconds between timer events; 0 for no timer.
+    long long next_timer;     // When the timer is due next.
+} EventLoop;
+
 // The main struct to hold the entire state of our running game.
 typedef struct GameState
 {
     Player player;
-    Room *all_rooms[MAX_ROOMS];
+    Room *rooms; // Every room in one contiguous array; sorted by id once loaded.
     int num_rooms;
+    int room_capacity;
+    int room_ids_dense; // Set by index_room_ids(): the ids run first_room_id, first_room_id + 1, ...
+    int first_room_id;
+    StringPool strings;
     int game_should_close;
 
+    // Set only when the world came from a compiled image: `rooms` and the
+    // string pool then point straight into this read-only mapping.
+    void *image;
+    size_t image_size;
+
+    // Region tracking for big world images (see world_touch()). Only used if
+    // the image has more than MAX_RESIDENT_REGIONS regions.
+    uint64_t *region_last_use; // For each region: when it was last used, or 0 if not loaded.
+    size_t region_count;
+    int resident_regions;
+    uint64_t region_clock;
+    uint64_t region_evictions;
+
+    // Only used while the world file is being loaded.
+    PendingLink *pending_links;
+    int num_pending_links;
+    int pending_link_capacity;
+
+    // Headless mode: no ncurses. ui_log() appends to this buffer instead, and
+    // the caller decides what to do with the text.
+    int headless;
+    char *output;
+    size_t output_length;
+    size_t output_capacity;
+
     // For the ncurses UI
     WINDOW *main_win;
     WINDOW *status_win;
     WINDOW *input_win;
-    char *log_messages[MAX_LOG_MESSAGES];
-    int log_count;
+    MessageLog log;
+
+    // Saved games (see handle_save()). save_filename is NULL where saving is
+    // not allowed, such as on the multiplayer server.
+    char *save_filename;
+    pid_t save_pid; // The process writing a save right now, or 0.
+
+    // Scratch space for searching the map (see search_rooms()). Each array
+    // has one entry per room and is allocated the first time it is needed.
+    uint32_t *search_visited; // search_generation if the room was reached.
+    uint32_t *search_parent;  // The room we came from.
+    uint32_t *search_queue;
+    uint32_t search_generation;
+
+    // What is already on screen, so ui_draw() only draws what changed.
+    int ui_full_redraw;        // Set to redraw everything, e.g. the first time.
+    uint64_t drawn_log_total;  // log.total when the log was last drawn.
+    int log_row;               // Main window row for the next log message.
+    int drawn_room_id;         // Room id shown in the status window.
+
+    // The ncurses game's event loop, and the clock in the status window.
+    EventLoop events;
+    int has_event_loop;        // 0 if the event loop could not be set up.
+    long long ui_started_at;   // When the game started, in nanoseconds.
+    int drawn_play_seconds;    // The time shown in the status window, or -1.
 } GameState;
 
+// --- The Multiplayer Server ---
+// The server runs ONE world for many players. The world is shared, but each
+// player has their own Player (their position). To run a command for a player,
+// the server copies their Player into the GameState, runs the command exactly
+// like the single-player game, and copies it back.
+typedef struct
+{
+    int fd; // The player's socket, or -1 if this slot is free.
+    int number; // Other players see this player as "Player <number>".
+    Player player;
+    char input[INPUT_BUFFER_SIZE]; // The command being received.
+    size_t input_length;
+    // Text waiting to be sent. It is collected during a pass of the event
+    // loop and sent with one send() at the end, however many messages it holds.
+    char *outbox;
+    size_t outbox_length;
+    size_t outbox_sent;
+    size_t outbox_capacity;
+    // The players in each room form a doubly linked list through these, so a
+    // player can leave a room in O(1) and a message can reach a whole room.
+    int next_in_room;
+    int previous_in_room;
+    int closing; // Set after "quit": close once the outbox is sent.
+} Session;
+
+typedef struct
+{
+    GameState *game;
+    int listener;
+    Session *sessions;
+    int session_high_water; // Slots at or above this index have never been used.
+    int *free_slots;        // A stack of free session slots.
+    int free_count;
+    int *room_first_player; // For each room, the first session in it (or -1).
+    struct pollfd *poll_fds;
+    int *poll_slots; // The session slot behind each entry of poll_fds.
+    int next_number;
+    int players_served;
+} Server;
+
 // --- Function Prototypes ---
 // Grouping prototypes makes the code easier to navigate.
 
 // Game Lifecycle
 void game_loop(GameState *game);
 void cleanup(GameState *game);
+int place_player_at_start(GameState *game);
+GameState *start_headless_game(const char *filename);
+int run_headless(const char *world_filename, const char *script_filename);
+int parse_number_argument(const char *text, int min, int max, int *value);
+int parse_count_argument(const char *text, int max, int *value);
+int run_validate(const char *world_filename);
+
+// Saved Games
+int enable_saving(GameState *game, const char *world_filename);
+uint32_t world_fingerprint(GameState *game);
+int write_save_file(const char *temp_filename, const char *filename, const SaveFile *save);
+void finish_save(GameState *game, int wait);
+
+// Multiplayer Server
+int open_listener(int port);
+int session_append(Session *session, const char *text, size_t length);
+void server_tell_room(Server *server, const Room *room, int skip_slot, const char *message);
+void server_enter_room(Server *server, int slot);
+void server_leave_room(Server *server, int slot);
+void server_accept(Server *server);
+void server_run_command(Server *server, int slot, char *line);
+int server_read(Server *server, int slot);
+int server_send(Session *session);
+void server_close_session(Server *server, int slot);
+int run_server(const char *world_filename, int port);
+
+// Benchmarks
+uint32_t next_random(uint64_t *state);
+int generate_world_file(const char *filename, int room_count, int link_percent, int seed);
+char *filename_with_suffix(const char *filename, const char *suffix);
+double elapsed_seconds(const struct timespec *start, const struct timespec *end);
+int run_load_benchmark(int room_count, const char *filename);
+int time_world_loads(const char *filename, int room_count, const char *label);
+double time_commands(GameState *game, int command_count, size_t *output_bytes);
+int run_command_benchmark(const char *world_filename, int command_count);
+int time_one_load(const char *filename, double *seconds, size_t *bytes);
+int run_scale_benchmark(int max_rooms, const char *filename);
+int render_benchmark_pass(const char *world_filename, int turns, int full_redraw, long *bytes, double *seconds);
+int run_render_benchmark(const char *world_filename, int turns);
+char *build_server_script(int commands, size_t *size);
+int run_server_benchmark(int port, int players, int commands_per_player);
+size_t world_memory_bytes(const GameState *game);
 
 // World Loading & Parsing
 GameState *load_world(const char *filename);
+GameState *load_world_text(const char *filename);
+GameState *load_world_image(const char *filename);
+int is_world_image(const char *filename);
+int compile_world(const char *map_filename, const char *image_filename);
+void world_touch(GameState *game, const void *address, size_t size);
+void world_touch_region(GameState *game, size_t region);
+void world_load_region(GameState *game, size_t region);
+void world_evict_oldest_region(GameState *game);
+int world_release_region(GameState *game, size_t region);
+void world_release_untracked(GameState *game);
+char *read_world_file(const char *filename, size_t *length);
 int parse_room(char *line, GameState *game);
 int parse_link(char *line, GameState *game);
+int resolve_links(GameState *game);
+int compare_rooms_by_id(const void *a, const void *b);
+void index_room_ids(GameState *game);
 Room *find_room_by_id(GameState *game, int id);
+Room *room_exit(GameState *game, const Room *room, Direction d);
+const char *room_description(GameState *game, const Room *room);
+uint32_t hash_text(const char *text, size_t length);
+int string_pool_add(StringPool *pool, const char *text, size_t length, uint32_t *offset);
+int string_pool_grow_slots(StringPool *pool);
+void string_pool_free_index(StringPool *pool);
 const char *direction_to_string(Direction d);
-int read_world_line(FILE *file, char *buffer, size_t size);
+int next_world_line(char **cursor, char **line);
 char *skip_whitespace(char *text);
 int parse_int_token(char **cursor, int *value);
 int has_only_trailing_whitespace(char *text);
-char *duplicate_string(const char *text);
+void message_log_drop_oldest(MessageLog *log);
+void message_log_add(MessageLog *log, const char *message);
+const char *message_log_get(const MessageLog *log, int index);
+
+// Pathfinding
+int search_rooms(GameState *game, const Room *start, const Room *target);
+int describe_path(GameState *game, const Room *start, const Room *target, char *buffer, size_t size);
 
 // Command Handling
+uint32_t command_hash(const char *word, uint32_t seed);
+void build_command_hash(void);
+const Command *find_command(const char *word);
 void parse_and_execute_command(GameState *game, char *input);
 void handle_quit(GameState *game, char *argument);
 void handle_look(GameState *game, char *argument);
 void handle_go(GameState *game, char *argument);
 void handle_help(GameState *game, char *argument);
+void handle_path(GameState *game, char *argument);
+void handle_save(GameState *game, char *argument);
+void handle_load(GameState *game, char *argument);
+
+// Event Loop
+long long now_nanoseconds(void);
+int event_loop_init(EventLoop *loop, int input_fd, long long timer_interval);
+EventType event_loop_wait(EventLoop *loop);
+void event_loop_close(EventLoop *loop);
 
 // UI Functions (ncurses)
 void ui_init(GameState *game);
+void ui_create_windows(GameState *game);
+void ui_resize(GameState *game);
+void ui_append_log_line(GameState *game, const char *message);
 void ui_draw(GameState *game);
 void ui_get_input(GameState *game, char *buffer);
 void ui_log(GameState *game, const char *message);
 void ui_cleanup(GameState *game);
 
 // --- Main Program Entry ---
-int read_world_line(FILE *file, char *buffer, size_t size)
+
+/**
+ * @brief Cuts the next line out of an in-memory world file.
+ * The newline is overwritten with '\0' so the line can be parsed in place,
+ * and `*cursor` is moved to the start of the following line.
+ * @return 1 for a line, 0 at the end of the data, -1 if the line is too long.
+ */
+int next_world_line(char **cursor, char **line)
 {
+    char *start = *cursor;
+    char *newline;
     size_t length;
 
-    if (fgets(buffer, size, file) == NULL)
+    if (*start == '\0')
     {
         return 0;
     }
 
-    length = strcspn(buffer, "\n");
-    if (buffer[length] == '\n')
+    newline = strchr(start, '\n');
+    if (newline)
     {
-        buffer[length] = '\0';
-        return 1;
+        length = (size_t)(newline - start);
+        *newline = '\0';
+        *cursor = newline + 1;
     }
-
-    if (!feof(file))
+    else
     {
-        int ch;
-
-        while ((ch = fgetc(file)) != '\n' && ch != EOF)
-        {
-            // Discard the rest of an overlong line so the next read starts cleanly.
-        }
-        buffer[0] = '\0';
-        return -1;
+        length = strlen(start);
+        *cursor = start + length;
     }
 
-    return 1;
+    *line = start;
+    return length < WORLD_LINE_BUFFER_SIZE - 1 ? 1 : -1;
 }
 
 char *skip_whitespace(char *text)
@@ -212,26 +568,192 @@ int has_only_trailing_whitespace(char *text)
     return *text == '\0';
 }
 
-char *duplicate_string(const char *text)
+/**
+ * @brief Forgets the oldest message in the log.
+ */
+void message_log_drop_oldest(MessageLog *log)
+{
+    log->first = (log->first + 1) % LOG_SCROLLBACK_LINES;
+    log->count--;
+}
+
+/**
+ * @brief Copies a message into the log, making room for it if needed.
+ */
+void message_log_add(MessageLog *log, const char *message)
 {
-    size_t length = strlen(text) + 1;
-    char *copy = malloc(length);
+    size_t length = strlen(message);
+    size_t size;
 
-    if (!copy)
+    if (length > LOG_MESSAGE_SIZE - 1)
     {
-        return NULL;
+        length = LOG_MESSAGE_SIZE - 1;
+    }
+    size = length + 1;
+
+    if (log->count == LOG_SCROLLBACK_LINES)
+    {
+        message_log_drop_oldest(log);
+    }
+
+    // A message is never split in two. If it does not fit before the end of
+    // the buffer, it goes at the start instead; the messages still stored at
+    // the end are the oldest ones, so they are dropped first.
+    if (log->head + size > LOG_BUFFER_SIZE)
+    {
+        while (log->count > 0 && log->starts[log->first] >= log->head)
+        {
+            message_log_drop_oldest(log);
+        }
+        log->head = 0;
+    }
+
+    // Drop the old messages that the new text is about to overwrite.
+    while (log->count > 0 && log->starts[log->first] >= log->head && log->starts[log->first] < log->head + size)
+    {
+        message_log_drop_oldest(log);
+    }
+
+    memcpy(log->bytes + log->head, message, length);
+    log->bytes[log->head + length] = '\0';
+    log->starts[(log->first + log->count) % LOG_SCROLLBACK_LINES] = (uint32_t)log->head;
+    log->count++;
+    log->head += size;
+    log->total++;
+}
+
+/**
+ * @brief Returns a stored message. Index 0 is the oldest one.
+ */
+const char *message_log_get(const MessageLog *log, int index)
+{
+    return log->bytes + log->starts[(log->first + index) % LOG_SCROLLBACK_LINES];
+}
+
+/**
+ * @brief Reads a whole number between `min` and `max` from a command-line
+ * argument, or explains what was wrong with it.
+ */
+int parse_number_argument(const char *text, int min, int max, int *value)
+{
+    char *cursor = (char *)text;
+
+    if (!parse_int_token(&cursor, value) || !has_only_trailing_whitespace(cursor) || *value < min || *value > max)
+    {
+        fprintf(stderr, "Error: '%s' must be a number between %d and %d.\n", text, min, max);
+        return 0;
     }
+    return 1;
+}
 
-    memcpy(copy, text, length);
-    return copy;
+int parse_count_argument(const char *text, int max, int *value)
+{
+    return parse_number_argument(text, 1, max, value);
 }
 
 int main(int argc, char *argv[])
 {
+    int count;
+
+    if (argc == 4 && strcmp(argv[1], "--benchmark-load") == 0)
+    {
+        if (!parse_count_argument(argv[2], MAX_ROOMS, &count))
+        {
+            return 1;
+        }
+        return run_load_benchmark(count, argv[3]);
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--benchmark-scale") == 0)
+    {
+        if (!parse_count_argument(argv[2], MAX_ROOMS, &count))
+        {
+            return 1;
+        }
+        return run_scale_benchmark(count, argv[3]);
+    }
+
+    if (argc == 6 && strcmp(argv[1], "--generate") == 0)
+    {
+        int link_percent, seed;
+
+        if (!parse_count_argument(argv[2], MAX_ROOMS, &count) ||
+            !parse_number_argument(argv[3], 0, 100, &link_percent) ||
+            !parse_number_argument(argv[4], 0, INT_MAX, &seed))
+        {
+            return 1;
+        }
+        return generate_world_file(argv[5], count, link_percent, seed) ? 0 : 1;
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--benchmark-commands") == 0)
+    {
+        if (!parse_count_argument(argv[3], INT_MAX, &count))
+        {
+            return 1;
+        }
+        return run_command_benchmark(argv[2], count);
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--benchmark-render") == 0)
+    {
+        if (!parse_count_argument(argv[3], INT_MAX, &count))
+        {
+            return 1;
+        }
+        return run_render_benchmark(argv[2], count);
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--compile") == 0)
+    {
+        return compile_world(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--server") == 0)
+    {
+        if (!parse_count_argument(argv[3], 65535, &count))
+        {
+            return 1;
+        }
+        return run_server(argv[2], count);
+    }
+
+    if (argc == 5 && strcmp(argv[1], "--benchmark-server") == 0)
+    {
+        int port, players;
+
+        if (!parse_count_argument(argv[2], 65535, &port) || !parse_count_argument(argv[3], MAX_SESSIONS, &players) ||
+            !parse_count_argument(argv[4], INT_MAX / 2, &count))
+        {
+            return 1;
+        }
+        return run_server_benchmark(port, players, count);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--validate") == 0)
+    {
+        return run_validate(argv[2]);
+    }
+
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--headless") == 0)
+    {
+        return run_headless(argv[2], argc == 4 ? argv[3] : NULL);
+    }
+
     if (argc != 2)
     {
         // We use fprintf to stderr for error messages.
-        fprintf(stderr, "Usage: %s <world_map_file>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <world_map_file | world_image_file>\n", argv[0]);
+        fprintf(stderr, "       %s --headless <world_file> [command_file]\n", argv[0]);
+        fprintf(stderr, "       %s --compile <world_map_file> <world_image_file>\n", argv[0]);
+        fprintf(stderr, "       %s --generate <room_count> <link_percent> <seed> <world_map_file>\n", argv[0]);
+        fprintf(stderr, "       %s --validate <world_file>\n", argv[0]);
+        fprintf(stderr, "       %s --server <world_file> <port>\n", argv[0]);
+        fprintf(stderr, "       %s --benchmark-load <room_count> <scratch_map_file>\n", argv[0]);
+        fprintf(stderr, "       %s --benchmark-scale <max_room_count> <scratch_map_file>\n", argv[0]);
+        fprintf(stderr, "       %s --benchmark-commands <world_file> <command_count>\n", argv[0]);
+        fprintf(stderr, "       %s --benchmark-render <world_file> <turn_count>\n", argv[0]);
+        fprintf(stderr, "       %s --benchmark-server <port> <player_count> <commands_per_player>\n", argv[0]);
         return 1;
     }
 
@@ -243,12 +765,16 @@ int main(int argc, char *argv[])
         // load_world will have already printed an error.
         return 1;
     }
+    if (!enable_saving(game, argv[1]))
+    {
+        cleanup(game);
+        return 1;
+    }
 
     ui_init(game); // Initialize the ncurses interface
 
     // Set the player's starting location.
-    game->player.current_room = find_room_by_id(game, 0);
-    if (game->player.current_room == NULL)
+    if (!place_player_at_start(game))
     {
         ui_cleanup(game);
         cleanup(game);
@@ -275,40 +801,58 @@ int main(int argc, char *argv[])
 // =====================================================================================
 
 /**
- * @brief Loads the entire game world from a data file.
- * This function demonstrates dynamic allocation, file I/O, and robust parsing.
+ * @brief Loads the game world from a text map or a compiled world image.
  */
 GameState *load_world(const char *filename)
 {
-    // Dynamically allocate the main GameState struct.
-    GameState *game = malloc(sizeof(GameState));
+    if (is_world_image(filename))
+    {
+        return load_world_image(filename);
+    }
+    return load_world_text(filename);
+}
+
+/**
+ * @brief Loads the entire game world from a text data file.
+ * This function demonstrates dynamic allocation, file I/O, and robust parsing.
+ */
+GameState *load_world_text(const char *filename)
+{
+    size_t length;
+    char *contents = read_world_file(filename, &length);
+    char *cursor = contents;
+    char *line;
     int line_number = 0;
     int line_status;
-    if (!game)
-        return NULL;
-    // ALWAYS initialize allocated memory.
-    memset(game, 0, sizeof(GameState));
 
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    if (!contents)
     {
-        perror("Error opening world file");
-        free(game);
         return NULL;
     }
 
-    char line[WORLD_LINE_BUFFER_SIZE];
+    // Dynamically allocate the main GameState struct.
+    GameState *game = malloc(sizeof(GameState));
+    if (!game)
+    {
+        free(contents);
+        return NULL;
+    }
+    // ALWAYS initialize allocated memory.
+    memset(game, 0, sizeof(GameState));
 
-    // --- TWO-PASS LOADING ---
-    // This is a common and robust technique for loading interconnected data.
-    // Pass 1: Read all room definitions and allocate memory for them.
-    while ((line_status = read_world_line(file, line, sizeof(line))) != 0)
+    // --- SINGLE-PASS LOADING WITH DEFERRED LINKS ---
+    // A link can only be connected once both of its rooms exist, but rooms and
+    // links may appear in any order. Instead of reading the file twice, we read
+    // it once: rooms are created immediately and links are written down in a
+    // small array. When the file is done, every room is known and we connect
+    // the links in one final sweep.
+    while ((line_status = next_world_line(&cursor, &line)) != 0)
     {
         line_number++;
         if (line_status < 0)
         {
             fprintf(stderr, "Error: world file line %d is too long.\n", line_number);
-            fclose(file);
+            free(contents);
             cleanup(game);
             return NULL;
         }
@@ -318,143 +862,478 @@ GameState *load_world(const char *filename)
             if (!parse_room(line, game))
             {
                 fprintf(stderr, "Error parsing room definition on line %d.\n", line_number);
-                fclose(file);
+                free(contents);
                 cleanup(game);
                 return NULL;
             }
         }
-    }
-
-    // Rewind the file pointer to the beginning for the second pass.
-    rewind(file);
-    line_number = 0;
-
-    // Pass 2: Read all link definitions and connect the already-created rooms.
-    while ((line_status = read_world_line(file, line, sizeof(line))) != 0)
-    {
-        line_number++;
-        if (line_status < 0)
-        {
-            fprintf(stderr, "Error: world file line %d is too long.\n", line_number);
-            fclose(file);
-            cleanup(game);
-            return NULL;
-        }
-
-        if (strncmp(line, "link", 4) == 0)
+        else if (strncmp(line, "link", 4) == 0)
         {
             if (!parse_link(line, game))
             {
                 fprintf(stderr, "Error parsing link definition on line %d.\n", line_number);
-                fclose(file);
+                free(contents);
                 cleanup(game);
                 return NULL;
             }
+            game->pending_links[game->num_pending_links - 1].line_number = line_number;
         }
     }
 
-    fclose(file);
+    // The text has been copied into the rooms, so the file buffer can go.
+    free(contents);
+
+    if (!resolve_links(game))
+    {
+        cleanup(game);
+        return NULL;
+    }
+
+    // The duplicate-finding index is only needed while rooms are being added.
+    string_pool_free_index(&game->strings);
     return game;
 }
 
 /**
- * @brief Parses a 'room' line and creates a Room struct.
+ * @brief Checks whether a file starts with the world image magic bytes.
  */
-int parse_room(char *line, GameState *game)
+int is_world_image(const char *filename)
 {
-    char *cursor = line;
-    if (game->num_rooms >= MAX_ROOMS)
-        return 0; // Guard against overflow.
-
-    int id;
-    char desc[ROOM_DESCRIPTION_SIZE];
-    size_t desc_length = 0;
+    char magic[WORLD_IMAGE_MAGIC_SIZE];
+    FILE *file = fopen(filename, "rb");
+    int matches;
 
-    if (strncmp(cursor, "room", 4) != 0 || !isspace((unsigned char)cursor[4]))
+    if (!file)
     {
-        return 0;
+        return 0; // load_world_text() will report the error.
     }
-    cursor += 4;
 
-    if (!parse_int_token(&cursor, &id))
+    matches = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              memcmp(magic, WORLD_IMAGE_MAGIC, WORLD_IMAGE_MAGIC_SIZE) == 0;
+    fclose(file);
+    return matches;
+}
+
+/**
+ * @brief Loads a compiled world image with a single mmap().
+ * There is no parsing and no per-room work at all. The image has the same
+ * layout as the world in memory, so `rooms` and the string pool simply point
+ * into the mapping, and loading takes the same time for ten rooms or ten
+ * million. Pages are read from disk only when a room is actually visited.
+ */
+GameState *load_world_image(const char *filename)
+{
+    struct stat info;
+    const WorldImageHeader *header;
+    uint64_t room_bytes;
+    char *image;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
     {
-        return 0;
+        perror("Error opening world image");
+        return NULL;
     }
 
-    cursor = skip_whitespace(cursor);
-    if (*cursor != '"')
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < sizeof(WorldImageHeader))
     {
-        return 0;
+        fprintf(stderr, "Error: %s is not a valid world image.\n", filename);
+        close(fd);
+        return NULL;
     }
-    cursor++;
 
-    while (*cursor != '"' && *cursor != '\0')
+    // Ask the operating system to map the file into our address space.
+    image = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (image == MAP_FAILED)
     {
-        if (desc_length >= sizeof(desc) - 1)
-        {
-            return 0;
-        }
-
-        desc[desc_length++] = *cursor;
-        cursor++;
+        perror("Error mapping world image");
+        close(fd);
+        return NULL;
     }
 
-    if (*cursor != '"')
+    header = (const WorldImageHeader *)image;
+    room_bytes = (uint64_t)header->room_count * sizeof(Room);
+    // Every description must end inside the pool. Because the pool itself
+    // ends with '\0', any offset inside it is safe to read as a string.
+    if (header->version != WORLD_IMAGE_VERSION || header->room_count < 1 || header->room_count > MAX_ROOMS ||
+        header->string_pool_size < 1 ||
+        sizeof(WorldImageHeader) + room_bytes + header->string_pool_size != (uint64_t)info.st_size ||
+        image[info.st_size - 1] != '\0')
     {
-        return 0;
+        fprintf(stderr, "Error: %s is not a valid world image.\n", filename);
+        munmap(image, (size_t)info.st_size);
+        close(fd);
+        return NULL;
     }
 
-    desc[desc_length] = '\0';
-    cursor++;
-
-    if (!has_only_trailing_whitespace(cursor) || find_room_by_id(game, id) != NULL)
+    GameState *game = malloc(sizeof(GameState));
+    if (!game)
     {
-        return 0;
+        munmap(image, (size_t)info.st_size);
+        close(fd);
+        return NULL;
     }
-
-    Room *new_room = malloc(sizeof(Room));
-    if (!new_room)
-        return 0;
-
-    memset(new_room, 0, sizeof(Room)); // Initialize room exits to NULL.
-    new_room->id = id;
-    memcpy(new_room->description, desc, desc_length + 1);
-
-    game->all_rooms[game->num_rooms++] = new_room;
-    return 1;
+    memset(game, 0, sizeof(GameState));
+    game->image = image;
+    game->image_size = (size_t)info.st_size;
+
+    // Nothing is read from the file yet: the operating system loads each page
+    // the first time we touch it. For a world bigger than our memory budget,
+    // we also track which regions are loaded, so that we can give some back.
+    game->region_count = (game->image_size + REGION_SIZE - 1) / REGION_SIZE;
+    if (game->region_count > MAX_RESIDENT_REGIONS)
+    {
+        game->region_last_use = calloc(game->region_count, sizeof(uint64_t));
+    }
+    close(fd); // The mapping stays valid after the descriptor is closed.
+
+    // The mapping is read-only: the game never changes a room after loading.
+    // Exit indices and description offsets are bounds-checked when they are
+    // used (see room_exit() and room_description()), so a damaged image cannot
+    // make us read outside the mapping.
+    game->rooms = (Room *)(image + sizeof(WorldImageHeader));
+    game->num_rooms = (int)header->room_count;
+    game->room_capacity = game->num_rooms;
+    game->strings.data = image + sizeof(WorldImageHeader) + room_bytes;
+    game->strings.length = (size_t)header->string_pool_size;
+    game->strings.capacity = game->strings.length;
+    index_room_ids(game);
+    return game;
 }
-
 /**
- * @brief Parses a 'link' line and connects two existing rooms.
+ * @brief Loads a text map and writes it back out as a world image.
+ * Because the image mirrors the in-memory layout, writing it is just three
+ * fwrite() calls: the header, the room array and the string pool.
  */
-int parse_link(char *line, GameState *game)
+int compile_world(const char *map_filename, const char *image_filename)
 {
-    char *cursor = line;
-    int from_id, to_id;
-    char dir_str[10];
-    size_t dir_length = 0;
+    GameState *game = load_world_text(map_filename);
+    WorldImageHeader header;
+    FILE *file;
 
-    if (strncmp(cursor, "link", 4) != 0 || !isspace((unsigned char)cursor[4]))
+    if (!game)
     {
         return 0;
     }
-    cursor += 4;
 
-    if (!parse_int_token(&cursor, &from_id))
+    file = fopen(image_filename, "wb");
+    if (!file)
     {
+        perror("Error creating world image");
+        cleanup(game);
         return 0;
     }
 
-    cursor = skip_whitespace(cursor);
-    if (*cursor == '\0')
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORLD_IMAGE_MAGIC, WORLD_IMAGE_MAGIC_SIZE);
+    header.version = WORLD_IMAGE_VERSION;
+    header.room_count = (uint32_t)game->num_rooms;
+    header.string_pool_size = game->strings.length;
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(game->rooms, sizeof(Room), (size_t)game->num_rooms, file);
+    fwrite(game->strings.data, 1, game->strings.length, file);
+
+    int write_failed = ferror(file);
+    if (fclose(file) != 0 || write_failed)
     {
+        perror("Error writing world image");
+        cleanup(game);
         return 0;
     }
 
-    while (*cursor != '\0' && !isspace((unsigned char)*cursor))
-    {
-        if (dir_length >= sizeof(dir_str) - 1)
-        {
+    printf("Compiled %d rooms from %s into %s.\n", game->num_rooms, map_filename, image_filename);
+    cleanup(game);
+    return 1;
+}
+/**
+ * @brief Reads a whole file into one NUL-terminated heap buffer.
+ * We read in large chunks rather than a line at a time, so even a huge map
+ * costs only a handful of calls into the C library.
+ */
+char *read_world_file(const char *filename, size_t *length)
+{
+    FILE *file = fopen(filename, "rb");
+    char *buffer = NULL;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t bytes_read;
+
+    if (!file)
+    {
+        perror("Error opening world file");
+        return NULL;
+    }
+
+    do
+    {
+        // Always keep room for one more chunk plus the terminating '\0'.
+        if (capacity - used < WORLD_READ_CHUNK_SIZE + 1)
+        {
+            size_t new_capacity = capacity ? capacity * 2 : WORLD_READ_CHUNK_SIZE + 1;
+            char *grown = realloc(buffer, new_capacity);
+
+            if (!grown)
+            {
+                fprintf(stderr, "Error: not enough memory to read the world file.\n");
+                free(buffer);
+                fclose(file);
+                return NULL;
+            }
+            buffer = grown;
+            capacity = new_capacity;
+        }
+
+        bytes_read = fread(buffer + used, 1, WORLD_READ_CHUNK_SIZE, file);
+        used += bytes_read;
+    } while (bytes_read == WORLD_READ_CHUNK_SIZE);
+
+    if (ferror(file))
+    {
+        perror("Error reading world file");
+        free(buffer);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    buffer[used] = '\0';
+    *length = used;
+    return buffer;
+}
+
+/**
+ * @brief Parses a 'room' line and creates a Room struct.
+ */
+int parse_room(char *line, GameState *game)
+{
+    char *cursor = line;
+    if (game->num_rooms >= MAX_ROOMS)
+        return 0; // Guard against absurdly large maps.
+
+    int id;
+    char desc[ROOM_DESCRIPTION_SIZE];
+    size_t desc_length = 0;
+
+    if (strncmp(cursor, "room", 4) != 0 || !isspace((unsigned char)cursor[4]))
+    {
+        return 0;
+    }
+    cursor += 4;
+
+    if (!parse_int_token(&cursor, &id))
+    {
+        return 0;
+    }
+
+    cursor = skip_whitespace(cursor);
+    if (*cursor != '"')
+    {
+        return 0;
+    }
+    cursor++;
+
+    while (*cursor != '"' && *cursor != '\0')
+    {
+        if (desc_length >= sizeof(desc) - 1)
+        {
+            return 0;
+        }
+
+        desc[desc_length++] = *cursor;
+        cursor++;
+    }
+
+    if (*cursor != '"')
+    {
+        return 0;
+    }
+
+    desc[desc_length] = '\0';
+    cursor++;
+
+    // Duplicate ids are caught later, once all rooms are sorted by id.
+    if (!has_only_trailing_whitespace(cursor))
+    {
+        return 0;
+    }
+
+    if (game->num_rooms == game->room_capacity)
+    {
+        // Double the room array whenever it fills up. Rooms are stored by
+        // value, side by side, so there is no per-room malloc() at all.
+        int new_capacity = game->room_capacity ? game->room_capacity * 2 : INITIAL_ROOM_CAPACITY;
+        Room *grown = realloc(game->rooms, (size_t)new_capacity * sizeof(Room));
+
+        if (!grown)
+            return 0;
+        game->rooms = grown;
+        game->room_capacity = new_capacity;
+    }
+
+    Room *new_room = &game->rooms[game->num_rooms];
+    if (!string_pool_add(&game->strings, desc, desc_length, &new_room->description))
+        return 0;
+
+    new_room->id = id;
+    for (int d = 0; d < MAX_DIRECTIONS; d++)
+    {
+        new_room->exits[d] = NO_ROOM; // No exits until the links are resolved.
+    }
+
+    game->num_rooms++;
+    return 1;
+}
+
+/**
+ * @brief FNV-1a, a tiny and well-spread string hash.
+ */
+uint32_t hash_text(const char *text, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Stores `text` in the pool (once) and reports its offset.
+ * If the same text was added before, we hand back the existing offset.
+ */
+int string_pool_add(StringPool *pool, const char *text, size_t length, uint32_t *offset)
+{
+    size_t mask;
+    size_t slot;
+
+    // Keep the table at most half full so searches stay short.
+    if ((pool->used_slots + 1) * 2 > pool->slot_count && !string_pool_grow_slots(pool))
+    {
+        return 0;
+    }
+
+    mask = pool->slot_count - 1;
+    slot = hash_text(text, length) & mask;
+    while (pool->slots[slot] != 0)
+    {
+        const char *stored = pool->data + pool->slots[slot] - 1;
+
+        if (strncmp(stored, text, length) == 0 && stored[length] == '\0')
+        {
+            *offset = pool->slots[slot] - 1;
+            return 1;
+        }
+        slot = (slot + 1) & mask; // Linear probing: try the next slot.
+    }
+
+    if (pool->length + length + 1 >= UINT32_MAX)
+    {
+        return 0; // Offsets are 32-bit (and stored as offset + 1).
+    }
+
+    if (pool->length + length + 1 > pool->capacity)
+    {
+        size_t new_capacity = pool->capacity ? pool->capacity : INITIAL_STRING_POOL_SIZE;
+        char *grown;
+
+        while (new_capacity < pool->length + length + 1)
+        {
+            new_capacity *= 2;
+        }
+        grown = realloc(pool->data, new_capacity);
+        if (!grown)
+        {
+            return 0;
+        }
+        pool->data = grown;
+        pool->capacity = new_capacity;
+    }
+
+    memcpy(pool->data + pool->length, text, length);
+    pool->data[pool->length + length] = '\0';
+    *offset = (uint32_t)pool->length;
+    pool->slots[slot] = *offset + 1;
+    pool->used_slots++;
+    pool->length += length + 1;
+    return 1;
+}
+
+/**
+ * @brief Doubles the pool's hash table and re-inserts every stored offset.
+ */
+int string_pool_grow_slots(StringPool *pool)
+{
+    size_t new_count = pool->slot_count ? pool->slot_count * 2 : INITIAL_STRING_POOL_SLOTS;
+    uint32_t *new_slots = calloc(new_count, sizeof(uint32_t));
+
+    if (!new_slots)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < pool->slot_count; i++)
+    {
+        if (pool->slots[i] != 0)
+        {
+            const char *stored = pool->data + pool->slots[i] - 1;
+            size_t slot = hash_text(stored, strlen(stored)) & (new_count - 1);
+
+            while (new_slots[slot] != 0)
+            {
+                slot = (slot + 1) & (new_count - 1);
+            }
+            new_slots[slot] = pool->slots[i];
+        }
+    }
+
+    free(pool->slots);
+    pool->slots = new_slots;
+    pool->slot_count = new_count;
+    return 1;
+}
+
+void string_pool_free_index(StringPool *pool)
+{
+    free(pool->slots);
+    pool->slots = NULL;
+    pool->slot_count = 0;
+    pool->used_slots = 0;
+}
+
+/**
+ * @brief Parses a 'link' line and records it for resolve_links().
+ */
+int parse_link(char *line, GameState *game)
+{
+    char *cursor = line;
+    int from_id, to_id;
+    char dir_str[10];
+    size_t dir_length = 0;
+
+    if (strncmp(cursor, "link", 4) != 0 || !isspace((unsigned char)cursor[4]))
+    {
+        return 0;
+    }
+    cursor += 4;
+
+    if (!parse_int_token(&cursor, &from_id))
+    {
+        return 0;
+    }
+
+    cursor = skip_whitespace(cursor);
+    if (*cursor == '\0')
+    {
+        return 0;
+    }
+
+    while (*cursor != '\0' && !isspace((unsigned char)*cursor))
+    {
+        if (dir_length >= sizeof(dir_str) - 1)
+        {
             return 0;
         }
 
@@ -468,12 +1347,6 @@ int parse_link(char *line, GameState *game)
         return 0;
     }
 
-    Room *from_room = find_room_by_id(game, from_id);
-    Room *to_room = find_room_by_id(game, to_id);
-
-    if (!from_room || !to_room)
-        return 0; // One of the rooms doesn't exist.
-
     Direction dir;
     if (strcmp(dir_str, "n") == 0)
         dir = NORTH;
@@ -486,311 +1359,2574 @@ int parse_link(char *line, GameState *game)
     else
         return 0; // Invalid direction.
 
-    // This is the magic: we store a POINTER to the 'to' room in the 'from' room's exit array.
-    from_room->exits[dir] = to_room;
+    if (game->num_pending_links == game->pending_link_capacity)
+    {
+        int new_capacity = game->pending_link_capacity ? game->pending_link_capacity * 2 : INITIAL_ROOM_CAPACITY;
+        PendingLink *grown = realloc(game->pending_links, (size_t)new_capacity * sizeof(PendingLink));
+
+        if (!grown)
+            return 0;
+        game->pending_links = grown;
+        game->pending_link_capacity = new_capacity;
+    }
+
+    PendingLink *link = &game->pending_links[game->num_pending_links++];
+    link->from_id = from_id;
+    link->to_id = to_id;
+    link->direction = dir;
+    link->line_number = 0;
+    return 1;
+}
+
+/**
+ * @brief Sorts the rooms by id and connects every recorded link.
+ * Sorting once lets find_room_by_id() use a binary search, so connecting
+ * N links costs O(N log N) instead of scanning every room for every link.
+ */
+int resolve_links(GameState *game)
+{
+    if (game->num_rooms > 1)
+    {
+        qsort(game->rooms, (size_t)game->num_rooms, sizeof(Room), compare_rooms_by_id);
+    }
+
+    // After sorting, two rooms with the same id sit right next to each other.
+    for (int i = 1; i < game->num_rooms; i++)
+    {
+        if (game->rooms[i - 1].id == game->rooms[i].id)
+        {
+            fprintf(stderr, "Error: room %d is defined more than once.\n", (int)game->rooms[i].id);
+            return 0;
+        }
+    }
+
+    index_room_ids(game);
+    for (int i = 0; i < game->num_pending_links; i++)
+    {
+        PendingLink *link = &game->pending_links[i];
+        Room *from_room = find_room_by_id(game, link->from_id);
+        Room *to_room = find_room_by_id(game, link->to_id);
+
+        if (!from_room || !to_room)
+        {
+            // One of the rooms doesn't exist.
+            fprintf(stderr, "Error parsing link definition on line %d.\n", link->line_number);
+            return 0;
+        }
+
+        // This is the magic: we store the INDEX of the 'to' room in the 'from' room's exit array.
+        // Subtracting two pointers into the same array gives that index.
+        from_room->exits[link->direction] = (uint32_t)(to_room - game->rooms);
+    }
+
+    free(game->pending_links);
+    game->pending_links = NULL;
+    game->num_pending_links = 0;
+    game->pending_link_capacity = 0;
     return 1;
 }
 
+int compare_rooms_by_id(const void *a, const void *b)
+{
+    const Room *left = a;
+    const Room *right = b;
+
+    return (left->id > right->id) - (left->id < right->id);
+}
+
+/**
+ * @brief Notes whether the sorted room ids have gaps, for find_room_by_id().
+ * Called once the rooms are final.
+ */
+void index_room_ids(GameState *game)
+{
+    const Room *first;
+    const Room *last;
+
+    game->room_ids_dense = 0;
+    if (game->num_rooms == 0)
+    {
+        return;
+    }
+    first = &game->rooms[0];
+    last = &game->rooms[game->num_rooms - 1];
+    world_touch(game, first, sizeof(Room));
+    world_touch(game, last, sizeof(Room));
+    game->first_room_id = first->id;
+    game->room_ids_dense = (long long)last->id - first->id == game->num_rooms - 1;
+}
+
+/**
+ * @brief A helper function to find a room pointer from its integer ID.
+ * The rooms must already be sorted by id (resolve_links() does this).
+ */
+Room *find_room_by_id(GameState *game, int id)
+{
+    int low = 0;
+    int high = game->num_rooms - 1;
+
+    // Most maps number their rooms 0, 1, 2, ... with no gaps. Then the room
+    // with a given id sits at a position we can simply calculate.
+    if (game->room_ids_dense)
+    {
+        long long index = (long long)id - game->first_room_id;
+        Room *room = index >= 0 && index < game->num_rooms ? &game->rooms[index] : NULL;
+
+        if (room)
+        {
+            world_touch(game, room, sizeof(Room));
+        }
+        return room;
+    }
+
+    // Otherwise, a binary search. bsearch() would find the room too, but we
+    // must touch every room we look at, so that its page counts against the
+    // region budget.
+    while (low <= high)
+    {
+        int middle = low + (high - low) / 2;
+        Room *room = &game->rooms[middle];
+
+        world_touch(game, room, sizeof(Room));
+        if (room->id == id)
+        {
+            return room;
+        }
+        if (room->id < id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+    return NULL; // Not found.
+}
+
+/**
+ * @brief Follows an exit index to the neighbouring room, or returns NULL.
+ */
+Room *room_exit(GameState *game, const Room *room, Direction d)
+{
+    uint32_t index = room->exits[d];
+
+    if (index >= (uint32_t)game->num_rooms)
+    {
+        return NULL;
+    }
+    world_touch(game, &game->rooms[index], sizeof(Room)); // We are about to visit this room.
+    return &game->rooms[index];
+}
+
+/**
+ * @brief Turns a room's description offset back into a string.
+ */
+const char *room_description(GameState *game, const Room *room)
+{
+    if (room->description >= game->strings.length)
+    {
+        return "";
+    }
+    const char *description = game->strings.data + room->description;
+
+    // strlen() reads the string first; touching it right after still counts
+    // every region it spans, including one it runs on into.
+    world_touch(game, description, strlen(description) + 1);
+    return description;
+}
+
+// =====================================================================================
+// |                            - STREAMING WORLD REGIONS -                            |
+// =====================================================================================
+// A world image is mapped into memory all at once, but the operating system
+// only reads a page from disk when we first touch it. That makes startup
+// instant, but on its own every page we ever touched would stay in memory.
+// To keep memory bounded, we split the image into fixed-size regions and keep
+// at most MAX_RESIDENT_REGIONS of them. When one more is needed, the region
+// that was used least recently (LRU) is given back to the operating system.
+// Rooms are sorted by id, so rooms with nearby ids share a region.
+
+/**
+ * @brief Notes that the game is using `size` bytes of the world image at
+ * `address`, loading their regions if needed. Called whenever we follow an
+ * exit or read a description, so the regions a player is approaching are
+ * loaded first. A room or a string may cross into the next region, so
+ * every region from the first byte to the last is touched.
+ */
+void world_touch(GameState *game, const void *address, size_t size)
+{
+    size_t offset;
+
+    if (!game->region_last_use)
+    {
+        return; // A text world, or an image small enough to keep whole.
+    }
+
+    offset = (size_t)((const char *)address - (const char *)game->image);
+    for (size_t region = offset / REGION_SIZE; region <= (offset + size - 1) / REGION_SIZE; region++)
+    {
+        world_touch_region(game, region);
+    }
+}
+
+/**
+ * @brief Marks one region as just used, loading it (and evicting the least
+ * recently used one) if it was not in memory.
+ */
+void world_touch_region(GameState *game, size_t region)
+{
+    if (game->region_last_use[region] == 0)
+    {
+        if (game->resident_regions >= MAX_RESIDENT_REGIONS)
+        {
+            world_evict_oldest_region(game);
+        }
+        world_load_region(game, region);
+        game->resident_regions++;
+    }
+    game->region_last_use[region] = ++game->region_clock;
+}
+
+/**
+ * @brief Reads a whole region in at once, instead of one page fault at a
+ * time as the player wanders through it.
+ */
+void world_load_region(GameState *game, size_t region)
+{
+    const volatile char *bytes = (const char *)game->image;
+    size_t start = region * REGION_SIZE;
+    size_t end = start + REGION_SIZE < game->image_size ? start + REGION_SIZE : game->image_size;
+
+    // `volatile` makes the compiler really perform each read.
+    for (size_t offset = start; offset < end; offset += REGION_TOUCH_STRIDE)
+    {
+        (void)bytes[offset];
+    }
+}
+
+/**
+ * @brief Gives the least recently used region back to the operating system.
+ */
+void world_evict_oldest_region(GameState *game)
+{
+    size_t oldest = 0;
+    uint64_t oldest_use = UINT64_MAX;
+
+    for (size_t region = 0; region < game->region_count; region++)
+    {
+        if (game->region_last_use[region] != 0 && game->region_last_use[region] < oldest_use)
+        {
+            oldest = region;
+            oldest_use = game->region_last_use[region];
+        }
+    }
+
+    // If the pages could not be dropped, the region is still in memory, so it
+    // stays in the LRU set and the counts keep telling the truth.
+    if (world_release_region(game, oldest))
+    {
+        game->region_last_use[oldest] = 0;
+        game->resident_regions--;
+        game->region_evictions++;
+    }
+}
+
+/**
+ * @brief Drops a region's pages from memory. Returns 1 on success, 0 on
+ * failure.
+ */
+int world_release_region(GameState *game, size_t region)
+{
+    // MADV_DONTNEED throws the pages of our private, read-only mapping away.
+    // The addresses stay valid: if a pointer into this region is used later,
+    // the data is simply read from the file again.
+    size_t start = region * REGION_SIZE;
+    size_t length = start + REGION_SIZE < game->image_size ? REGION_SIZE : game->image_size - start;
+
+    if (madvise((char *)game->image + start, length, MADV_DONTNEED) != 0)
+    {
+        perror("Error releasing a world region");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Drops every region that is not in the LRU set. Used after work,
+ * like a map search, that reads the whole image without going through
+ * world_touch().
+ */
+void world_release_untracked(GameState *game)
+{
+    if (!game->region_last_use)
+    {
+        return;
+    }
+
+    for (size_t region = 0; region < game->region_count; region++)
+    {
+        if (game->region_last_use[region] == 0)
+        {
+            world_release_region(game, region);
+        }
+    }
+}
+const char *direction_to_string(Direction d)
+{
+    switch (d)
+    {
+    case NORTH:
+        return "north";
+    case SOUTH:
+        return "south";
+    case EAST:
+        return "east";
+    case WEST:
+        return "west";
+    }
+    return "unknown";
+}
+
+// =====================================================================================
+// |                                  - PATHFINDING -                                  |
+// =====================================================================================
+
+/**
+ * @brief Breadth-first search from `start` along room exits.
+ * BFS visits rooms in order of distance, so the first time it reaches a room
+ * it has found a shortest way there. Pass NULL as `target` to visit every
+ * room that can be reached. Afterwards, `search_parent` leads from any reached
+ * room back to `start`.
+ * @return How many rooms were reached, or -1 if we ran out of memory.
+ */
+int search_rooms(GameState *game, const Room *start, const Room *target)
+{
+    uint32_t head = 0, tail = 0;
+
+    if (!game->search_visited)
+    {
+        size_t count = (size_t)game->num_rooms;
+
+        game->search_visited = calloc(count, sizeof(uint32_t));
+        game->search_parent = malloc(count * sizeof(uint32_t));
+        game->search_queue = malloc(count * sizeof(uint32_t));
+        if (!game->search_visited || !game->search_parent || !game->search_queue)
+        {
+            return -1;
+        }
+    }
+
+    // Instead of clearing the visited array before every search, each search
+    // gets a new number, and only rooms marked with that number count as
+    // visited. We only clear it when the counter wraps around.
+    if (++game->search_generation == 0)
+    {
+        memset(game->search_visited, 0, (size_t)game->num_rooms * sizeof(uint32_t));
+        game->search_generation = 1;
+    }
+
+    uint32_t first = (uint32_t)(start - game->rooms);
+    game->search_visited[first] = game->search_generation;
+    game->search_parent[first] = first;
+    game->search_queue[tail++] = first;
+
+    while (head < tail)
+    {
+        uint32_t current = game->search_queue[head++];
+
+        if (&game->rooms[current] == target)
+        {
+            break;
+        }
+
+        // We read the exits directly instead of calling room_exit(): a search
+        // over a huge world would otherwise keep swapping regions in and out.
+        // The regions it pulled in are released again below.
+        for (int d = 0; d < MAX_DIRECTIONS; d++)
+        {
+            uint32_t index = game->rooms[current].exits[d];
+
+            if (index >= (uint32_t)game->num_rooms)
+            {
+                continue;
+            }
+            if (game->search_visited[index] != game->search_generation)
+            {
+                game->search_visited[index] = game->search_generation;
+                game->search_parent[index] = current;
+                game->search_queue[tail++] = index;
+            }
+        }
+    }
+
+    world_release_untracked(game);
+    return (int)tail;
+}
+
+/**
+ * @brief Writes the shortest way from `start` to `target` into `buffer`,
+ * like "north, east x3, south". Repeated steps are counted, not repeated.
+ * @return The number of steps, or -1 if there is no way there.
+ */
+int describe_path(GameState *game, const Room *start, const Room *target, char *buffer, size_t size)
+{
+    uint32_t first = (uint32_t)(start - game->rooms);
+    uint32_t last = (uint32_t)(target - game->rooms);
+    uint32_t steps = 0;
+    size_t used = 0;
+
+    if (search_rooms(game, start, target) < 0 || game->search_visited[last] != game->search_generation)
+    {
+        return -1;
+    }
+
+    // The parents lead backwards, so collect the rooms from the target back
+    // to the start (the search is over, so its queue is free to reuse).
+    for (uint32_t room = last; room != first; room = game->search_parent[room])
+    {
+        game->search_queue[steps++] = room;
+    }
+
+    buffer[0] = '\0';
+    for (uint32_t i = steps; i > 0;)
+    {
+        uint32_t from = i == steps ? first : game->search_queue[i];
+        uint32_t run = 0;
+        Direction direction = NORTH;
+
+        // Which exit leads to the next room on the path?
+        for (int d = 0; d < MAX_DIRECTIONS; d++)
+        {
+            if (game->rooms[from].exits[d] == game->search_queue[i - 1])
+            {
+                direction = d;
+                break;
+            }
+        }
+
+        // Count how many steps in a row go the same way.
+        do
+        {
+            from = game->search_queue[--i];
+            run++;
+        } while (i > 0 && game->rooms[from].exits[direction] == game->search_queue[i - 1]);
+
+        if (used < size)
+        {
+            int written = run > 1 ? snprintf(buffer + used, size - used, "%s%s x%u", used ? ", " : "",
+                                              direction_to_string(direction), (unsigned)run)
+                                   : snprintf(buffer + used, size - used, "%s%s", used ? ", " : "",
+                                              direction_to_string(direction));
+            used += written > 0 ? (size_t)written : 0;
+        }
+    }
+
+    // If the directions did not fit, end them with "..." to show that.
+    if (used >= size && size > 4)
+    {
+        strcpy(buffer + size - 4, "...");
+    }
+    return (int)steps;
+}
+
+// =====================================================================================
+// |                                - COMMAND HANDLING -                               |
+// =====================================================================================
+
+// This array of structs is our command table. It pairs a command string with
+// the function pointer that handles it. This is a very clean, scalable design.
+// Direction words are commands too, so "north" works on its own and "go north"
+// can look up its argument in the same table.
+Command command_table[] = {
+    {"quit", handle_quit, NOT_A_DIRECTION},
+    {"exit", handle_quit, NOT_A_DIRECTION},
+    {"look", handle_look, NOT_A_DIRECTION},
+    {"l", handle_look, NOT_A_DIRECTION},
+    {"go", handle_go, NOT_A_DIRECTION},
+    {"north", handle_go, NORTH},
+    {"south", handle_go, SOUTH},
+    {"east", handle_go, EAST},
+    {"west", handle_go, WEST},
+    {"n", handle_go, NORTH},
+    {"s", handle_go, SOUTH},
+    {"e", handle_go, EAST},
+    {"w", handle_go, WEST},
+    {"help", handle_help, NOT_A_DIRECTION},
+    {"path", handle_path, NOT_A_DIRECTION},
+    {"save", handle_save, NOT_A_DIRECTION},
+    {"load", handle_load, NOT_A_DIRECTION},
+    {NULL, NULL, NOT_A_DIRECTION} // Sentinel to mark the end of the array.
+};
+
+_Static_assert(sizeof(command_table) / sizeof(command_table[0]) - 1 <= COMMAND_HASH_SIZE,
+               "Too many commands for the command hash table");
+
+// A "perfect" hash table for the command table: every command lands in its own
+// slot, so looking up a word costs one hash and at most one strcmp, however
+// many commands we add. The seed that makes this work is found at startup.
+static const Command *command_slots[COMMAND_HASH_SIZE];
+static uint32_t command_hash_seed;
+static int command_hash_ready = 0;
+
+/**
+ * @brief Hashes a word into a slot of the command hash table.
+ */
+uint32_t command_hash(const char *word, uint32_t seed)
+{
+    // Mix the seed into the FNV-1a hash, then keep the top bits of a
+    // multiplication, which depend on every bit of the input.
+    return ((hash_text(word, strlen(word)) ^ seed) * 2654435761u) >> (32 - COMMAND_HASH_BITS);
+}
+
+/**
+ * @brief Tries seeds until every command hashes to a different slot.
+ */
+void build_command_hash(void)
+{
+    for (uint32_t seed = 0; seed < MAX_COMMAND_HASH_SEEDS; seed++)
+    {
+        int collision = 0;
+
+        memset(command_slots, 0, sizeof(command_slots));
+        for (int i = 0; command_table[i].command != NULL; i++)
+        {
+            uint32_t slot = command_hash(command_table[i].command, seed);
+
+            if (command_slots[slot])
+            {
+                collision = 1;
+                break;
+            }
+            command_slots[slot] = &command_table[i];
+        }
+
+        if (!collision)
+        {
+            command_hash_seed = seed;
+            command_hash_ready = 1;
+            return;
+        }
+    }
+
+    // Only possible if someone adds many more commands without growing
+    // COMMAND_HASH_BITS, so this is a bug in the program, not in the input.
+    fprintf(stderr, "Error: could not build the command hash table. Increase COMMAND_HASH_BITS.\n");
+    exit(1);
+}
+
+/**
+ * @brief Looks up a command word. Returns NULL for unknown words.
+ */
+const Command *find_command(const char *word)
+{
+    const Command *entry;
+
+    if (!command_hash_ready)
+    {
+        build_command_hash();
+    }
+
+    // Unknown words can land in a used slot, so we still compare once.
+    entry = command_slots[command_hash(word, command_hash_seed)];
+    if (entry && strcmp(entry->command, word) == 0)
+    {
+        return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Processes the user's raw input string, finds the correct command handler,
+ *        and calls it.
+ */
+void parse_and_execute_command(GameState *game, char *input)
+{
+    char *verb, *argument;
+    const Command *command;
+
+    finish_save(game, 0); // Report a save that finished since the last command.
+
+    // Convert input to lowercase for case-insensitive matching.
+    for (int i = 0; input[i]; i++)
+    {
+        input[i] = (char)tolower((unsigned char)input[i]);
+    }
+
+    verb = strtok(input, " \n"); // Tokenize the string by space or newline.
+    if (!verb)
+        return; // Empty input
+
+    argument = strtok(NULL, " \n");
+
+    command = find_command(verb);
+    if (!command)
+    {
+        ui_log(game, "I don't understand that command.");
+        return;
+    }
+
+    // Handle single-word movement commands like "north"
+    if (command->direction != NOT_A_DIRECTION)
+    {
+        argument = verb; // The argument to "go" is the verb itself.
+    }
+
+    // We found a match! Call the associated function pointer.
+    command->handler(game, argument);
+}
+
+void handle_quit(GameState *game, char *argument)
+{
+    (void)argument;
+    game->game_should_close = 1;
+}
+
+void handle_look(GameState *game, char *argument)
+{
+    (void)argument;
+    Room *room = game->player.current_room;
+    ui_log(game, room_description(game, room));
+
+    char exits_str[100] = "Exits: ";
+    int found_exit = 0;
+    for (int i = 0; i < MAX_DIRECTIONS; i++)
+    {
+        if (room_exit(game, room, i))
+        {
+            strcat(exits_str, direction_to_string(i));
+            strcat(exits_str, " ");
+            found_exit = 1;
+        }
+    }
+    if (found_exit)
+    {
+        ui_log(game, exits_str);
+    }
+    else
+    {
+        ui_log(game, "There are no obvious exits.");
+    }
+}
+
+void handle_go(GameState *game, char *argument)
+{
+    if (!argument)
+    {
+        ui_log(game, "Go where?");
+        return;
+    }
+
+    // Direction words live in the command table, so one lookup finds them.
+    const Command *command = find_command(argument);
+    int dir = command ? command->direction : NOT_A_DIRECTION;
+
+    if (dir == NOT_A_DIRECTION)
+    {
+        ui_log(game, "That's not a valid direction.");
+        return;
+    }
+
+    Room *next_room = room_exit(game, game->player.current_room, dir);
+    if (next_room)
+    {
+        game->player.current_room = next_room;
+        handle_look(game, NULL); // Automatically look after moving.
+    }
+    else
+    {
+        ui_log(game, "You can't go that way.");
+    }
+}
+
+void handle_help(GameState *game, char *argument)
+{
+    (void)argument;
+    ui_log(game, "--- Available Commands ---");
+    ui_log(game, "look (l): Describe the current room and exits.");
+    ui_log(game, "go <dir>: Move in a direction (north, south, east, west, or n,s,e,w).");
+    ui_log(game, "path <room>: Show the shortest way to a room.");
+    ui_log(game, "save / load: Save your place in the world, or go back to it.");
+    ui_log(game, "help: Show this help message.");
+    ui_log(game, "quit/exit: Leave the game.");
+}
+
+void handle_path(GameState *game, char *argument)
+{
+    char directions[LOG_MESSAGE_SIZE - 64];
+    char message[LOG_MESSAGE_SIZE];
+    char *cursor = argument;
+    Room *target;
+    int id, steps;
+
+    if (!argument || !parse_int_token(&cursor, &id) || !has_only_trailing_whitespace(cursor))
+    {
+        ui_log(game, "Path to where? Give a room number, like 'path 3'.");
+        return;
+    }
+
+    target = find_room_by_id(game, id);
+    if (!target)
+    {
+        snprintf(message, sizeof(message), "There is no room %d.", id);
+        ui_log(game, message);
+        return;
+    }
+    if (target == game->player.current_room)
+    {
+        ui_log(game, "You are already there.");
+        return;
+    }
+
+    steps = describe_path(game, game->player.current_room, target, directions, sizeof(directions));
+    if (steps < 0)
+    {
+        ui_log(game, "You can't get there from here.");
+        return;
+    }
+    snprintf(message, sizeof(message), "Path to room %d (%d step%s): %s", id, steps, steps == 1 ? "" : "s",
+             directions);
+    ui_log(game, message);
+}
+
+/**
+ * @brief Saves the game without making the player wait.
+ * Writing a file is quick, but making sure it has really reached the disk
+ * (fsync) can take a long time. So we fork(): the child process is a copy of
+ * the game that writes the save and exits, while the game carries on. The
+ * child writes a temporary file first and renames it over the old save only
+ * when it is complete, so a crash never leaves a half-written save behind.
+ */
+void handle_save(GameState *game, char *argument)
+{
+    SaveFile save;
+    char *temp_filename;
+    pid_t pid;
+
+    (void)argument;
+    if (!game->save_filename)
+    {
+        ui_log(game, "Saved games are not available here.");
+        return;
+    }
+    if (game->save_pid > 0)
+    {
+        ui_log(game, "Still saving the last game. Try again in a moment.");
+        return;
+    }
+
+    memset(&save, 0, sizeof(save));
+    memcpy(save.magic, SAVE_FILE_MAGIC, SAVE_FILE_MAGIC_SIZE);
+    save.version = SAVE_FILE_VERSION;
+    save.world_fingerprint = world_fingerprint(game);
+    save.room_count = (uint32_t)game->num_rooms;
+    save.room_id = game->player.current_room->id;
+
+    temp_filename = filename_with_suffix(game->save_filename, ".tmp");
+    if (!temp_filename)
+    {
+        ui_log(game, "Could not save the game.");
+        return;
+    }
+
+    pid = fork();
+    if (pid == 0)
+    {
+        // The child. _exit() leaves without flushing stdio buffers or touching
+        // the terminal, both of which still belong to the parent.
+        _exit(write_save_file(temp_filename, game->save_filename, &save) ? 0 : 1);
+    }
+    free(temp_filename);
+    if (pid < 0)
+    {
+        ui_log(game, "Could not save the game.");
+        return;
+    }
+    game->save_pid = pid; // finish_save() collects the child when it is done.
+    ui_log(game, "Saving...");
+}
+
+/**
+ * @brief Puts the player back where the last save left them.
+ * Loading reads 24 bytes and looks up one room, so it is just as fast in a
+ * world of ten million rooms as in a world of ten.
+ */
+void handle_load(GameState *game, char *argument)
+{
+    SaveFile save;
+    Room *room;
+    ssize_t bytes_read;
+    int fd;
+
+    (void)argument;
+    if (!game->save_filename)
+    {
+        ui_log(game, "Saved games are not available here.");
+        return;
+    }
+
+    finish_save(game, 1); // Don't read a save that is still being written.
+    fd = open(game->save_filename, O_RDONLY);
+    if (fd < 0)
+    {
+        ui_log(game, errno == ENOENT ? "There is no saved game yet." : "Could not open the saved game.");
+        return;
+    }
+    bytes_read = read(fd, &save, sizeof(save));
+    close(fd);
+
+    if (bytes_read != (ssize_t)sizeof(save) || memcmp(save.magic, SAVE_FILE_MAGIC, SAVE_FILE_MAGIC_SIZE) != 0 ||
+        save.version != SAVE_FILE_VERSION)
+    {
+        ui_log(game, "The saved game is damaged.");
+        return;
+    }
+    if (save.world_fingerprint != world_fingerprint(game) || save.room_count != (uint32_t)game->num_rooms ||
+        !(room = find_room_by_id(game, save.room_id)))
+    {
+        ui_log(game, "That saved game belongs to a different world.");
+        return;
+    }
+
+    game->player.current_room = room;
+    ui_log(game, "Game loaded.");
+    handle_look(game, NULL);
+}
+
+// =====================================================================================
+// |                                  - EVENT LOOP -                                   |
+// =====================================================================================
+
+// A resize arrives as a signal (SIGWINCH). The handler writes one byte into
+// this pipe, whose other end poll() is watching (the "self-pipe" trick, as
+// in Lesson 33).
+static int resize_pipe[2] = {-1, -1};
+
+static void handle_resize_signal(int signal_number)
+{
+    int saved_errno = errno;
+    char byte = 1;
+
+    (void)signal_number;
+    signal(SIGWINCH, handle_resize_signal); // Some systems reset the handler after each signal.
+    if (write(resize_pipe[1], &byte, 1) < 0)
+    {
+        // The pipe is full, so a resize is already waiting to be handled.
+    }
+    errno = saved_errno;
+}
+
+long long now_nanoseconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Sets up an event loop that reads keys from `input_fd` and, if
+ * `timer_interval` is not 0, fires a timer every `timer_interval` nanoseconds.
+ * @return 1 on success, 0 on error.
+ */
+int event_loop_init(EventLoop *loop, int input_fd, long long timer_interval)
+{
+    if (pipe(resize_pipe) != 0)
+    {
+        return 0;
+    }
+    // Non-blocking, so the signal handler can never get stuck on a full pipe.
+    fcntl(resize_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(resize_pipe[1], F_SETFL, O_NONBLOCK);
+    signal(SIGWINCH, handle_resize_signal);
+
+    loop->input_fd = input_fd;
+    loop->timer_interval = timer_interval;
+    loop->next_timer = now_nanoseconds() + timer_interval;
+    return 1;
+}
+
+/**
+ * @brief Sleeps in poll() until something happens, and says what it was.
+ * A due timer is reported first, so a flood of keys can't starve it.
+ */
+EventType event_loop_wait(EventLoop *loop)
+{
+    for (;;)
+    {
+        struct pollfd fds[2];
+        long long now = now_nanoseconds();
+        int timeout = -1;
+
+        if (loop->timer_interval > 0)
+        {
+            if (now >= loop->next_timer)
+            {
+                loop->next_timer += loop->timer_interval;
+                if (loop->next_timer < now)
+                {
+                    loop->next_timer = now + loop->timer_interval; // Don't try to catch up.
+                }
+                return EVENT_TIMER;
+            }
+            timeout = (int)((loop->next_timer - now + 999999) / 1000000);
+        }
+
+        fds[0].fd = loop->input_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = resize_pipe[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, timeout) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue; // A signal arrived; its byte is in the pipe now.
+            }
+            return EVENT_HANGUP;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            char bytes[16];
+
+            // Several resizes may have piled up; one redraw handles them all.
+            while (read(resize_pipe[0], bytes, sizeof(bytes)) > 0)
+            {
+            }
+            return EVENT_RESIZE;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            return EVENT_INPUT;
+        }
+        if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL))
+        {
+            return EVENT_HANGUP;
+        }
+    }
+}
+
+void event_loop_close(EventLoop *loop)
+{
+    (void)loop;
+    signal(SIGWINCH, SIG_DFL);
+    close(resize_pipe[0]);
+    close(resize_pipe[1]);
+    resize_pipe[0] = resize_pipe[1] = -1;
+}
+
+// =====================================================================================
+// |                                - NCURSES UI CODE -                                |
+// =====================================================================================
+
+void ui_init(GameState *game)
+{
+    initscr();
+    ui_create_windows(game);
+
+    // Without an event loop the game still works; it just waits in wgetnstr().
+    game->has_event_loop = event_loop_init(&game->events, STDIN_FILENO, UI_TIMER_NANOSECONDS);
+    game->ui_started_at = now_nanoseconds();
+    game->drawn_play_seconds = -1;
+}
+
+/**
+ * @brief Rebuilds the windows for the terminal's new size.
+ * ncurses would notice a resize by itself, but our event loop took over the
+ * SIGWINCH signal, so we ask the terminal for its size and tell ncurses.
+ */
+void ui_resize(GameState *game)
+{
+    struct winsize size;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row < MIN_SCREEN_ROWS ||
+        size.ws_col < MIN_SCREEN_COLS)
+    {
+        return; // Too small for our three windows; keep the old layout.
+    }
+    resizeterm(size.ws_row, size.ws_col);
+    delwin(game->main_win);
+    delwin(game->status_win);
+    delwin(game->input_win);
+    ui_create_windows(game); // Also asks ui_draw() for a full redraw.
+}
+
+/**
+ * @brief Sets up the windows on the current ncurses screen.
+ */
+void ui_create_windows(GameState *game)
+{
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+
+    int height, width;
+    getmaxyx(stdscr, height, width);
+
+    // Create a main window for game text, a status window, and an input window.
+    game->main_win = newwin(height - 5, width, 0, 0);
+    game->status_win = newwin(3, width, height - 5, 0);
+    game->input_win = newwin(2, width, height - 2, 0);
+
+    scrollok(game->main_win, TRUE); // Allow the main window to scroll.
+    // Only rows 1 to height - 2 scroll, so the blank top and bottom rows stay put.
+    wsetscrreg(game->main_win, 1, getmaxy(game->main_win) - 2);
+
+    wborder(game->status_win, 0, 0, 0, 0, 0, 0, 0, 0);
+    wborder(game->input_win, ' ', ' ', 0, 0, '>', '<', 0, 0);
+
+    refresh();
+    game->ui_full_redraw = 1;
+}
+
+/**
+ * @brief Prints one log message below the last one, scrolling the main
+ * window up by a line once it reaches the bottom.
+ */
+void ui_append_log_line(GameState *game, const char *message)
+{
+    int bottom = getmaxy(game->main_win) - 2;
+
+    if (game->log_row > bottom)
+    {
+        wscrl(game->main_win, 1);
+        game->log_row = bottom;
+    }
+    mvwprintw(game->main_win, game->log_row, 2, "%s", message);
+    game->log_row = getcury(game->main_win) + 1; // Long messages wrap onto more rows.
+}
+
+/**
+ * @brief Brings the screen up to date. Only the parts that changed since the
+ * last call are drawn: new log lines are added at the bottom of the main
+ * window, and the status line is rewritten only when the room changes.
+ */
+void ui_draw(GameState *game)
+{
+    int visible = getmaxy(game->main_win) - 2;
+    uint64_t unseen = game->log.total - game->drawn_log_total;
+    int main_changed = 0;
+    int status_changed = 0;
+
+    if (game->ui_full_redraw)
+    {
+        // Start again from blank windows and redraw the newest messages.
+        werase(game->main_win);
+        box(game->status_win, 0, 0);
+        box(game->input_win, 0, 0);
+        mvwprintw(game->input_win, 1, 2, "> ");
+        game->log_row = 1;
+        game->drawn_room_id = -1;
+        unseen = (uint64_t)game->log.count;
+        main_changed = 1;
+        game->ui_full_redraw = 0;
+    }
+
+    // Messages may have been added (and even dropped from the log) since the
+    // last draw, but at most one screenful of them can still be seen.
+    if (unseen > 0)
+    {
+        int first = game->log.count - (unseen < (uint64_t)visible ? (int)unseen : visible);
+
+        for (int i = first < 0 ? 0 : first; i < game->log.count; i++)
+        {
+            ui_append_log_line(game, message_log_get(&game->log, i));
+        }
+        game->drawn_log_total = game->log.total;
+        main_changed = 1;
+    }
+
+    if (game->player.current_room->id != game->drawn_room_id)
+    {
+        mvwprintw(game->status_win, 1, 2, STATUS_LOCATION_FORMAT, game->player.current_room->id);
+        wclrtoeol(game->status_win); // A shorter number must not leave old digits behind...
+        box(game->status_win, 0, 0); // ...but clearing also erased the right border.
+        game->drawn_room_id = game->player.current_room->id;
+        game->drawn_play_seconds = -1; // wclrtoeol() erased the clock too.
+        status_changed = 1;
+    }
+
+    if (game->has_event_loop)
+    {
+        int seconds = (int)((now_nanoseconds() - game->ui_started_at) / 1000000000LL);
+
+        // The location ends at column 2 + its length. In a narrow window the
+        // clock would cover it, so then we leave the clock out.
+        int location_end = 2 + snprintf(NULL, 0, STATUS_LOCATION_FORMAT, game->player.current_room->id);
+
+        if (seconds != game->drawn_play_seconds && getmaxx(game->status_win) - 24 > location_end)
+        {
+            mvwprintw(game->status_win, 1, getmaxx(game->status_win) - 24, "Time played: %02d:%02d:%02d",
+                      seconds / 3600, seconds / 60 % 60, seconds % 60);
+            game->drawn_play_seconds = seconds;
+            status_changed = 1;
+        }
+    }
+
+    // wnoutrefresh() only copies a window into ncurses' picture of the screen.
+    // doupdate() then sends everything that changed to the terminal at once.
+    if (main_changed)
+    {
+        wnoutrefresh(game->main_win);
+    }
+    if (status_changed)
+    {
+        wnoutrefresh(game->status_win);
+    }
+    wnoutrefresh(game->input_win); // Last, so the cursor ends up in the input box.
+    doupdate();
+}
+
+void ui_log(GameState *game, const char *message)
+{
+    if (game->headless)
+    {
+        // Append "message\n" to the output buffer, growing it if needed.
+        size_t length = strlen(message);
+
+        if (game->output_length + length + 2 > game->output_capacity)
+        {
+            size_t new_capacity = game->output_capacity ? game->output_capacity : INITIAL_OUTPUT_CAPACITY;
+            char *grown;
+
+            while (new_capacity < game->output_length + length + 2)
+            {
+                new_capacity *= 2;
+            }
+            grown = realloc(game->output, new_capacity);
+            if (!grown)
+            {
+                return;
+            }
+            game->output = grown;
+            game->output_capacity = new_capacity;
+        }
+
+        memcpy(game->output + game->output_length, message, length);
+        game->output_length += length;
+        game->output[game->output_length++] = '\n';
+        game->output[game->output_length] = '\0';
+        return;
+    }
+
+    message_log_add(&game->log, message);
+}
+
+/**
+ * @brief Reads one line of input into `buffer` without freezing the game.
+ * Keys are collected one at a time as they arrive. Meanwhile, the event loop
+ * still wakes us every second to update the clock, and when the terminal is
+ * resized, so the screen stays alive while the player thinks.
+ */
+void ui_get_input(GameState *game, char *buffer)
+{
+    int length = 0;
+
+    if (!game->has_event_loop)
+    {
+        // Move cursor to input window and get string from user.
+        wmove(game->input_win, 1, 4);
+        wgetnstr(game->input_win, buffer, INPUT_BUFFER_SIZE - 1);
+        return;
+    }
+
+    // Blank out the last command, keeping the right border.
+    mvwhline(game->input_win, 1, 4, ' ', getmaxx(game->input_win) - 5);
+    wmove(game->input_win, 1, 4);
+    wrefresh(game->input_win);
+
+    for (;;)
+    {
+        // Keep what is typed inside the box (it may shrink on a resize).
+        int limit = getmaxx(game->input_win) - 6;
+        int ch;
+
+        if (limit > INPUT_BUFFER_SIZE - 1)
+        {
+            limit = INPUT_BUFFER_SIZE - 1;
+        }
+
+        switch (event_loop_wait(&game->events))
+        {
+        case EVENT_HANGUP:
+            strcpy(buffer, "quit"); // Nobody is left to play.
+            return;
+
+        case EVENT_RESIZE:
+            ui_resize(game);
+            length = length < limit ? length : (limit > 0 ? limit : 0);
+            ui_draw(game);
+            mvwaddnstr(game->input_win, 1, 4, buffer, length); // The new box is empty.
+            wrefresh(game->input_win);
+            break;
+
+        case EVENT_TIMER:
+            ui_draw(game); // Only the clock has changed, so only the clock is sent.
+            break;
+
+        case EVENT_INPUT:
+            // nodelay: wgetch() returns ERR once every waiting key has been read.
+            nodelay(game->input_win, TRUE);
+            keypad(game->input_win, TRUE);
+            while ((ch = wgetch(game->input_win)) != ERR)
+            {
+                if (ch == '\n' || ch == '\r' || ch == KEY_ENTER)
+                {
+                    buffer[length] = '\0';
+                    return;
+                }
+                if ((ch == KEY_BACKSPACE || ch == 127 || ch == '\b') && length > 0)
+                {
+                    length--;
+                    mvwaddch(game->input_win, 1, 4 + length, ' ');
+                    wmove(game->input_win, 1, 4 + length);
+                }
+                else if (ch >= ' ' && ch < 127 && length < limit)
+                {
+                    buffer[length++] = (char)ch;
+                    waddch(game->input_win, (chtype)ch);
+                }
+            }
+            wrefresh(game->input_win);
+            break;
+        }
+    }
+}
+
+void ui_cleanup(GameState *game)
+{
+    if (game->has_event_loop)
+    {
+        event_loop_close(&game->events);
+    }
+    delwin(game->main_win);
+    delwin(game->status_win);
+    delwin(game->input_win);
+    endwin(); // Restore terminal to normal state. CRITICAL.
+}
+
+// =====================================================================================
+// |                                 - GAME LIFECYCLE -                                |
+// =====================================================================================
+
+/**
+ * @brief Puts the player in room 0. Returns 0 if the map has no room 0.
+ */
+int place_player_at_start(GameState *game)
+{
+    game->player.current_room = find_room_by_id(game, 0);
+    return game->player.current_room != NULL;
+}
+
+void game_loop(GameState *game)
+{
+    char input_buffer[INPUT_BUFFER_SIZE];
+
+    while (!game->game_should_close)
+    {
+        ui_draw(game);
+        ui_get_input(game, input_buffer);
+        parse_and_execute_command(game, input_buffer);
+    }
+}
+
+/**
+ * @brief Frees all dynamically allocated memory.
+ * This is CRITICAL for preventing memory leaks. A C developer must always
+ * clean up their own mess.
+ */
+void cleanup(GameState *game)
+{
+    // Let a save that is still being written finish first.
+    if (game->save_pid > 0)
+    {
+        waitpid(game->save_pid, NULL, 0);
+    }
+    free(game->save_filename);
+
+    // Free the room array and the string pool. A world image owns neither:
+    // both live inside the mapping, which we hand back in one call.
+    if (game->image)
+    {
+        munmap(game->image, game->image_size);
+    }
+    else
+    {
+        free(game->rooms);
+        free(game->strings.data);
+    }
+    free(game->region_last_use);
+    string_pool_free_index(&game->strings);
+    free(game->pending_links);
+    free(game->output);
+    free(game->search_visited);
+    free(game->search_parent);
+    free(game->search_queue);
+    // The message log lives inside GameState, so it goes away with it.
+    // Finally, free the main GameState struct itself.
+    free(game);
+}
+
+// =====================================================================================
+// |                                  - HEADLESS MODE -                                |
+// =====================================================================================
+
+/**
+ * @brief Loads a world and gets it ready to play without ncurses.
+ */
+GameState *start_headless_game(const char *filename)
+{
+    GameState *game = load_world(filename);
+
+    if (!game)
+    {
+        return NULL;
+    }
+
+    game->headless = 1;
+    if (!place_player_at_start(game))
+    {
+        fprintf(stderr, "Error: Map has no starting room (ID 0).\n");
+        cleanup(game);
+        return NULL;
+    }
+    return game;
+}
+
+/**
+ * @brief Plays the game from a command file (or stdin), one command per line.
+ * After every command the buffered output is written to stdout, so the game
+ * can be driven by scripts and its replies checked by other programs.
+ */
+int run_headless(const char *world_filename, const char *script_filename)
+{
+    char input_buffer[INPUT_BUFFER_SIZE];
+    FILE *script = stdin;
+    GameState *game = start_headless_game(world_filename);
+
+    if (!game)
+    {
+        return 1;
+    }
+    if (!enable_saving(game, world_filename))
+    {
+        cleanup(game);
+        return 1;
+    }
+
+    if (script_filename)
+    {
+        script = fopen(script_filename, "r");
+        if (!script)
+        {
+            perror("Error opening command file");
+            cleanup(game);
+            return 1;
+        }
+    }
+
+    ui_log(game, "Welcome to the Awesome Text Adventure! Type 'help' for commands.");
+    handle_look(game, NULL);
+
+    while (!game->game_should_close && fgets(input_buffer, sizeof(input_buffer), script) != NULL)
+    {
+        if (!strchr(input_buffer, '\n'))
+        {
+            int ch;
+
+            // Like the input box, we keep only the first part of a long line.
+            while ((ch = fgetc(script)) != '\n' && ch != EOF)
+            {
+            }
+        }
+
+        fwrite(game->output, 1, game->output_length, stdout);
+        game->output_length = 0;
+        printf("> %s", input_buffer);
+        if (!strchr(input_buffer, '\n'))
+        {
+            putchar('\n');
+        }
+        parse_and_execute_command(game, input_buffer);
+    }
+
+    finish_save(game, 1);
+    fwrite(game->output, 1, game->output_length, stdout);
+    if (script != stdin)
+    {
+        fclose(script);
+    }
+    cleanup(game);
+
+    printf("Thank you for playing!\n");
+    return 0;
+}
+
+/**
+ * @brief Checks a world for rooms that cannot be reached from room 0.
+ * @return 0 if every room can be reached, 1 otherwise.
+ */
+int run_validate(const char *world_filename)
+{
+    struct timespec start, end;
+    int reached, all_reached, shown = 0;
+    GameState *game = start_headless_game(world_filename);
+
+    if (!game)
+    {
+        return 1;
+    }
+
+    timespec_get(&start, TIME_UTC);
+    reached = search_rooms(game, game->player.current_room, NULL);
+    timespec_get(&end, TIME_UTC);
+    if (reached < 0)
+    {
+        fprintf(stderr, "Error: out of memory while searching the map.\n");
+        cleanup(game);
+        return 1;
+    }
+
+    printf("%d rooms, %d reachable from room 0 (searched in %.1f ms).\n", game->num_rooms, reached,
+           elapsed_seconds(&start, &end) * 1000.0);
+    if (game->region_last_use)
+    {
+        printf("World regions: %d of %zu in memory, %llu evicted.\n", game->resident_regions, game->region_count,
+               (unsigned long long)game->region_evictions);
+    }
+    if (reached < game->num_rooms)
+    {
+        printf("%d unreachable rooms:", game->num_rooms - reached);
+        for (int i = 0; i < game->num_rooms && shown < 10; i++)
+        {
+            if (game->search_visited[i] != game->search_generation)
+            {
+                printf(" %d", game->rooms[i].id);
+                shown++;
+            }
+        }
+        printf("%s\n", game->num_rooms - reached > shown ? " ..." : "");
+    }
+
+    all_reached = reached == game->num_rooms;
+    cleanup(game);
+    return all_reached ? 0 : 1;
+}
+
+// =====================================================================================
+// |                                  - SAVED GAMES -                                  |
+// =====================================================================================
+
+/**
+ * @brief Lets the player save and load, using "<world_file>.sav".
+ * @return 1 on success, 0 if we ran out of memory.
+ */
+int enable_saving(GameState *game, const char *world_filename)
+{
+    game->save_filename = filename_with_suffix(world_filename, ".sav");
+    if (!game->save_filename)
+    {
+        fprintf(stderr, "Error: Out of memory.\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief A quick fingerprint of the loaded world, to tell worlds apart.
+ * It looks at only a few numbers, so it costs the same for any world size.
+ * A map and the world image compiled from it get the same fingerprint.
+ */
+uint32_t world_fingerprint(GameState *game)
+{
+    const Room *first = &game->rooms[0];
+    const Room *last = &game->rooms[game->num_rooms - 1];
+    uint64_t values[4];
+
+    world_touch(game, first, sizeof(Room));
+    world_touch(game, last, sizeof(Room));
+    values[0] = (uint64_t)game->num_rooms;
+    values[1] = (uint64_t)game->strings.length;
+    values[2] = (uint32_t)first->id;
+    values[3] = (uint32_t)last->id;
+    return hash_text((const char *)values, sizeof(values));
+}
+
+/**
+ * @brief Writes a save to `temp_filename`, waits until it is on the disk,
+ * then renames it to `filename`. Runs in the child process (see handle_save()).
+ * @return 1 on success, 0 on error.
+ */
+int write_save_file(const char *temp_filename, const char *filename, const SaveFile *save)
+{
+    int fd = open(temp_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok;
+
+    if (fd < 0)
+    {
+        return 0;
+    }
+    ok = write(fd, save, sizeof(*save)) == (ssize_t)sizeof(*save) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    // rename() replaces the old save in one step: readers see the old file or
+    // the new one, never a mix.
+    if (!ok || rename(temp_filename, filename) != 0)
+    {
+        unlink(temp_filename);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Collects the process writing a save, if it has finished, and tells
+ * the player how it went. With `wait` set, waits for it to finish first.
+ */
+void finish_save(GameState *game, int wait)
+{
+    pid_t done;
+    int status;
+
+    if (game->save_pid <= 0)
+    {
+        return;
+    }
+    while ((done = waitpid(game->save_pid, &status, wait ? 0 : WNOHANG)) < 0 && errno == EINTR)
+    {
+    }
+    if (done == 0)
+    {
+        return; // Still writing.
+    }
+
+    game->save_pid = 0;
+    if (done > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        ui_log(game, "Game saved.");
+    }
+    else
+    {
+        ui_log(game, "Could not save the game.");
+    }
+}
+
+// =====================================================================================
+// |                               - MULTIPLAYER SERVER -                              |
+// =====================================================================================
+
+// Set by the signal handler; the event loop checks it after every poll().
+static volatile sig_atomic_t server_should_stop = 0;
+
+static void handle_stop_signal(int signal_number)
+{
+    (void)signal_number;
+    server_should_stop = 1;
+}
+
+/**
+ * @brief Creates a non-blocking socket listening on `port` on all interfaces.
+ * @return The socket, or -1 on failure.
+ */
+int open_listener(int port)
+{
+    struct sockaddr_in address;
+    int yes = 1;
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listener == -1)
+    {
+        perror("Could not create server socket");
+        return -1;
+    }
+
+    // Let the server restart at once on the same port after it stops.
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        perror("Bind failed");
+        close(listener);
+        return -1;
+    }
+    if (listen(listener, SOMAXCONN) < 0 || fcntl(listener, F_SETFL, O_NONBLOCK) < 0)
+    {
+        perror("Listen failed");
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+/**
+ * @brief Queues text for a player. Nothing is sent until the end of the
+ * current pass of the event loop.
+ * @return 0 if the player has fallen too far behind (or memory ran out).
+ */
+int session_append(Session *session, const char *text, size_t length)
+{
+    if (session->outbox_length + length > session->outbox_capacity)
+    {
+        size_t new_capacity = session->outbox_capacity ? session->outbox_capacity : INITIAL_OUTPUT_CAPACITY;
+        char *grown;
+
+        while (new_capacity < session->outbox_length + length)
+        {
+            new_capacity *= 2;
+        }
+        if (new_capacity > MAX_OUTBOX_SIZE || !(grown = realloc(session->outbox, new_capacity)))
+        {
+            session->closing = 1;
+            return 0;
+        }
+        session->outbox = grown;
+        session->outbox_capacity = new_capacity;
+    }
+
+    memcpy(session->outbox + session->outbox_length, text, length);
+    session->outbox_length += length;
+    return 1;
+}
+
+/**
+ * @brief Queues a line for every player in `room` except `skip_slot`.
+ */
+void server_tell_room(Server *server, const Room *room, int skip_slot, const char *message)
+{
+    size_t length = strlen(message);
+    int slot = server->room_first_player[room - server->game->rooms];
+
+    for (; slot != -1; slot = server->sessions[slot].next_in_room)
+    {
+        if (slot != skip_slot && !server->sessions[slot].closing)
+        {
+            session_append(&server->sessions[slot], message, length);
+            session_append(&server->sessions[slot], "\n", 1);
+        }
+    }
+}
+
+/**
+ * @brief Adds a player to the list of their current room and tells the
+ * others there that they have arrived.
+ */
+void server_enter_room(Server *server, int slot)
+{
+    Session *session = &server->sessions[slot];
+    uint32_t room = (uint32_t)(session->player.current_room - server->game->rooms);
+    char message[64];
+
+    snprintf(message, sizeof(message), "Player %d arrives.", session->number);
+    server_tell_room(server, session->player.current_room, slot, message);
+
+    session->previous_in_room = -1;
+    session->next_in_room = server->room_first_player[room];
+    if (session->next_in_room != -1)
+    {
+        server->sessions[session->next_in_room].previous_in_room = slot;
+    }
+    server->room_first_player[room] = slot;
+}
+
+/**
+ * @brief Removes a player from their room's list and tells the others there.
+ */
+void server_leave_room(Server *server, int slot)
+{
+    Session *session = &server->sessions[slot];
+    uint32_t room = (uint32_t)(session->player.current_room - server->game->rooms);
+    char message[64];
+
+    if (session->previous_in_room != -1)
+    {
+        server->sessions[session->previous_in_room].next_in_room = session->next_in_room;
+    }
+    else
+    {
+        server->room_first_player[room] = session->next_in_room;
+    }
+    if (session->next_in_room != -1)
+    {
+        server->sessions[session->next_in_room].previous_in_room = session->previous_in_room;
+    }
+
+    snprintf(message, sizeof(message), "Player %d leaves.", session->number);
+    server_tell_room(server, session->player.current_room, slot, message);
+}
+
+/**
+ * @brief Accepts every player waiting to connect.
+ */
+void server_accept(Server *server)
+{
+    static const char full_message[] = "Sorry, the server is full.\n";
+    char welcome[128];
+    char look[] = "look";
+
+    for (;;)
+    {
+        int fd = accept(server->listener, NULL, NULL);
+        int slot;
+        Session *session;
+
+        if (fd < 0)
+        {
+            return; // EAGAIN: nobody else is waiting. Other errors: try again later.
+        }
+        if (server->free_count == 0 && server->session_high_water == MAX_SESSIONS)
+        {
+            send(fd, full_message, sizeof(full_message) - 1, 0);
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        slot = server->free_count > 0 ? server->free_slots[--server->free_count] : server->session_high_water++;
+        session = &server->sessions[slot];
+        memset(session, 0, sizeof(*session));
+        session->fd = fd;
+        session->number = ++server->next_number;
+        session->player.current_room = find_room_by_id(server->game, 0);
+        server->players_served++;
+
+        snprintf(welcome, sizeof(welcome),
+                 "Welcome to the Awesome Text Adventure! You are player %d. Type 'help' for commands.\n",
+                 session->number);
+        session_append(session, welcome, strlen(welcome));
+        server_enter_room(server, slot);
+        server_run_command(server, slot, look);
+    }
+}
+
+/**
+ * @brief Runs one command for one player, using the normal command handlers.
+ */
+void server_run_command(Server *server, int slot, char *line)
+{
+    GameState *game = server->game;
+    Session *session = &server->sessions[slot];
+    Room *room_before = session->player.current_room;
+
+    // Swap this player in, run the command, swap them out again. The handlers
+    // write through ui_log(), which in headless mode fills game->output.
+    game->player = session->player;
+    game->output_length = 0;
+    parse_and_execute_command(game, line);
+    session->player = game->player;
+    session_append(session, game->output, game->output_length);
+
+    if (game->player.current_room != room_before)
+    {
+        // Leave the old room first (with the old position), then enter the new one.
+        session->player.current_room = room_before;
+        server_leave_room(server, slot);
+        session->player.current_room = game->player.current_room;
+        server_enter_room(server, slot);
+    }
+
+    // "quit" ends this player's session, not the whole server.
+    if (game->game_should_close)
+    {
+        game->game_should_close = 0;
+        session_append(session, "Goodbye!\n", 9);
+        session->closing = 1;
+    }
+}
+
+/**
+ * @brief Reads what a player has sent and runs every complete line.
+ * @return 0 if the player has disconnected.
+ */
+int server_read(Server *server, int slot)
+{
+    char buffer[SERVER_READ_SIZE];
+    Session *session = &server->sessions[slot];
+    ssize_t received = recv(session->fd, buffer, sizeof(buffer), 0);
+
+    if (received == 0)
+    {
+        return 0;
+    }
+    if (received < 0)
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    // A command may arrive in pieces, or several may arrive at once.
+    for (ssize_t i = 0; i < received && !session->closing; i++)
+    {
+        if (buffer[i] == '\n')
+        {
+            session->input[session->input_length] = '\0';
+            server_run_command(server, slot, session->input);
+            session->input_length = 0;
+        }
+        else if (buffer[i] != '\r' && session->input_length < INPUT_BUFFER_SIZE - 1)
+        {
+            session->input[session->input_length++] = buffer[i]; // Too-long lines are cut short.
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Sends as much of a player's outbox as the socket will take.
+ * @return 0 if the connection has failed.
+ */
+int server_send(Session *session)
+{
+    while (session->outbox_sent < session->outbox_length)
+    {
+        ssize_t sent = send(session->fd, session->outbox + session->outbox_sent,
+                            session->outbox_length - session->outbox_sent, 0);
+
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK; // Full: try again when poll() says so.
+        }
+        session->outbox_sent += (size_t)sent;
+    }
+
+    session->outbox_length = 0;
+    session->outbox_sent = 0;
+    return 1;
+}
+
+void server_close_session(Server *server, int slot)
+{
+    Session *session = &server->sessions[slot];
+
+    server_leave_room(server, slot);
+    close(session->fd);
+    free(session->outbox);
+    session->fd = -1;
+    session->outbox = NULL;
+    server->free_slots[server->free_count++] = slot;
+}
+
+/**
+ * @brief Serves one shared world to many players over TCP until Ctrl+C.
+ * A single thread handles everyone: poll() waits until some sockets are
+ * ready, and then each ready socket is served without ever blocking.
+ */
+int run_server(const char *world_filename, int port)
+{
+    Server server;
+    int stopped_cleanly = 1;
+
+    memset(&server, 0, sizeof(server));
+    server.game = start_headless_game(world_filename); // Loaded once, shared by all players.
+    if (!server.game)
+    {
+        return 1;
+    }
+
+    server.sessions = malloc(MAX_SESSIONS * sizeof(Session));
+    server.free_slots = malloc(MAX_SESSIONS * sizeof(int));
+    server.poll_fds = malloc((MAX_SESSIONS + 1) * sizeof(struct pollfd));
+    server.poll_slots = malloc((MAX_SESSIONS + 1) * sizeof(int));
+    server.room_first_player = malloc((size_t)server.game->num_rooms * sizeof(int));
+    server.listener = -1;
+    if (server.sessions && server.free_slots && server.poll_fds && server.poll_slots && server.room_first_player)
+    {
+        for (int i = 0; i < server.game->num_rooms; i++)
+        {
+            server.room_first_player[i] = -1;
+        }
+        server.listener = open_listener(port);
+    }
+    else
+    {
+        fprintf(stderr, "Error: out of memory while starting the server.\n");
+    }
+
+    if (server.listener >= 0)
+    {
+        // A player who disconnects while we write to them would otherwise
+        // kill the whole server with SIGPIPE; send() returns an error instead.
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, handle_stop_signal);
+        signal(SIGTERM, handle_stop_signal);
+        printf("Serving %s on port %d. Press Ctrl+C to stop.\n", world_filename, port);
+        fflush(stdout);
+    }
+
+    while (server.listener >= 0 && !server_should_stop)
+    {
+        int count = 1;
+        int ready;
+
+        server.poll_fds[0].fd = server.listener;
+        server.poll_fds[0].events = POLLIN;
+        for (int slot = 0; slot < server.session_high_water; slot++)
+        {
+            Session *session = &server.sessions[slot];
+
+            if (session->fd < 0)
+            {
+                continue;
+            }
+            server.poll_fds[count].fd = session->fd;
+            server.poll_fds[count].events = (short)((session->closing ? 0 : POLLIN) |
+                                                    (session->outbox_length > 0 ? POLLOUT : 0));
+            server.poll_slots[count++] = slot;
+        }
+
+        ready = poll(server.poll_fds, (nfds_t)count, -1);
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+            {
+                perror("poll failed");
+                stopped_cleanly = 0;
+                break;
+            }
+            continue;
+        }
+
+        if (server.poll_fds[0].revents & POLLIN)
+        {
+            server_accept(&server);
+        }
+
+        // First run every command that has arrived...
+        for (int i = 1; i < count; i++)
+        {
+            int slot = server.poll_slots[i];
+
+            if (server.sessions[slot].fd >= 0 && (server.poll_fds[i].revents & (POLLIN | POLLHUP | POLLERR)) &&
+                !server_read(&server, slot))
+            {
+                server_close_session(&server, slot);
+            }
+        }
+
+        // ...then send each player everything they got, in one batch.
+        for (int slot = 0; slot < server.session_high_water; slot++)
+        {
+            Session *session = &server.sessions[slot];
+
+            if (session->fd < 0)
+            {
+                continue;
+            }
+            if (!server_send(session) || (session->closing && session->outbox_length == 0))
+            {
+                server_close_session(&server, slot);
+            }
+        }
+    }
+
+    if (server.listener >= 0)
+    {
+        printf("Server stopped after serving %d players.\n", server.players_served);
+        for (int slot = 0; slot < server.session_high_water; slot++)
+        {
+            if (server.sessions[slot].fd >= 0)
+            {
+                close(server.sessions[slot].fd);
+                free(server.sessions[slot].outbox);
+            }
+        }
+        close(server.listener);
+    }
+    else
+    {
+        stopped_cleanly = 0;
+    }
+
+    free(server.sessions);
+    free(server.free_slots);
+    free(server.poll_fds);
+    free(server.poll_slots);
+    free(server.room_first_player);
+    cleanup(server.game);
+    return stopped_cleanly ? 0 : 1;
+}
+
+// =====================================================================================
+// |                                   - BENCHMARKS -                                  |
+// =====================================================================================
+
+/**
+ * @brief A small, fast pseudo-random number generator (xorshift64*).
+ * The same seed always gives the same numbers on every machine, which is
+ * what we want for generated worlds: a benchmark run can be repeated exactly.
+ * `*state` must never be 0. Only the top 32 bits of the result are returned,
+ * because the low bits of xorshift generators are the least random.
+ */
+uint32_t next_random(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief Writes a square grid world with `room_count` rooms to a map file.
+ *
+ * First, every room except room 0 is joined to the room west or north of it
+ * (picked at random). That makes a maze with exactly one way between any two
+ * rooms, so the whole world can always be reached from room 0. Then each
+ * remaining pair of neighbours is joined with a chance of `link_percent`
+ * percent: 0 leaves just the maze, 100 gives a full grid.
+ *
+ * The same `seed` always produces the same file. The links are written before
+ * the rooms on purpose, so the loader has to defer every one of them.
+ * @return 1 on success, 0 on error.
+ */
+int generate_world_file(const char *filename, int room_count, int link_percent, int seed)
+{
+    static const char *const places[] = {
+        "stone corridor", "storeroom", "bridge", "chapel", "cellar", "library", "guard room", "cave",
+    };
+    static const char *const moods[] = {
+        "damp", "dusty", "narrow", "quiet", "cold", "crumbling", "forgotten", "gloomy",
+    };
+    static const char *const details[] = {
+        "Water drips somewhere in the dark.", "Broken crates are stacked against one wall.",
+        "A black, silent chasm yawns below.", "A single candle gutters in a niche.",
+        "Old bones crunch under your feet.", "The air smells of smoke and rust.",
+        "Faded writing covers the ceiling.", "Something skitters away as you enter.",
+    };
+    FILE *file = fopen(filename, "w");
+    uint64_t state = (uint64_t)seed ^ 0x9E3779B97F4A7C15ULL; // Never 0, because seed <= INT_MAX.
+    int width = 1;
+
+    if (!file)
+    {
+        perror("Error creating world file");
+        return 0;
+    }
+
+    while (width * width < room_count)
+    {
+        width++;
+    }
+
+    for (int id = 1; id < room_count; id++)
+    {
+        int has_west = id % width > 0;
+        int has_north = id >= width;
+        // The maze link: west or north, whichever exists (a coin flip if both do).
+        int maze_west = has_west && (!has_north || next_random(&state) % 2 == 0);
+
+        if (has_west && (maze_west || (int)(next_random(&state) % 100) < link_percent))
+        {
+            fprintf(file, "link %d e %d\nlink %d w %d\n", id - 1, id, id, id - 1);
+        }
+        if (has_north && (!maze_west || (int)(next_random(&state) % 100) < link_percent))
+        {
+            fprintf(file, "link %d s %d\nlink %d n %d\n", id - width, id, id, id - width);
+        }
+    }
+
+    // Like a real map, most rooms reuse a few hundred descriptions.
+    for (int id = 0; id < room_count; id++)
+    {
+        uint32_t pick = next_random(&state);
+
+        fprintf(file, "room %d \"A %s %s. %s\"\n", id, moods[pick % 8], places[pick / 8 % 8],
+                details[pick / 64 % 8]);
+    }
+
+    if (fclose(file) != 0)
+    {
+        perror("Error writing world file");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief How much memory the rooms and descriptions of a loaded world use.
+ */
+size_t world_memory_bytes(const GameState *game)
+{
+    if (game->image)
+    {
+        return game->image_size;
+    }
+    return (size_t)game->room_capacity * sizeof(Room) + game->strings.capacity;
+}
+
+double elapsed_seconds(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Times load_world() on one file several times and prints the result.
+ */
+int time_world_loads(const char *filename, int room_count, const char *label)
+{
+    double best = 0.0;
+    double total = 0.0;
+
+    for (int run = 0; run < LOAD_BENCHMARK_REPETITIONS; run++)
+    {
+        struct timespec start, end;
+        GameState *game;
+        double seconds;
+
+        timespec_get(&start, TIME_UTC);
+        game = load_world(filename);
+        timespec_get(&end, TIME_UTC);
+
+        if (!game)
+        {
+            return 0;
+        }
+        if (run == 0)
+        {
+            size_t bytes = world_memory_bytes(game);
+
+            printf("Loaded %d rooms from %s (%zu bytes of world data, %.1f bytes/room).\n", game->num_rooms,
+                   filename, bytes, (double)bytes / game->num_rooms);
+        }
+        cleanup(game);
+
+        seconds = elapsed_seconds(&start, &end);
+        total += seconds;
+        if (run == 0 || seconds < best)
+        {
+            best = seconds;
+        }
+    }
+
+    printf("%s load time over %d runs: best %.3f ms, average %.3f ms (%.0f rooms/sec).\n", label,
+           LOAD_BENCHMARK_REPETITIONS, best * 1000.0, total / LOAD_BENCHMARK_REPETITIONS * 1000.0,
+           room_count / best);
+    return 1;
+}
+
+/**
+ * @brief Returns a new string: `filename` followed by `suffix`, or NULL.
+ * The caller must free() it.
+ */
+char *filename_with_suffix(const char *filename, const char *suffix)
+{
+    size_t name_length = strlen(filename);
+    size_t suffix_size = strlen(suffix) + 1;
+    char *result = malloc(name_length + suffix_size);
+
+    if (result)
+    {
+        memcpy(result, filename, name_length);
+        memcpy(result + name_length, suffix, suffix_size);
+    }
+    return result;
+}
+
+/**
+ * @brief Generates a world, then times loading it as text and as an image.
+ * No ncurses here: this runs in a plain terminal and prints a small report.
+ */
+int run_load_benchmark(int room_count, const char *filename)
+{
+    char *image_filename = filename_with_suffix(filename, ".img");
+    int ok;
+
+    if (!image_filename)
+    {
+        return 1;
+    }
+
+    ok = generate_world_file(filename, room_count, 100, 1) && time_world_loads(filename, room_count, "Text map") &&
+         compile_world(filename, image_filename) && time_world_loads(image_filename, room_count, "World image");
+
+    free(image_filename);
+    return ok ? 0 : 1;
+}
+
+// The commands the benchmarks play, over and over.
+static const char *const benchmark_script[] = {
+    "look", "north", "east", "go south", "w", "l", "help", "xyzzy",
+};
+
 /**
- * @brief A helper function to find a room pointer from its integer ID.
+ * @brief Replays `command_count` commands from the benchmark script into a
+ * headless game and returns how many seconds they took.
  */
-Room *find_room_by_id(GameState *game, int id)
+double time_commands(GameState *game, int command_count, size_t *output_bytes)
 {
-    for (int i = 0; i < game->num_rooms; i++)
+    const char *const *script = benchmark_script;
+    const int script_length = (int)(sizeof(benchmark_script) / sizeof(benchmark_script[0]));
+    char input_buffer[INPUT_BUFFER_SIZE];
+    struct timespec start, end;
+
+    *output_bytes = 0;
+    timespec_get(&start, TIME_UTC);
+    for (int i = 0; i < command_count && !game->game_should_close; i++)
     {
-        if (game->all_rooms[i]->id == id)
-        {
-            return game->all_rooms[i];
-        }
+        // The parser lowercases and splits its input in place, so it gets a copy.
+        strcpy(input_buffer, script[i % script_length]);
+        parse_and_execute_command(game, input_buffer);
+
+        *output_bytes += game->output_length;
+        game->output_length = 0; // Throw the text away; the buffer is reused.
     }
-    return NULL; // Not found
+    timespec_get(&end, TIME_UTC);
+    return elapsed_seconds(&start, &end);
 }
 
-const char *direction_to_string(Direction d)
+/**
+ * @brief Replays a fixed list of commands through the command parser and
+ * reports how many commands per second the engine can handle.
+ */
+int run_command_benchmark(const char *world_filename, int command_count)
 {
-    switch (d)
+    size_t output_bytes;
+    double seconds;
+    GameState *game = start_headless_game(world_filename);
+
+    if (!game)
     {
-    case NORTH:
-        return "north";
-    case SOUTH:
-        return "south";
-    case EAST:
-        return "east";
-    case WEST:
-        return "west";
+        return 1;
     }
-    return "unknown";
-}
-
-// =====================================================================================
-// |                                - COMMAND HANDLING -                               |
-// =====================================================================================
 
-// This array of structs is our command table. It pairs a command string with
-// the function pointer that handles it. This is a very clean, scalable design.
-Command command_table[] = {
-    {"quit", handle_quit},
-    {"exit", handle_quit},
-    {"look", handle_look},
-    {"l", handle_look},
-    {"go", handle_go},
-    {"north", handle_go},
-    {"south", handle_go},
-    {"east", handle_go},
-    {"west", handle_go},
-    {"n", handle_go},
-    {"s", handle_go},
-    {"e", handle_go},
-    {"w", handle_go},
-    {"help", handle_help},
-    {NULL, NULL} // Sentinel to mark the end of the array.
-};
+    seconds = time_commands(game, command_count, &output_bytes);
+    printf("Ran %d commands in %.3f ms (%.0f commands/sec, %zu bytes of output).\n", command_count,
+           seconds * 1000.0, command_count / seconds, output_bytes);
+    cleanup(game);
+    return 0;
+}
 
 /**
- * @brief Processes the user's raw input string, finds the correct command handler,
- *        and calls it.
+ * @brief Loads a world once, and reports the time and the world's size.
+ * @return 1 on success, 0 on error.
  */
-void parse_and_execute_command(GameState *game, char *input)
+int time_one_load(const char *filename, double *seconds, size_t *bytes)
 {
-    char *verb, *argument;
+    struct timespec start, end;
+    GameState *game;
 
-    // Convert input to lowercase for case-insensitive matching.
-    for (int i = 0; input[i]; i++)
+    timespec_get(&start, TIME_UTC);
+    game = load_world(filename);
+    timespec_get(&end, TIME_UTC);
+
+    if (!game)
     {
-        input[i] = (char)tolower((unsigned char)input[i]);
+        return 0;
     }
+    *seconds = elapsed_seconds(&start, &end);
+    *bytes = world_memory_bytes(game);
+    cleanup(game);
+    return 1;
+}
 
-    verb = strtok(input, " \n"); // Tokenize the string by space or newline.
-    if (!verb)
-        return; // Empty input
-
-    argument = strtok(NULL, " \n");
+/**
+ * @brief Generates worlds of 100, 1000, 10000, ... rooms, up to `max_rooms`,
+ * and prints one line per size: how long the text map and the world image
+ * take to load, how many bytes each room costs in memory, and how many
+ * commands per second the engine runs on the image.
+ *
+ * The interesting part is how the numbers change as the world grows. Load
+ * time should grow with the room count; bytes per room and commands per
+ * second should stay about the same. If they don't, something in the engine
+ * does not scale.
+ */
+int run_scale_benchmark(int max_rooms, const char *filename)
+{
+    char *image_filename = filename_with_suffix(filename, ".img");
+    int ok = image_filename != NULL;
 
-    // Handle single-word movement commands like "north"
-    if (strcmp(verb, "n") == 0 || strcmp(verb, "north") == 0 ||
-        strcmp(verb, "s") == 0 || strcmp(verb, "south") == 0 ||
-        strcmp(verb, "e") == 0 || strcmp(verb, "east") == 0 ||
-        strcmp(verb, "w") == 0 || strcmp(verb, "west") == 0)
-    {
-        argument = verb; // The argument to "go" is the verb itself.
-        verb = "go";
-    }
+    printf("Link density %d%%, seed 1, %d commands per size.\n", SCALE_BENCHMARK_LINK_PERCENT,
+           SCALE_BENCHMARK_COMMANDS);
 
-    for (int i = 0; command_table[i].command != NULL; i++)
+    for (int rooms = 100; ok && rooms <= max_rooms; rooms = rooms > max_rooms / 10 ? max_rooms + 1 : rooms * 10)
     {
-        if (strcmp(verb, command_table[i].command) == 0)
+        double text_seconds, image_seconds, command_seconds;
+        size_t text_bytes, image_bytes, output_bytes;
+        GameState *game;
+
+        ok = generate_world_file(filename, rooms, SCALE_BENCHMARK_LINK_PERCENT, 1) &&
+             time_one_load(filename, &text_seconds, &text_bytes) && compile_world(filename, image_filename) &&
+             time_one_load(image_filename, &image_seconds, &image_bytes);
+        if (!ok || !(game = start_headless_game(image_filename)))
         {
-            // We found a match! Call the associated function pointer.
-            command_table[i].handler(game, argument);
-            return;
+            ok = 0;
+            break;
         }
-    }
+        command_seconds = time_commands(game, SCALE_BENCHMARK_COMMANDS, &output_bytes);
+        cleanup(game);
 
-    ui_log(game, "I don't understand that command.");
-}
+        printf("%d rooms: text load %.3f ms, image load %.3f ms, %.1f / %.1f bytes/room (text / image), "
+               "%.0f commands/sec.\n",
+               rooms, text_seconds * 1000.0, image_seconds * 1000.0, (double)text_bytes / rooms,
+               (double)image_bytes / rooms, SCALE_BENCHMARK_COMMANDS / command_seconds);
+        fflush(stdout); // Big sizes take a while; show each line as soon as it is ready.
+    }
 
-void handle_quit(GameState *game, char *argument)
-{
-    (void)argument;
-    game->game_should_close = 1;
+    free(image_filename);
+    return ok ? 0 : 1;
 }
 
-void handle_look(GameState *game, char *argument)
+/**
+ * @brief Plays the benchmark script through the real ncurses UI, but with the
+ * "terminal" being a temporary file. Reports how many bytes ncurses wrote to
+ * it and how long the turns took. With `full_redraw` set, every turn redraws
+ * the whole screen.
+ * @return 1 on success, 0 on error.
+ */
+int render_benchmark_pass(const char *world_filename, int turns, int full_redraw, long *bytes, double *seconds)
 {
-    (void)argument;
-    Room *room = game->player.current_room;
-    ui_log(game, room->description);
-
-    char exits_str[100] = "Exits: ";
-    int found_exit = 0;
-    for (int i = 0; i < MAX_DIRECTIONS; i++)
+    const int script_length = (int)(sizeof(benchmark_script) / sizeof(benchmark_script[0]));
+    char input_buffer[INPUT_BUFFER_SIZE];
+    long start_size, end_size;
+    struct timespec start, end;
+    FILE *terminal_output = tmpfile();
+    FILE *terminal_input = fopen("/dev/null", "r");
+    GameState *game = NULL;
+    SCREEN *screen = NULL;
+
+    if (terminal_output && terminal_input)
     {
-        if (room->exits[i])
-        {
-            strcat(exits_str, direction_to_string(i));
-            strcat(exits_str, " ");
-            found_exit = 1;
-        }
+        game = start_headless_game(world_filename);
     }
-    if (found_exit)
+    if (game)
     {
-        ui_log(game, exits_str);
+        // A fixed terminal type, so the numbers do not depend on $TERM.
+        screen = newterm("xterm", terminal_output, terminal_input);
     }
-    else
+    if (!screen)
     {
-        ui_log(game, "There are no obvious exits.");
+        fprintf(stderr, "Error: could not set up a terminal for the render benchmark.\n");
+        if (game)
+        {
+            cleanup(game);
+        }
+        if (terminal_output)
+        {
+            fclose(terminal_output);
+        }
+        if (terminal_input)
+        {
+            fclose(terminal_input);
+        }
+        return 0;
     }
-}
 
-void handle_go(GameState *game, char *argument)
-{
-    if (!argument)
-    {
-        ui_log(game, "Go where?");
-        return;
-    }
+    game->headless = 0; // This time ui_log() really goes to the screen.
+    ui_create_windows(game);
+    ui_log(game, "Welcome to the Awesome Text Adventure! Type 'help' for commands.");
+    handle_look(game, NULL);
+    ui_draw(game);
 
-    int dir = -1;
-    if (strcmp(argument, "n") == 0 || strcmp(argument, "north") == 0)
-        dir = NORTH;
-    else if (strcmp(argument, "s") == 0 || strcmp(argument, "south") == 0)
-        dir = SOUTH;
-    else if (strcmp(argument, "e") == 0 || strcmp(argument, "east") == 0)
-        dir = EAST;
-    else if (strcmp(argument, "w") == 0 || strcmp(argument, "west") == 0)
-        dir = WEST;
+    // ncurses may write to the file descriptor behind our FILE's back, so we
+    // seek to the real end of the file before asking where that is.
+    fseek(terminal_output, 0, SEEK_END);
+    start_size = ftell(terminal_output);
 
-    if (dir == -1)
+    timespec_get(&start, TIME_UTC);
+    for (int turn = 0; turn < turns && !game->game_should_close; turn++)
     {
-        ui_log(game, "That's not a valid direction.");
-        return;
+        strcpy(input_buffer, benchmark_script[turn % script_length]);
+        parse_and_execute_command(game, input_buffer);
+        game->ui_full_redraw = full_redraw;
+        ui_draw(game);
     }
+    timespec_get(&end, TIME_UTC);
 
-    Room *next_room = game->player.current_room->exits[dir];
-    if (next_room)
-    {
-        game->player.current_room = next_room;
-        handle_look(game, NULL); // Automatically look after moving.
-    }
-    else
-    {
-        ui_log(game, "You can't go that way.");
-    }
-}
+    fseek(terminal_output, 0, SEEK_END);
+    end_size = ftell(terminal_output);
 
-void handle_help(GameState *game, char *argument)
-{
-    (void)argument;
-    ui_log(game, "--- Available Commands ---");
-    ui_log(game, "look (l): Describe the current room and exits.");
-    ui_log(game, "go <dir>: Move in a direction (north, south, east, west, or n,s,e,w).");
-    ui_log(game, "help: Show this help message.");
-    ui_log(game, "quit/exit: Leave the game.");
+    ui_cleanup(game);
+    delscreen(screen);
+    fclose(terminal_output);
+    fclose(terminal_input);
+    cleanup(game);
+    *bytes = end_size - start_size;
+    *seconds = elapsed_seconds(&start, &end);
+    return 1;
 }
 
-// =====================================================================================
-// |                                - NCURSES UI CODE -                                |
-// =====================================================================================
-
-void ui_init(GameState *game)
+/**
+ * @brief Compares how much a full redraw and an incremental redraw send to
+ * the terminal for the same turns.
+ */
+int run_render_benchmark(const char *world_filename, int turns)
 {
-    initscr();
-    cbreak();
-    noecho();
-    keypad(stdscr, TRUE);
-
-    int height, width;
-    getmaxyx(stdscr, height, width);
+    const char *labels[] = {"Incremental redraw", "Full redraw"};
 
-    // Create a main window for game text, a status window, and an input window.
-    game->main_win = newwin(height - 5, width, 0, 0);
-    game->status_win = newwin(3, width, height - 5, 0);
-    game->input_win = newwin(2, width, height - 2, 0);
-
-    scrollok(game->main_win, TRUE); // Allow the main window to scroll.
-
-    wborder(game->status_win, 0, 0, 0, 0, 0, 0, 0, 0);
-    wborder(game->input_win, ' ', ' ', 0, 0, '>', '<', 0, 0);
+    for (int full_redraw = 0; full_redraw <= 1; full_redraw++)
+    {
+        long bytes;
+        double seconds;
 
-    refresh();
+        if (!render_benchmark_pass(world_filename, turns, full_redraw, &bytes, &seconds))
+        {
+            return 1;
+        }
+        printf("%s: %ld bytes over %d turns (%.1f bytes/turn, %.2f us/turn).\n", labels[full_redraw], bytes,
+               turns, (double)bytes / turns, seconds * 1e6 / turns);
+    }
+    return 0;
 }
 
-void ui_draw(GameState *game)
+/**
+ * @brief Builds the text every benchmark player sends: `commands` commands
+ * from the benchmark script, one per line, and then "quit".
+ */
+char *build_server_script(int commands, size_t *size)
 {
-    // Draw status window
-    box(game->status_win, 0, 0);
-    mvwprintw(game->status_win, 1, 2, "Location: Room %d", game->player.current_room->id);
+    const int script_length = (int)(sizeof(benchmark_script) / sizeof(benchmark_script[0]));
+    size_t used = 0;
+    char *script;
 
-    // Draw input window
-    box(game->input_win, 0, 0);
-    mvwprintw(game->input_win, 1, 2, "> ");
+    *size = 0;
+    for (int i = 0; i < commands; i++)
+    {
+        *size += strlen(benchmark_script[i % script_length]) + 1;
+    }
+    *size += sizeof("quit");
 
-    // Draw main window log messages
-    werase(game->main_win);
-    for (int i = 0; i < game->log_count; i++)
+    script = malloc(*size);
+    if (!script)
     {
-        mvwprintw(game->main_win, i + 1, 2, "%s", game->log_messages[i]);
+        return NULL;
     }
+    for (int i = 0; i <= commands; i++)
+    {
+        const char *command = i < commands ? benchmark_script[i % script_length] : "quit";
+        size_t length = strlen(command);
 
-    // Refresh all windows to show changes
-    wrefresh(game->main_win);
-    wrefresh(game->status_win);
-    wrefresh(game->input_win);
+        memcpy(script + used, command, length);
+        script[used + length] = '\n';
+        used += length + 1;
+    }
+    return script;
 }
 
-void ui_log(GameState *game, const char *message)
+/**
+ * @brief Connects many players to a running server on this machine. Each
+ * one sends its commands (then "quit") and reads until the server hangs up.
+ */
+int run_server_benchmark(int port, int players, int commands_per_player)
 {
-    char *message_copy = duplicate_string(message);
-
-    if (!message_copy)
+    struct sockaddr_in address;
+    struct timespec start, end;
+    struct pollfd *fds = malloc((size_t)players * sizeof(struct pollfd));
+    size_t *sent = calloc((size_t)players, sizeof(size_t));
+    size_t script_size, received_bytes = 0, received_lines = 0;
+    char *script = build_server_script(commands_per_player, &script_size);
+    int connected = 0, remaining = players, failed = 0;
+    char buffer[SERVER_READ_SIZE];
+
+    if (!fds || !sent || !script)
     {
-        return;
+        fprintf(stderr, "Error: out of memory.\n");
+        failed = 1;
     }
 
-    // If the log is full, shift all messages up.
-    if (game->log_count >= MAX_LOG_MESSAGES)
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+    timespec_get(&start, TIME_UTC);
+    for (; !failed && connected < players; connected++)
     {
-        free(game->log_messages[0]);
-        for (int i = 0; i < MAX_LOG_MESSAGES - 1; i++)
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
         {
-            game->log_messages[i] = game->log_messages[i + 1];
+            perror("Could not connect to the server");
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            failed = 1;
+            break;
         }
-        game->log_count--;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fds[connected].fd = fd;
     }
 
-    game->log_messages[game->log_count++] = message_copy;
-}
-
-void ui_get_input(GameState *game, char *buffer)
-{
-    // Move cursor to input window and get string from user.
-    wmove(game->input_win, 1, 4);
-    wgetnstr(game->input_win, buffer, INPUT_BUFFER_SIZE - 1);
-}
-
-void ui_cleanup(GameState *game)
-{
-    delwin(game->main_win);
-    delwin(game->status_win);
-    delwin(game->input_win);
-    endwin(); // Restore terminal to normal state. CRITICAL.
-}
-
-// =====================================================================================
-// |                                 - GAME LIFECYCLE -                                |
-// =====================================================================================
+    while (!failed && remaining > 0)
+    {
+        for (int i = 0; i < players; i++)
+        {
+            fds[i].events = (short)(fds[i].fd >= 0 ? POLLIN | (sent[i] < script_size ? POLLOUT : 0) : 0);
+        }
+        if (poll(fds, (nfds_t)players, -1) < 0)
+        {
+            perror("poll failed");
+            failed = 1;
+            break;
+        }
 
-void game_loop(GameState *game)
-{
-    char input_buffer[INPUT_BUFFER_SIZE];
+        for (int i = 0; i < players; i++)
+        {
+            if (fds[i].fd < 0)
+            {
+                continue;
+            }
+            if ((fds[i].revents & POLLOUT) && sent[i] < script_size)
+            {
+                ssize_t count = send(fds[i].fd, script + sent[i], script_size - sent[i], 0);
 
-    while (!game->game_should_close)
-    {
-        ui_draw(game);
-        ui_get_input(game, input_buffer);
-        parse_and_execute_command(game, input_buffer);
+                if (count > 0)
+                {
+                    sent[i] += (size_t)count;
+                }
+            }
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                ssize_t count = recv(fds[i].fd, buffer, sizeof(buffer), 0);
+
+                if (count > 0)
+                {
+                    received_bytes += (size_t)count;
+                    for (ssize_t j = 0; j < count; j++)
+                    {
+                        received_lines += buffer[j] == '\n';
+                    }
+                }
+                else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                {
+                    close(fds[i].fd); // The server said goodbye and hung up.
+                    fds[i].fd = -1;
+                    remaining--;
+                }
+            }
+        }
     }
-}
+    timespec_get(&end, TIME_UTC);
 
-/**
- * @brief Frees all dynamically allocated memory.
- * This is CRITICAL for preventing memory leaks. A C developer must always
- * clean up their own mess.
- */
-void cleanup(GameState *game)
-{
-    // Free all the room structs
-    for (int i = 0; i < game->num_rooms; i++)
+    if (!failed)
     {
-        free(game->all_rooms[i]);
+        double seconds = elapsed_seconds(&start, &end);
+        long long commands = (long long)players * (commands_per_player + 1);
+
+        printf("Served %d players: %lld commands in %.1f ms (%.0f commands/sec).\n", players, commands,
+               seconds * 1000.0, commands / seconds);
+        printf("Received %zu lines, %zu bytes in total.\n", received_lines, received_bytes);
     }
-    // Free all the log message strings
-    for (int i = 0; i < game->log_count; i++)
+
+    for (int i = 0; i < connected; i++)
     {
-        free(game->log_messages[i]);
+        if (fds[i].fd >= 0)
+        {
+            close(fds[i].fd);
+        }
     }
-    // Finally, free the main GameState struct itself.
-    free(game);
+    free(fds);
+    free(sent);
+    free(script);
+    return failed;
 }
 
 /*
@@ -831,5 +3967,61 @@ void cleanup(GameState *game)
  *
  *      `./35_capstone_awesome_text_adventure world.map`
  *
- *    Your terminal will transform, and the game will begin.
+ *    Your terminal will transform, and the game will begin. Type `save` to
+ *    remember your place (in `world.map.sav`) and `load` to go back to it.
+ *
+ * 4. COMPILE THE MAP (OPTIONAL):
+ *    For big worlds, turn the text map into a binary world image once. The
+ *    game accepts either kind of file and recognizes images automatically:
+ *
+ *      `./35_capstone_awesome_text_adventure --compile world.map world.img`
+ *      `./35_capstone_awesome_text_adventure world.img`
+ *
+ * 5. PLAY HEADLESS (OPTIONAL):
+ *    Without ncurses, the game reads one command per line from a file (or from
+ *    standard input) and prints its replies. This is handy for testing maps:
+ *
+ *      `printf 'look\nnorth\nquit\n' | ./35_capstone_awesome_text_adventure --headless world.map`
+ *
+ *    In any mode, `path <room>` shows the shortest way to a room. To check a
+ *    map for rooms that cannot be reached from room 0, use:
+ *
+ *      `./35_capstone_awesome_text_adventure --validate world.map`
+ *
+ * 6. HOST A MULTIPLAYER GAME (OPTIONAL):
+ *    The server loads the world once and lets players connect with a tool like
+ *    `nc` (netcat). Each player moves on their own and sees others come and go:
+ *
+ *      `./35_capstone_awesome_text_adventure --server world.map 4000`
+ *      `nc localhost 4000` (in another terminal, once per player)
+ *
+ *    While the server runs, this connects 1000 test players that each send
+ *    100 commands, and reports how fast they were served:
+ *
+ *      `./35_capstone_awesome_text_adventure --benchmark-server 4000 1000 100`
+ *
+ * 7. MEASURE THE ENGINE (OPTIONAL):
+ *    The program can also generate a large grid world and time how long it
+ *    takes to load, both as text and as a compiled image, or replay millions
+ *    of commands through the command parser. These modes do not start the
+ *    ncurses interface:
+ *
+ *      `./35_capstone_awesome_text_adventure --benchmark-load 100000 /tmp/big_world.map`
+ *      `./35_capstone_awesome_text_adventure --benchmark-commands world.map 5000000`
+ *
+ *    To see how the engine scales, this generates worlds of 100, 1000, ...
+ *    up to 10 million rooms and measures each one. The biggest worlds need a
+ *    few hundred megabytes of disk space and take a while:
+ *
+ *      `./35_capstone_awesome_text_adventure --benchmark-scale 10000000 /tmp/scale.map`
+ *
+ *    You can also generate a world to explore yourself. This makes 10000 rooms
+ *    where 30% of the extra passages are open, from random seed 42:
+ *
+ *      `./35_capstone_awesome_text_adventure --generate 10000 30 42 maze.map`
+ *
+ *    To see how many bytes the interface sends to the terminal each turn, with
+ *    and without full-screen redraws, the game can draw into a scratch file:
+ *
+ *      `./35_capstone_awesome_text_adventure --benchmark-render world.map 1000`
  */
@@ -0,0 +1,107 @@
+/**
+ * @file core.h
+ * @brief libcore: the small routines that many of the book's programs need.
+ *
+ * Several lessons write their own line reader, number parser, file loader
+ * and hash table, each a little different, because every lesson has to
+ * compile on its own. libcore holds one tuned copy of each, built into a
+ * static library (`libcore.a`) by the Makefile next to this file, the same
+ * way Lesson 31 builds its helper module. Multi-file programs link it with
+ * `-Llibcore -lcore`, so an improvement here reaches all of them at once.
+ *
+ * All routines use the "C" locale's idea of whitespace and digits, whatever
+ * the program's locale is.
+ */
+
+#ifndef CORE_H
+#define CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// --- Text (core_text.c) ---
+
+// Returns the first character of `text` that isn't whitespace, as isspace()
+// sees it in the "C" locale (space, \t, \n, \v, \f and \r).
+char *core_skip_whitespace(const char *text);
+
+// Returns 1 if `text` holds nothing but whitespace.
+int core_is_blank(const char *text);
+
+/*
+ * Parses an int at `*cursor`, after any leading whitespace, and moves the
+ * cursor past it. Returns 0 (and leaves the cursor alone) if there is no
+ * number or it doesn't fit in an int.
+ */
+int core_parse_int(char **cursor, int *value);
+
+// Parses a string that must hold exactly one int, with optional whitespace around it.
+int core_parse_int_value(const char *text, int *value);
+
+/*
+ * Cuts the next line out of an in-memory, NUL-terminated text. The newline is
+ * overwritten with '\0', `*line` points at the line and `*cursor` moves to the
+ * next one. Returns 1 for a line, 0 at the end of the text, and -1 for a line
+ * of `max_length` characters or more (it is still cut out, so the caller can
+ * skip it and go on).
+ */
+int core_next_line(char **cursor, char **line, size_t max_length);
+
+/*
+ * Reads one line from `stream` into `buffer`, without the newline. Returns 1
+ * for a line, 0 at the end of the input, and -1 if the line didn't fit (the
+ * rest of it is read and thrown away, and `buffer` is left empty).
+ */
+int core_read_line(FILE *stream, char *buffer, size_t size);
+
+// --- Files (core_file.c) ---
+
+/*
+ * Reads a whole file into one NUL-terminated heap buffer and stores its size
+ * in `*length`. Returns NULL if the file can't be read (errno says why) or
+ * memory runs out. The caller frees the buffer.
+ */
+char *core_read_file(const char *filename, size_t *length);
+
+// --- Hashing (core_hash.c) ---
+
+// FNV-1a: a tiny, fast hash that spreads short strings well.
+uint32_t core_hash(const void *data, size_t length);
+
+/*
+ * A hash table from strings to pointers. The table keeps its own copy of each
+ * key; values are only stored, never freed. It uses open addressing, so a
+ * lookup is usually one probe into a single array instead of a walk down a
+ * linked list (compare Lesson 28).
+ */
+typedef struct CoreTable CoreTable;
+
+CoreTable *core_table_create(size_t expected_count);
+void core_table_destroy(CoreTable *table);
+
+// Adds or replaces `key`. Returns 0 only if memory ran out.
+int core_table_put(CoreTable *table, const char *key, void *value);
+
+// Returns the value stored for `key`, or NULL if there is none.
+void *core_table_get(const CoreTable *table, const char *key);
+
+// Removes `key`. Returns 1 if it was there.
+int core_table_remove(CoreTable *table, const char *key);
+
+size_t core_table_count(const CoreTable *table);
+
+/*
+ * With CORE_INLINE defined, the hottest helpers are compiled from the
+ * `static inline` bodies in core_inline.h instead of being called in
+ * libcore.a (see that header for why). The library's own sources define
+ * CORE_BUILDING_LIBRARY, because they are what defines the real functions.
+ */
+#if defined(CORE_INLINE) && !defined(CORE_BUILDING_LIBRARY)
+#include "core_inline.h"
+#define core_skip_whitespace(text) core_inline_skip_whitespace(text)
+#define core_parse_int(cursor, value) core_inline_parse_int(cursor, value)
+#define core_hash(data, length) core_inline_hash(data, length)
+#endif
+
+#endif // CORE_H
@@ -0,0 +1,239 @@
+/**
+ * @file core_bench.c
+ * @brief Measures what a function call costs libcore's hottest helpers.
+ *
+ * Each workload runs twice over the same data: once calling the out-of-line
+ * function in libcore.a, and once using its `static inline` twin from
+ * core_inline.h. The work is identical, so the difference is the price of
+ * the call itself, plus whatever the optimizer could do once it saw the body.
+ *
+ *   ./core_bench [items]   (default: 1000000 numbers, words and keys)
+ *
+ * It prints nanoseconds per item for both versions, and exits with status 1
+ * if they ever disagree. Build it with `make -C libcore bench`.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core.h"
+#include "core_inline.h"
+
+#define DEFAULT_ITEMS 1000000
+#define ROUNDS 5   // Each timing is the best of this many, to skip over noise.
+#define KEY_SIZE 32 // "room_", up to 19 digits of a long, and the terminating NUL.
+
+typedef struct
+{
+    char *numbers; // "  123 -45 6789 ..."
+    char *words;   // "ab  abcd\tabc ..."
+    char (*keys)[KEY_SIZE];
+    long items;
+} BenchData;
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// --- Workloads ---
+// Each returns a checksum, both so the two versions can be compared and so
+// the compiler can't throw the work away.
+//
+// The "call" versions write the name in parentheses, as in
+// `(core_parse_int)(...)`. That stops a function-like macro from expanding,
+// so they call libcore.a even if this file is built with -DCORE_INLINE.
+
+static long long parse_with_calls(const BenchData *data)
+{
+    char *cursor = data->numbers;
+    long long sum = 0;
+    int value;
+
+    while ((core_parse_int)(&cursor, &value))
+    {
+        sum += value;
+    }
+    return sum;
+}
+
+static long long parse_inline(const BenchData *data)
+{
+    char *cursor = data->numbers;
+    long long sum = 0;
+    int value;
+
+    while (core_inline_parse_int(&cursor, &value))
+    {
+        sum += value;
+    }
+    return sum;
+}
+
+// Counts words by skipping the whitespace in front of each one.
+static long long skip_with_calls(const BenchData *data)
+{
+    const char *text = data->words;
+    long long words = 0;
+
+    while (*(text = (core_skip_whitespace)(text)))
+    {
+        while (*text > ' ')
+        {
+            text++;
+        }
+        words++;
+    }
+    return words;
+}
+
+static long long skip_inline(const BenchData *data)
+{
+    const char *text = data->words;
+    long long words = 0;
+
+    while (*(text = core_inline_skip_whitespace(text)))
+    {
+        while (*text > ' ')
+        {
+            text++;
+        }
+        words++;
+    }
+    return words;
+}
+
+static long long hash_with_calls(const BenchData *data)
+{
+    uint32_t mixed = 0;
+
+    for (long i = 0; i < data->items; i++)
+    {
+        mixed ^= (core_hash)(data->keys[i], strlen(data->keys[i]));
+    }
+    return mixed;
+}
+
+static long long hash_inline(const BenchData *data)
+{
+    uint32_t mixed = 0;
+
+    for (long i = 0; i < data->items; i++)
+    {
+        mixed ^= core_inline_hash(data->keys[i], strlen(data->keys[i]));
+    }
+    return mixed;
+}
+
+// --- Setup ---
+
+static int make_data(BenchData *data, long items)
+{
+    size_t numbers_length = 0;
+    size_t words_length = 0;
+    unsigned int seed = 12345;
+
+    data->items = items;
+    data->numbers = malloc((size_t)items * 14 + 1); // Up to 2 spaces, '-' and 10 digits each.
+    data->words = malloc((size_t)items * 10 + 1);   // Up to 3 spaces and 6 letters each.
+    data->keys = malloc((size_t)items * sizeof(*data->keys));
+    if (!data->numbers || !data->words || !data->keys)
+    {
+        return 0;
+    }
+
+    for (long i = 0; i < items; i++)
+    {
+        // A small linear congruential generator: the same data on every run.
+        seed = seed * 1103515245u + 12345u;
+        numbers_length += (size_t)sprintf(data->numbers + numbers_length, "%.*s%d", (int)(seed >> 30) % 2 + 1, "  ",
+                                          (int)(seed >> 8) % 2000000 - 1000000);
+        words_length += (size_t)sprintf(data->words + words_length, "%.*s%.*s", (int)(seed >> 4) % 3 + 1, " \t\n",
+                                        (int)(seed >> 12) % 6 + 1, "abcdef");
+        snprintf(data->keys[i], KEY_SIZE, "room_%ld", i);
+    }
+    data->numbers[numbers_length] = '\0';
+    data->words[words_length] = '\0';
+    return 1;
+}
+
+static void free_data(BenchData *data)
+{
+    free(data->numbers);
+    free(data->words);
+    free(data->keys);
+}
+
+typedef long long (*Workload)(const BenchData *data);
+
+// Runs `workload` ROUNDS times and returns the best time, per item, in ns.
+static double time_workload(Workload workload, const BenchData *data, long long *checksum)
+{
+    double best = 0;
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        double start = now_seconds();
+        double elapsed;
+
+        *checksum = workload(data);
+        elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    return best * 1e9 / (double)data->items;
+}
+
+// Times both versions of one helper and prints a line comparing them.
+static int compare(const char *name, Workload with_calls, Workload inlined, const BenchData *data)
+{
+    long long call_checksum, inline_checksum;
+    double call_ns = time_workload(with_calls, data, &call_checksum);
+    double inline_ns = time_workload(inlined, data, &inline_checksum);
+
+    printf("%-16s %8.2f ns %8.2f ns %7.2fx\n", name, call_ns, inline_ns, inline_ns > 0 ? call_ns / inline_ns : 0.0);
+    if (call_checksum != inline_checksum)
+    {
+        fprintf(stderr, "%s: the call and inline versions disagree (%lld vs %lld).\n", name, call_checksum,
+                inline_checksum);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchData data = {0};
+    int items = DEFAULT_ITEMS;
+    int ok = 1;
+
+    if (argc > 2 || (argc == 2 && (!core_parse_int_value(argv[1], &items) || items < 1)))
+    {
+        fprintf(stderr, "Usage: %s [items]   (items: at least 1)\n", argv[0]);
+        return 1;
+    }
+
+    if (!make_data(&data, items))
+    {
+        fprintf(stderr, "Out of memory.\n");
+        free_data(&data);
+        return 1;
+    }
+
+    printf("%d items, best of %d runs, per item:\n", items, ROUNDS);
+    printf("%-16s %11s %11s %8s\n", "helper", "call", "inline", "speedup");
+    ok &= compare("skip_whitespace", skip_with_calls, skip_inline, &data);
+    ok &= compare("parse_int", parse_with_calls, parse_inline, &data);
+    ok &= compare("hash", hash_with_calls, hash_inline, &data);
+
+    free_data(&data);
+    return ok ? 0 : 1;
+}
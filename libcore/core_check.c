@@ -0,0 +1,205 @@
+/**
+ * @file core_check.c
+ * @brief Checks every libcore routine, including the awkward edge cases.
+ *
+ * Build it with the Makefile in this directory and run `./core_check`. It
+ * prints each failed check and exits with status 1, or prints
+ * "libcore check passed." The smoke check runs it too.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "core_inline.h"
+
+static int failures = 0;
+
+// Records a failed check, with the line it came from.
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            fprintf(stderr, "core_check.c:%d: check failed: %s\n", __LINE__, #condition);                             \
+            failures++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+static void check_text(void)
+{
+    char text[] = "  42 -17\t+3 2147483647 -2147483648 2147483648 x";
+    char *cursor = text;
+    int value = 0;
+
+    CHECK(core_parse_int(&cursor, &value) && value == 42);
+    CHECK(core_parse_int(&cursor, &value) && value == -17);
+    CHECK(core_parse_int(&cursor, &value) && value == 3);
+    CHECK(core_parse_int(&cursor, &value) && value == INT_MAX);
+    CHECK(core_parse_int(&cursor, &value) && value == INT_MIN);
+    CHECK(!core_parse_int(&cursor, &value) && value == INT_MIN); // Too big: rejected, cursor stays.
+    CHECK(strcmp(cursor, " 2147483648 x") == 0);
+
+    CHECK(core_parse_int_value(" 7 \n", &value) && value == 7);
+    CHECK(!core_parse_int_value("7x", &value));
+    CHECK(!core_parse_int_value("", &value));
+    CHECK(!core_parse_int_value("-", &value));
+    CHECK(!core_parse_int_value("99999999999999999999999", &value));
+
+    CHECK(core_is_blank(" \t\r\n"));
+    CHECK(!core_is_blank(" a"));
+    CHECK(*core_skip_whitespace("\v\f x") == 'x');
+}
+
+// The `static inline` helpers must agree with the library's, whichever of
+// the two this file was built to use. (core_parse_int) in parentheses is
+// always the library's function, even with -DCORE_INLINE.
+static void check_inline(void)
+{
+    const char *inputs[] = {"  42", "-2147483648", "2147483647", "2147483648", "+", " -0 ", "\t\n7x", ""};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    {
+        char text[32];
+        char *library_cursor = text;
+        char *inline_cursor = text;
+        int library_value = -1, inline_value = -1;
+        int library_ok, inline_ok;
+
+        snprintf(text, sizeof(text), "%s", inputs[i]);
+        library_ok = (core_parse_int)(&library_cursor, &library_value);
+        inline_ok = core_inline_parse_int(&inline_cursor, &inline_value);
+        CHECK(library_ok == inline_ok && library_value == inline_value && library_cursor == inline_cursor);
+        CHECK((core_skip_whitespace)(text) == core_inline_skip_whitespace(text));
+        CHECK((core_hash)(text, strlen(text)) == core_inline_hash(text, strlen(text)));
+    }
+}
+
+static void check_lines(void)
+{
+    char text[] = "first\n\nthis line is too long\nlast";
+    char *cursor = text;
+    char *line;
+
+    CHECK(core_next_line(&cursor, &line, 16) == 1 && strcmp(line, "first") == 0);
+    CHECK(core_next_line(&cursor, &line, 16) == 1 && strcmp(line, "") == 0);
+    CHECK(core_next_line(&cursor, &line, 16) == -1 && strcmp(line, "this line is too long") == 0);
+    CHECK(core_next_line(&cursor, &line, 16) == 1 && strcmp(line, "last") == 0);
+    CHECK(core_next_line(&cursor, &line, 16) == 0);
+}
+
+static void check_files(void)
+{
+    char buffer[8];
+    char *contents;
+    size_t length = 0;
+    FILE *file = tmpfile();
+
+    if (!file)
+    {
+        CHECK(file != NULL);
+        return;
+    }
+    fputs("short\nthis one is long\n1234567\nend\n7654321", file);
+    rewind(file);
+    CHECK(core_read_line(file, buffer, sizeof(buffer)) == 1 && strcmp(buffer, "short") == 0);
+    CHECK(core_read_line(file, buffer, sizeof(buffer)) == -1 && buffer[0] == '\0');
+    CHECK(core_read_line(file, buffer, sizeof(buffer)) == 1 && strcmp(buffer, "1234567") == 0); // Fits exactly.
+    CHECK(core_read_line(file, buffer, sizeof(buffer)) == 1 && strcmp(buffer, "end") == 0);
+    CHECK(core_read_line(file, buffer, sizeof(buffer)) == 1 && strcmp(buffer, "7654321") == 0); // And at the end.
+    CHECK(core_read_line(file, buffer, sizeof(buffer)) == 0);
+    fclose(file);
+
+    // A file whose size is exactly a power of two, and an empty one.
+    file = fopen("core_check.tmp", "wb");
+    CHECK(file != NULL);
+    if (file)
+    {
+        for (int i = 0; i < 65536; i++)
+        {
+            fputc('a' + i % 26, file);
+        }
+        fclose(file);
+        contents = core_read_file("core_check.tmp", &length);
+        CHECK(contents && length == 65536 && contents[65535] == 'a' + 65535 % 26 && contents[65536] == '\0');
+        free(contents);
+    }
+    file = fopen("core_check.tmp", "wb");
+    if (file)
+    {
+        fclose(file);
+        contents = core_read_file("core_check.tmp", &length);
+        CHECK(contents && length == 0 && contents[0] == '\0');
+        free(contents);
+    }
+    remove("core_check.tmp");
+    CHECK(core_read_file("core_check.does.not.exist", &length) == NULL);
+}
+
+static void check_table(void)
+{
+    CoreTable *table = core_table_create(0);
+    static int values[5000];
+    char key[32];
+
+    CHECK(table != NULL);
+    if (!table)
+    {
+        return;
+    }
+    CHECK(core_hash("", 0) == 2166136261u);
+    CHECK(core_hash("a", 1) == 0xe40c292cu);
+
+    // Enough keys to make the table grow several times.
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        values[i] = i;
+        CHECK(core_table_put(table, key, &values[i]));
+    }
+    CHECK(core_table_count(table) == 5000);
+    CHECK(core_table_put(table, "key7", &values[8]) && core_table_get(table, "key7") == &values[8]);
+    CHECK(core_table_count(table) == 5000);
+
+    // Remove every third key, then make sure all the others are still found.
+    for (int i = 0; i < 5000; i += 3)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        CHECK(core_table_remove(table, key));
+    }
+    CHECK(!core_table_remove(table, "key0"));
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf(key, sizeof(key), "key%d", i);
+        if (i % 3 == 0)
+        {
+            CHECK(core_table_get(table, key) == NULL);
+        }
+        else if (i != 7)
+        {
+            CHECK(core_table_get(table, key) == &values[i]);
+        }
+    }
+    CHECK(core_table_count(table) == 5000 - 1667);
+    core_table_destroy(table);
+}
+
+int main(void)
+{
+    check_text();
+    check_inline();
+    check_lines();
+    check_files();
+    check_table();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d libcore checks failed.\n", failures);
+        return 1;
+    }
+    printf("libcore check passed.\n");
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file core_file.c
+ * @brief libcore: loading whole files.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "core.h"
+
+#define CORE_READ_CHUNK_SIZE (64 * 1024)
+
+/*
+ * For an ordinary file we ask for its size up front, so the buffer is
+ * allocated once and filled with one fread(). Pipes and terminals have no
+ * size, so for them we fall back to reading chunks into a growing buffer.
+ */
+char *core_read_file(const char *filename, size_t *length)
+{
+    FILE *file = fopen(filename, "rb");
+    char *buffer = NULL;
+    size_t capacity = 0;
+    size_t used = 0;
+    long size = -1;
+    int saved_errno;
+
+    if (!file)
+    {
+        return NULL;
+    }
+
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        size = ftell(file);
+        if (fseek(file, 0, SEEK_SET) != 0)
+        {
+            size = -1;
+        }
+    }
+    clearerr(file);
+
+    for (;;)
+    {
+        size_t wanted;
+        size_t bytes_read;
+
+        // Always keep room for the terminating '\0'.
+        if (used + 1 >= capacity)
+        {
+            size_t new_capacity = capacity ? capacity * 2 : CORE_READ_CHUNK_SIZE;
+            int next = 0;
+            char *grown;
+
+            // The buffer is full. If that was the whole file (as it is when we
+            // knew the size), stop here instead of growing it for nothing.
+            if (capacity && (next = fgetc(file)) == EOF)
+            {
+                break;
+            }
+            if (size >= 0 && capacity == 0)
+            {
+                new_capacity = (size_t)size + 1; // +1 for the '\0'. Usually the only allocation.
+            }
+            grown = realloc(buffer, new_capacity);
+            if (!grown)
+            {
+                free(buffer);
+                fclose(file);
+                errno = ENOMEM;
+                return NULL;
+            }
+            if (capacity)
+            {
+                grown[used++] = (char)next;
+            }
+            buffer = grown;
+            capacity = new_capacity;
+        }
+
+        wanted = capacity - 1 - used;
+        bytes_read = fread(buffer + used, 1, wanted, file);
+        used += bytes_read;
+        if (bytes_read < wanted)
+        {
+            break; // The end of the file, or an error.
+        }
+    }
+
+    if (ferror(file))
+    {
+        saved_errno = errno;
+        free(buffer);
+        fclose(file);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    fclose(file);
+    buffer[used] = '\0';
+    *length = used;
+    return buffer;
+}
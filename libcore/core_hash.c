@@ -0,0 +1,199 @@
+/**
+ * @file core_hash.c
+ * @brief libcore: hashing and a string-keyed hash table.
+ *
+ * The table uses OPEN ADDRESSING with LINEAR PROBING: all entries live in one
+ * array, and a key that finds its slot taken goes to the next free one. The
+ * probes walk neighbouring memory, which the CPU's caches love, where
+ * Lesson 28's chained table follows a pointer to a separate node for every
+ * step. Each slot also keeps the key's full hash, so most mismatches are
+ * rejected without comparing strings.
+ */
+
+#define CORE_BUILDING_LIBRARY
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "core_inline.h"
+
+#define CORE_TABLE_MIN_CAPACITY 16
+
+typedef struct
+{
+    char *key;      // NULL for an empty slot.
+    void *value;
+    uint32_t hash;
+} CoreSlot;
+
+struct CoreTable
+{
+    CoreSlot *slots;
+    size_t capacity; // Always a power of two, so `hash & (capacity - 1)` picks a slot.
+    size_t count;
+};
+
+uint32_t core_hash(const void *data, size_t length)
+{
+    return core_inline_hash(data, length);
+}
+
+CoreTable *core_table_create(size_t expected_count)
+{
+    CoreTable *table = malloc(sizeof(CoreTable));
+    size_t capacity = CORE_TABLE_MIN_CAPACITY;
+
+    if (!table)
+    {
+        return NULL;
+    }
+    // Room for the expected entries while staying at most 3/4 full.
+    while (capacity / 4 * 3 < expected_count)
+    {
+        capacity *= 2;
+    }
+
+    table->slots = calloc(capacity, sizeof(CoreSlot));
+    if (!table->slots)
+    {
+        free(table);
+        return NULL;
+    }
+    table->capacity = capacity;
+    table->count = 0;
+    return table;
+}
+
+void core_table_destroy(CoreTable *table)
+{
+    if (!table)
+    {
+        return;
+    }
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        free(table->slots[i].key);
+    }
+    free(table->slots);
+    free(table);
+}
+
+// Returns the slot holding `key`, or the empty slot where it would go.
+static CoreSlot *find_slot(CoreSlot *slots, size_t capacity, const char *key, uint32_t hash)
+{
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+
+    while (slots[i].key && (slots[i].hash != hash || strcmp(slots[i].key, key) != 0))
+    {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static int grow(CoreTable *table)
+{
+    size_t new_capacity = table->capacity * 2;
+    CoreSlot *new_slots = calloc(new_capacity, sizeof(CoreSlot));
+
+    if (!new_slots)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        CoreSlot *old = &table->slots[i];
+
+        if (old->key)
+        {
+            *find_slot(new_slots, new_capacity, old->key, old->hash) = *old;
+        }
+    }
+    free(table->slots);
+    table->slots = new_slots;
+    table->capacity = new_capacity;
+    return 1;
+}
+
+int core_table_put(CoreTable *table, const char *key, void *value)
+{
+    size_t length = strlen(key);
+    uint32_t hash = core_hash(key, length);
+    CoreSlot *slot = find_slot(table->slots, table->capacity, key, hash);
+
+    if (slot->key)
+    {
+        slot->value = value; // Already there: just replace the value.
+        return 1;
+    }
+
+    // Keep the table at most 3/4 full, or probe runs get long.
+    if ((table->count + 1) * 4 > table->capacity * 3)
+    {
+        if (!grow(table))
+        {
+            return 0;
+        }
+        slot = find_slot(table->slots, table->capacity, key, hash);
+    }
+
+    slot->key = malloc(length + 1);
+    if (!slot->key)
+    {
+        return 0;
+    }
+    memcpy(slot->key, key, length + 1);
+    slot->value = value;
+    slot->hash = hash;
+    table->count++;
+    return 1;
+}
+
+void *core_table_get(const CoreTable *table, const char *key)
+{
+    CoreSlot *slot = find_slot(table->slots, table->capacity, key, core_hash(key, strlen(key)));
+
+    return slot->key ? slot->value : NULL;
+}
+
+/*
+ * Removing from a linear-probing table can't just empty the slot: a later
+ * key that had probed PAST this slot would no longer be found. So we walk
+ * the rest of the run and move back every entry that may now sit closer to
+ * its home slot ("backward shift deletion"). No "deleted" markers needed.
+ */
+int core_table_remove(CoreTable *table, const char *key)
+{
+    size_t mask = table->capacity - 1;
+    CoreSlot *slot = find_slot(table->slots, table->capacity, key, core_hash(key, strlen(key)));
+    size_t hole, i;
+
+    if (!slot->key)
+    {
+        return 0;
+    }
+    free(slot->key);
+    slot->key = NULL;
+    table->count--;
+
+    hole = (size_t)(slot - table->slots);
+    for (i = (hole + 1) & mask; table->slots[i].key; i = (i + 1) & mask)
+    {
+        size_t home = table->slots[i].hash & mask;
+
+        // Move the entry into the hole unless its home lies (cyclically) in (hole, i].
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            table->slots[hole] = table->slots[i];
+            table->slots[i].key = NULL;
+            hole = i;
+        }
+    }
+    return 1;
+}
+
+size_t core_table_count(const CoreTable *table)
+{
+    return table->count;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file core_inline.h
+ * @brief libcore: header-only versions of the hottest helpers.
+ *
+ * A call into libcore.a crosses from one translation unit into another. The
+ * compiler sees only the declaration in core.h, so it can't INLINE the
+ * function (paste its body into the caller). Every call pays for the jump,
+ * the return and the registers the call forces to memory, and the optimizer
+ * can't specialize the body for the call site. For a helper that runs once
+ * per character or token, that overhead is a big share of the work.
+ *
+ * This header gives those helpers a `static inline` body that every file can
+ * see. Define CORE_INLINE before including core.h (or build with
+ * `-DCORE_INLINE`, e.g. `make -C libcore CORE_INLINE=1`) and calls to
+ * core_skip_whitespace(), core_parse_int() and core_hash() are compiled
+ * from these bodies instead. Without the flag nothing changes, and the
+ * out-of-line versions in libcore.a are themselves built from this header,
+ * so the two can never drift apart. Link-time optimization (`make
+ * PROFILE=lto`) also lets the compiler inline across files, but it weighs
+ * each call for itself; in our measurements it left these calls alone.
+ *
+ * `libcore/core_bench.c` measures the difference. Expect it to be smaller
+ * than the reasoning above suggests for the text helpers: on irregular text,
+ * mispredicted branches cost far more than the call. The hash, a tight loop
+ * the compiler can fuse with the caller's, gains the most. Measure before
+ * inlining anything else.
+ */
+
+#ifndef CORE_INLINE_H
+#define CORE_INLINE_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Space, tab, newline, vertical tab, form feed and carriage return, as in
+// isspace() in the "C" locale.
+static inline int core_inline_is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline char *core_inline_skip_whitespace(const char *text)
+{
+    while (core_inline_is_space(*text))
+    {
+        text++;
+    }
+
+    return (char *)text; // Like strchr(), we hand back the caller's own pointer.
+}
+
+static inline int core_inline_parse_int(char **cursor, int *value)
+{
+    const char *text = core_inline_skip_whitespace(*cursor);
+    int negative = 0;
+    // Collect the digits as a negative number: INT_MIN has no positive twin.
+    long long parsed = 0;
+
+    if (*text == '-' || *text == '+')
+    {
+        negative = *text == '-';
+        text++;
+    }
+    if (*text < '0' || *text > '9')
+    {
+        return 0;
+    }
+
+    while (*text >= '0' && *text <= '9')
+    {
+        parsed = parsed * 10 - (*text - '0');
+        if (parsed < INT_MIN)
+        {
+            return 0; // Too big for an int (and for our long long, if we went on).
+        }
+        text++;
+    }
+
+    if (!negative)
+    {
+        if (parsed < -(long long)INT_MAX)
+        {
+            return 0;
+        }
+        parsed = -parsed;
+    }
+
+    *value = (int)parsed;
+    *cursor = (char *)text;
+    return 1;
+}
+
+// FNV-1a: a tiny, fast hash that spreads short strings well.
+static inline uint32_t core_inline_hash(const void *data, size_t length)
+{
+    const unsigned char *bytes = data;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#endif // CORE_INLINE_H
@@ -0,0 +1,109 @@
+/**
+ * @file core_text.c
+ * @brief libcore: whitespace, numbers and lines.
+ *
+ * These run once per token or line of every file a program parses, so they
+ * avoid the general-purpose library calls the lessons use (isspace() and
+ * strtol() both consult the locale, and strtol() also handles bases, signs
+ * in odd places and errno) in favor of plain loops over the characters.
+ */
+
+#define CORE_BUILDING_LIBRARY
+
+#include <limits.h>
+#include <string.h>
+
+#include "core.h"
+#include "core_inline.h"
+
+// The bodies live in core_inline.h, so the inline and out-of-line versions
+// are always the same code.
+char *core_skip_whitespace(const char *text)
+{
+    return core_inline_skip_whitespace(text);
+}
+
+int core_is_blank(const char *text)
+{
+    return *core_skip_whitespace(text) == '\0';
+}
+
+int core_parse_int(char **cursor, int *value)
+{
+    return core_inline_parse_int(cursor, value);
+}
+
+int core_parse_int_value(const char *text, int *value)
+{
+    char *cursor = (char *)text;
+
+    return core_parse_int(&cursor, value) && core_is_blank(cursor);
+}
+
+int core_next_line(char **cursor, char **line, size_t max_length)
+{
+    char *start = *cursor;
+    char *newline;
+    size_t length;
+
+    if (*start == '\0')
+    {
+        return 0;
+    }
+
+    // strchr() checks many bytes per step, much faster than a loop of our own.
+    newline = strchr(start, '\n');
+    if (newline)
+    {
+        length = (size_t)(newline - start);
+        *newline = '\0';
+        *cursor = newline + 1;
+    }
+    else
+    {
+        length = strlen(start);
+        *cursor = start + length;
+    }
+
+    *line = start;
+    return length < max_length ? 1 : -1;
+}
+
+int core_read_line(FILE *stream, char *buffer, size_t size)
+{
+    char *newline;
+    int ch;
+
+    if (size < 2 || size > INT_MAX || fgets(buffer, (int)size, stream) == NULL)
+    {
+        return 0;
+    }
+
+    newline = strchr(buffer, '\n'); // Only the string fgets() wrote, not the whole buffer.
+    if (newline)
+    {
+        *newline = '\0';
+        return 1;
+    }
+    if (feof(stream))
+    {
+        return 1; // The last line had no newline; that's fine.
+    }
+
+    // fgets() filled the buffer. If the newline (or the end of the input)
+    // comes right after, the line fit exactly.
+    ch = fgetc(stream);
+    if (ch == '\n' || ch == EOF)
+    {
+        return 1;
+    }
+    ungetc(ch, stream);
+
+    // The line is longer than the buffer. Skip the rest so the next call
+    // starts on the next line.
+    while ((ch = fgetc(stream)) != '\n' && ch != EOF)
+    {
+    }
+    buffer[0] = '\0';
+    return -1;
+}
@@ -0,0 +1,119 @@
+#!/bin/sh
+#
+# Times each program's workloads with scripts/bench_runner.c and appends the
+# results to a CSV history, so performance can be compared between commits.
+#
+#   sh scripts/bench.sh [BIN_DIR]           Run every workload.
+#   sh scripts/bench.sh --compare [OLD NEW] Compare two commits in the history
+#                                           (by default, the last two).
+#
+# `make bench` builds everything and runs the first form; `make bench-compare`
+# runs the second. Settings come from the environment:
+#
+#   BENCH_RUNNER   The compiled bench_runner (required for a run).
+#   BENCH_HISTORY  The history file (default: bench-history.csv in the repo).
+#   BENCH_REPEAT   Measured runs per workload (default: 5).
+#   BENCH_WARMUP   Unmeasured runs first (default: 1).
+#   BENCH_PROFILE  The build profile, recorded with each result.
+
+set -eu
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/.." && pwd)
+HISTORY=${BENCH_HISTORY:-$ROOT_DIR/bench-history.csv}
+REPEAT=${BENCH_REPEAT:-5}
+WARMUP=${BENCH_WARMUP:-1}
+PROFILE=${BENCH_PROFILE:-unknown}
+
+# Prints each workload's median wall time in commit OLD and in commit NEW,
+# and how much it changed. A workload that ran more than once in a commit
+# counts with its latest result.
+compare_commits() {
+    if [ ! -f "$HISTORY" ]; then
+        echo "No benchmark history yet: $HISTORY" >&2
+        exit 1
+    fi
+
+    awk -F, -v old="${1:-}" -v new="${2:-}" '
+        NR == 1 { next }
+        {
+            if (!($2 in seen)) {
+                seen[$2] = 1
+                commits[++commit_count] = $2
+            }
+            if (!(($2, $4) in wall)) {
+                labels[$2, ++label_count[$2]] = $4
+            }
+            wall[$2, $4] = $6
+        }
+        END {
+            if (old == "" && new == "") {
+                old = commits[commit_count - 1]
+                new = commits[commit_count]
+            }
+            if (old == "" || !(old in seen) || !(new in seen)) {
+                print "Need two commits in the history to compare." > "/dev/stderr"
+                exit 1
+            }
+            printf "%-32s %12s %12s %9s\n", "workload", old, new, "change"
+            for (i = 1; i <= label_count[new]; i++) {
+                label = labels[new, i]
+                if (!((old, label) in wall)) {
+                    printf "%-32s %12s %12.3f %9s\n", label, "-", wall[new, label], "new"
+                    continue
+                }
+                change = wall[old, label] > 0 ? (wall[new, label] - wall[old, label]) * 100 / wall[old, label] : 0
+                # Changes within 5% are usually noise.
+                verdict = ""
+                if (change > 5) verdict = "  slower"
+                if (change < -5) verdict = "  faster"
+                printf "%-32s %12.3f %12.3f %+8.1f%%%s\n", label, wall[old, label], wall[new, label], change, verdict
+            }
+        }' "$HISTORY"
+}
+
+if [ "${1:-}" = "--compare" ]; then
+    compare_commits "${2:-}" "${3:-}"
+    exit 0
+fi
+
+BIN_DIR=${1:-$ROOT_DIR/build/release/bin}
+RUNNER=${BENCH_RUNNER:?Set BENCH_RUNNER to the compiled scripts/bench_runner.c (or use make bench).}
+DATA_DIR=$(mktemp -d "${TMPDIR:-/tmp}/cftgu-bench.XXXXXX")
+trap 'rm -rf "$DATA_DIR"' EXIT INT TERM HUP
+
+# The commit the programs were built from; "-dirty" if there are local edits.
+COMMIT=$(git -C "$ROOT_DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)
+if ! git -C "$ROOT_DIR" diff --quiet HEAD -- 2>/dev/null; then
+    COMMIT=$COMMIT-dirty
+fi
+
+bench() {
+    label=$1
+    shift
+    "$RUNNER" --warmup "$WARMUP" --repeat "$REPEAT" --label "$label" --csv "$HISTORY" --commit "$COMMIT" \
+        --profile "$PROFILE" -- "$@"
+}
+
+# --- Test Data ---
+# A generated world doubles as a big text file for grep and the analyzer.
+world=$DATA_DIR/world.map
+"$BIN_DIR/35_capstone_awesome_text_adventure" --generate 100000 50 1 "$world"
+"$BIN_DIR/35_capstone_awesome_text_adventure" --compile "$world" "$world.img" >/dev/null
+awk 'BEGIN { for (i = 1; i <= 10; i++) printf "%d,user%d,%d,%d\n", i, i, i * 7 % 50, i % 2 }' > "$DATA_DIR/users.dat"
+
+printf 'Benchmarking %s (%s build), %d runs each after %d warmup.\n' "$COMMIT" "$PROFILE" "$REPEAT" "$WARMUP"
+
+# --- Workloads ---
+bench grep "$BIN_DIR/27_build_your_own_grep" cavern "$world"
+bench hash_table "$BIN_DIR/28_hash_table_implementation"
+bench analyzer "$BIN_DIR/30_multithreaded_file_analyzer" "$world"
+bench parse_users "$BIN_DIR/34_parsing_data_files" "$DATA_DIR/users.dat"
+bench capstone_text_load "$BIN_DIR/35_capstone_awesome_text_adventure" --validate "$world"
+bench capstone_image_load "$BIN_DIR/35_capstone_awesome_text_adventure" --validate "$world.img"
+bench capstone_commands "$BIN_DIR/35_capstone_awesome_text_adventure" --benchmark-commands "$world" 500000
+bench capstone_render "$BIN_DIR/35_capstone_awesome_text_adventure" --benchmark-render "$world" 500
+bench terminal_ui_render "$BIN_DIR/33_advanced_terminal_ui" --benchmark 200
+bench terminal_ui_list "$BIN_DIR/33_advanced_terminal_ui" --benchmark-list 300
+bench libcore_helpers "$BIN_DIR/core_bench"
+
+printf 'Results appended to %s\n' "$HISTORY"
@@ -0,0 +1,478 @@
+/**
+ * @file bench_runner.c
+ * @brief Runs one benchmark command many times and records what it cost.
+ *
+ * This is a tool for the book's maintainers, not a lesson. `scripts/bench.sh`
+ * (or `make bench`) uses it to time every program's workloads the same way:
+ *
+ *   bench_runner [--warmup N] [--repeat N] [--label NAME] [--csv FILE]
+ *                [--commit ID] [--profile NAME] -- command [arguments...]
+ *
+ * The command runs N warmup times (not measured, so caches and the page
+ * cache settle), then N measured times. For each measured run we collect:
+ *
+ * - Wall time: from just before the command starts to just after it ends.
+ * - CPU time and peak memory (max RSS), from wait4()'s resource usage.
+ * - On Linux, counters from perf_event_open(): the hardware's cycles,
+ *   instructions, cache misses and branch misses, and the kernel's page
+ *   faults and context switches. They count the command and all of its
+ *   threads, and nothing of the runner itself. Counters the system does not
+ *   offer (virtual machines often have no hardware counters, and see
+ *   /proc/sys/kernel/perf_event_paranoid) are left empty.
+ *
+ * A summary is printed, and with --csv, one row of medians is appended to a
+ * history file, so results can be compared between commits.
+ */
+
+#define _GNU_SOURCE // For wait4() and syscall().
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h> // For offsetof()
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#define MAX_REPEATS 1000
+#define COUNTER_COUNT 6
+
+static const char *const counter_names[COUNTER_COUNT] = {"cycles",        "instructions", "cache_misses",
+                                                         "branch_misses", "page_faults",  "context_switches"};
+
+// What one measured run cost.
+typedef struct
+{
+    double wall_ms;
+    double user_ms;
+    double system_ms;
+    long max_rss_kb;
+    long long counters[COUNTER_COUNT]; // -1 where a counter is not available.
+} RunResult;
+
+typedef struct
+{
+    int warmups;
+    int repeats;
+    const char *label;
+    const char *csv_filename;
+    const char *commit;
+    const char *profile;
+    char **command;
+} Options;
+
+static double now_ms(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+}
+
+static double timeval_ms(struct timeval value)
+{
+    return (double)value.tv_sec * 1000.0 + (double)value.tv_usec / 1000.0;
+}
+
+// --- Hardware Counters ---
+
+#ifdef __linux__
+static const struct
+{
+    uint32_t type;
+    uint64_t config;
+} counter_events[COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},   {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+/*
+ * Opens the counters for process `pid`, which must not have exec'd yet.
+ * They start counting when it does (enable_on_exec) and follow every thread
+ * it creates (inherit). Counters that can't be opened get -1.
+ */
+static void open_counters(pid_t pid, int fds[COUNTER_COUNT])
+{
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counter_events[i].type;
+        attr.config = counter_events[i].config;
+        attr.disabled = 1;
+        attr.enable_on_exec = 1;
+        attr.inherit = 1;
+        // Unprivileged users usually may not count the kernel's instructions.
+        // Page faults and context switches happen in the kernel, though.
+        attr.exclude_kernel = counter_events[i].type == PERF_TYPE_HARDWARE;
+        attr.exclude_hv = 1;
+        fds[i] = (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+    }
+}
+
+static void read_counters(int fds[COUNTER_COUNT], long long values[COUNTER_COUNT])
+{
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        uint64_t value;
+
+        values[i] = -1;
+        if (fds[i] >= 0)
+        {
+            if (read(fds[i], &value, sizeof(value)) == (ssize_t)sizeof(value))
+            {
+                values[i] = (long long)value;
+            }
+            close(fds[i]);
+        }
+    }
+}
+#else
+// Other systems have no perf_event_open(); the counter columns stay empty.
+static void open_counters(pid_t pid, int fds[COUNTER_COUNT])
+{
+    (void)pid;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        fds[i] = -1;
+    }
+}
+
+static void read_counters(int fds[COUNTER_COUNT], long long values[COUNTER_COUNT])
+{
+    (void)fds;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        values[i] = -1;
+    }
+}
+#endif
+
+// --- Running the Command ---
+
+/*
+ * Runs the command once with its output thrown away, and fills in `result`.
+ * Returns 1 if the command ran and exited with status 0.
+ *
+ * The child waits on a pipe until the parent has opened the counters, so
+ * the counters can't miss the start of the command.
+ */
+static int run_once(char **command, RunResult *result)
+{
+    int go[2];
+    int fds[COUNTER_COUNT];
+    pid_t pid;
+    int status;
+    struct rusage usage;
+    double start;
+
+    if (pipe(go) != 0)
+    {
+        perror("pipe");
+        return 0;
+    }
+
+    pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        close(go[0]);
+        close(go[1]);
+        return 0;
+    }
+    if (pid == 0)
+    {
+        char byte;
+        int null_fd = open("/dev/null", O_RDWR);
+
+        close(go[1]);
+        if (read(go[0], &byte, 1) < 0)
+        {
+            _exit(127);
+        }
+        close(go[0]);
+        if (null_fd >= 0)
+        {
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+        execvp(command[0], command);
+        fprintf(stderr, "bench_runner: cannot run %s: %s\n", command[0], strerror(errno));
+        _exit(127);
+    }
+
+    close(go[0]);
+    open_counters(pid, fds);
+    start = now_ms();
+    close(go[1]); // Go!
+
+    while (wait4(pid, &status, 0, &usage) < 0)
+    {
+        if (errno != EINTR)
+        {
+            perror("wait4");
+            return 0;
+        }
+    }
+    result->wall_ms = now_ms() - start;
+    read_counters(fds, result->counters);
+    result->user_ms = timeval_ms(usage.ru_utime);
+    result->system_ms = timeval_ms(usage.ru_stime);
+#if defined(__APPLE__)
+    result->max_rss_kb = usage.ru_maxrss / 1024; // macOS reports bytes.
+#else
+    result->max_rss_kb = usage.ru_maxrss; // Linux reports kilobytes.
+#endif
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// --- Summarizing ---
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+// The median is less thrown off than the mean by one run that got unlucky.
+static double median(double *values, int count)
+{
+    qsort(values, (size_t)count, sizeof(double), compare_doubles);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+static double median_of(const RunResult *runs, int count, size_t offset)
+{
+    double values[MAX_REPEATS];
+
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = *(const double *)((const char *)&runs[i] + offset);
+    }
+    return median(values, count);
+}
+
+// Median of one hardware counter, or -1 if any run is missing it.
+static double counter_median(const RunResult *runs, int count, int counter)
+{
+    double values[MAX_REPEATS];
+
+    for (int i = 0; i < count; i++)
+    {
+        if (runs[i].counters[counter] < 0)
+        {
+            return -1.0;
+        }
+        values[i] = (double)runs[i].counters[counter];
+    }
+    return median(values, count);
+}
+
+static int append_csv(const Options *options, const RunResult *runs, double wall_median, double wall_min)
+{
+    long max_rss = 0;
+    int is_new;
+    FILE *csv;
+
+    for (int i = 0; i < options->repeats; i++)
+    {
+        max_rss = runs[i].max_rss_kb > max_rss ? runs[i].max_rss_kb : max_rss;
+    }
+
+    csv = fopen(options->csv_filename, "a");
+    if (!csv)
+    {
+        perror(options->csv_filename);
+        return 0;
+    }
+    is_new = ftell(csv) == 0;
+    if (is_new)
+    {
+        fprintf(csv, "timestamp,commit,profile,label,repeats,wall_median_ms,wall_min_ms,user_median_ms,"
+                     "system_median_ms,max_rss_kb");
+        for (int i = 0; i < COUNTER_COUNT; i++)
+        {
+            fprintf(csv, ",%s", counter_names[i]);
+        }
+        fputc('\n', csv);
+    }
+
+    fprintf(csv, "%lld,%s,%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%ld", (long long)time(NULL), options->commit, options->profile,
+            options->label, options->repeats, wall_median, wall_min,
+            median_of(runs, options->repeats, offsetof(RunResult, user_ms)),
+            median_of(runs, options->repeats, offsetof(RunResult, system_ms)), max_rss);
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        double value = counter_median(runs, options->repeats, i);
+
+        if (value >= 0)
+        {
+            fprintf(csv, ",%.0f", value);
+        }
+        else
+        {
+            fputc(',', csv); // Not available here.
+        }
+    }
+    fputc('\n', csv);
+    return fclose(csv) == 0;
+}
+
+// --- Command-Line Handling ---
+
+static int parse_count(const char *text, int min, int *count)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+
+    if (*text == '\0' || *end != '\0' || value < min || value > MAX_REPEATS)
+    {
+        fprintf(stderr, "bench_runner: '%s' is not a count from %d to %d.\n", text, min, MAX_REPEATS);
+        return 0;
+    }
+    *count = (int)value;
+    return 1;
+}
+
+static int parse_options(int argc, char *argv[], Options *options)
+{
+    int i;
+
+    options->warmups = 1;
+    options->repeats = 5;
+    options->label = NULL;
+    options->csv_filename = NULL;
+    options->commit = "unknown";
+    options->profile = "unknown";
+    options->command = NULL;
+
+    for (i = 1; i < argc - 1 && strcmp(argv[i], "--") != 0; i += 2)
+    {
+        if (strcmp(argv[i], "--warmup") == 0)
+        {
+            if (!parse_count(argv[i + 1], 0, &options->warmups))
+            {
+                return 0;
+            }
+        }
+        else if (strcmp(argv[i], "--repeat") == 0)
+        {
+            if (!parse_count(argv[i + 1], 1, &options->repeats))
+            {
+                return 0;
+            }
+        }
+        else if (strcmp(argv[i], "--label") == 0)
+        {
+            options->label = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--csv") == 0)
+        {
+            options->csv_filename = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--commit") == 0)
+        {
+            options->commit = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            options->profile = argv[i + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (i >= argc - 1 || strcmp(argv[i], "--") != 0)
+    {
+        fprintf(stderr,
+                "Usage: %s [--warmup N] [--repeat N] [--label NAME] [--csv FILE] [--commit ID] [--profile NAME]"
+                " -- command [arguments...]\n",
+                argv[0]);
+        return 0;
+    }
+    options->command = &argv[i + 1];
+    if (!options->label)
+    {
+        options->label = options->command[0];
+    }
+    // The label goes into a CSV file unquoted.
+    if (strpbrk(options->label, ",\"\n") || strpbrk(options->commit, ",\"\n") || strpbrk(options->profile, ",\"\n"))
+    {
+        fprintf(stderr, "bench_runner: labels, commits and profiles can't contain commas, quotes or newlines.\n");
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    static RunResult runs[MAX_REPEATS];
+    Options options;
+    RunResult warmup;
+    double walls[MAX_REPEATS];
+    double wall_median, wall_min;
+    long max_rss = 0;
+
+    if (!parse_options(argc, argv, &options))
+    {
+        return 2;
+    }
+
+    for (int i = 0; i < options.warmups; i++)
+    {
+        if (!run_once(options.command, &warmup))
+        {
+            fprintf(stderr, "bench_runner: %s failed during warmup.\n", options.label);
+            return 1;
+        }
+    }
+    for (int i = 0; i < options.repeats; i++)
+    {
+        if (!run_once(options.command, &runs[i]))
+        {
+            fprintf(stderr, "bench_runner: %s failed.\n", options.label);
+            return 1;
+        }
+        walls[i] = runs[i].wall_ms;
+        max_rss = runs[i].max_rss_kb > max_rss ? runs[i].max_rss_kb : max_rss;
+    }
+
+    wall_median = median(walls, options.repeats); // Sorts `walls`, so walls[0] is the fastest.
+    wall_min = walls[0];
+
+    printf("%-32s %10.3f ms median %10.3f ms min %10.3f ms cpu %8ld KB rss", options.label, wall_median, wall_min,
+           median_of(runs, options.repeats, offsetof(RunResult, user_ms)) +
+               median_of(runs, options.repeats, offsetof(RunResult, system_ms)),
+           max_rss);
+    if (counter_median(runs, options.repeats, 0) > 0 && counter_median(runs, options.repeats, 1) > 0)
+    {
+        printf(" %6.2f IPC", counter_median(runs, options.repeats, 1) / counter_median(runs, options.repeats, 0));
+    }
+    putchar('\n');
+
+    if (options.csv_filename && !append_csv(&options, runs, wall_median, wall_min))
+    {
+        return 1;
+    }
+    return 0;
+}
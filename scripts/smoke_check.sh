@@ -9,6 +9,7 @@ ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/.." && pwd)
 BUILD_DIR=$(mktemp -d "${TMPDIR:-/tmp}/cftgu-smoke.XXXXXX")
 SOURCE_LIST="$BUILD_DIR/sources.txt"
 LESSON31_DIR="$ROOT_DIR/Part 5 - Expert Systems & Application Development/31_make_files_for_multi_file_projects"
+LIBCORE_DIR="$ROOT_DIR/libcore"
 SOCKET_SERVER_PID=
 STANDARD_FLAG=
 EFFECTIVE_CFLAGS=
@@ -20,6 +21,7 @@ cleanup() {
     fi
     rm -rf "$BUILD_DIR"
     make -C "$LESSON31_DIR" clean >/dev/null 2>&1 || true
+    make -C "$LIBCORE_DIR" clean >/dev/null 2>&1 || true
 }
 
 trap cleanup EXIT INT TERM HUP
@@ -84,10 +86,10 @@ compile_lesson() {
     extra_flags=
 
     case "$lesson_path" in
-        *30_multithreaded_file_analyzer.c)
+        *20_lock_free_lists.c|*20_skip_list.c|*30_multithreaded_file_analyzer.c)
             extra_flags="-pthread"
             ;;
-        *32_linking_external_libraries.c)
+        *21_probabilistic_sketches.c|*32_linking_external_libraries.c)
             extra_flags="-lm"
             ;;
         *33_advanced_terminal_ui.c|*35_capstone_awesome_text_adventure.c)
@@ -242,6 +244,63 @@ run_student_record_checks() {
     expect_contains "$load_output" "3.50" "Student system did not print the reloaded GPA."
 }
 
+run_linked_list_check() {
+    list_output=$("$BUILD_DIR/20_linked_lists" --benchmark 20000)
+    expect_contains "$list_output" "All three lists agree" "The unrolled list lost or reordered items."
+
+    demo_output=$("$BUILD_DIR/20_linked_lists")
+    expect_contains "$demo_output" "[1 2 3 4 5 100 6] -> [7 8 9 10 11 12 13] ->" "The unrolled list did not split a full node."
+    expect_contains "$demo_output" "[3 4 5 100 6 7 8 9 10 11 12 13] ->" "The unrolled list did not merge two small nodes."
+
+    lock_free_output=$("$BUILD_DIR/20_lock_free_lists" --benchmark 20000)
+    expect_contains "$lock_free_output" "Every item was accounted for." "A lock-free container lost or reordered items."
+
+    skip_list_output=$("$BUILD_DIR/20_skip_list" --benchmark 20000)
+    expect_contains "$skip_list_output" "All three maps agreed, and no reader ever missed a key." "The skip list disagreed with the sorted array or hash table."
+    skip_list_output=$("$BUILD_DIR/20_skip_list")
+    expect_contains "$skip_list_output" "The keys from 25 up to (not including) 70: 30 35 50 60" "The skip list range query returned the wrong keys."
+}
+
+run_bit_manipulation_check() {
+    bitset_lesson="$ROOT_DIR/Part 3 - The Advanced Path_ Towards Mastery/21_bitsets.c"
+
+    # An odd size, so the last word and the last Roaring chunk are only partly used.
+    bitset_output=$("$BUILD_DIR/21_bitsets" --benchmark 200003)
+    expect_contains "$bitset_output" "All bitset and Roaring results agreed." "The bitset operations or the Roaring bitmap disagreed."
+    bitset_output=$("$BUILD_DIR/21_bitsets")
+    expect_contains "$bitset_output" "That query matches 53 users. The first ten: 1 2 4 9 24 26 28 33 35 36" "The bitmap index query returned the wrong users."
+    expect_contains "$bitset_output" "chunk 3 (values 196608 to 262143): bitmap of 10000 values" "A full Roaring container was not turned into a bitmap."
+
+    # The AVX2 code is only compiled with -mavx2; check it too, where the CPU can run it.
+    if grep -qw avx2 /proc/cpuinfo 2>/dev/null &&
+        "$CC" $EFFECTIVE_CFLAGS -mavx2 "$bitset_lesson" -o "$BUILD_DIR/21_bitsets_avx2" 2>/dev/null; then
+        bitset_output=$("$BUILD_DIR/21_bitsets_avx2" --benchmark 200003)
+        expect_contains "$bitset_output" "SIMD: AVX2, 256-bit." "The AVX2 build did not use AVX2."
+        expect_contains "$bitset_output" "All bitset and Roaring results agreed." "The AVX2 bitset operations disagreed."
+    fi
+
+    sketch_output=$("$BUILD_DIR/21_probabilistic_sketches" --benchmark 20000)
+    expect_contains "$sketch_output" "All sketches stayed within their error bounds." "A Bloom filter, count-min sketch or HyperLogLog missed its error bound."
+    sketch_output=$("$BUILD_DIR/21_probabilistic_sketches")
+    expect_contains "$sketch_output" "Found all 1000 usernames" "The Bloom filter lost a key."
+    expect_contains "$sketch_output" "the: 4, cat: 2, sat: 2, mat: 1, bird: 0" "The count-min sketch counted the words wrong."
+
+    # An odd count, so the last bit-packed block and the last Stream VByte group are partial.
+    compression_lesson="$ROOT_DIR/Part 3 - The Advanced Path_ Towards Mastery/21_integer_compression.c"
+    compression_output=$("$BUILD_DIR/21_integer_compression" --benchmark 20003)
+    expect_contains "$compression_output" "Every codec gave back every list exactly." "An integer codec did not decode its list exactly."
+    compression_output=$("$BUILD_DIR/21_integer_compression")
+    expect_contains "$compression_output" "Varint        300 -> ac 02" "The varint encoder wrote the wrong bytes."
+    expect_contains "$compression_output" "control byte 0xe4, then 10 data bytes: 05 2c 01 70 11 01 00 00 00 01" "The Stream VByte encoder wrote the wrong bytes."
+
+    # The Stream VByte SIMD decoder is only compiled with SSSE3.
+    if grep -qw ssse3 /proc/cpuinfo 2>/dev/null &&
+        "$CC" $EFFECTIVE_CFLAGS -mssse3 "$compression_lesson" -o "$BUILD_DIR/21_integer_compression_ssse3" 2>/dev/null; then
+        compression_output=$("$BUILD_DIR/21_integer_compression_ssse3" --benchmark 20003)
+        expect_contains "$compression_output" "Every codec gave back every list exactly." "The SSSE3 Stream VByte decoder did not decode its list exactly."
+    fi
+}
+
 run_tiny_shell_check() {
     shell_bin=$BUILD_DIR/29_tiny_shell
 
@@ -255,6 +314,152 @@ run_tiny_shell_check() {
     expect_not_contains "$shell_output" "execvp failed" "TinyShell split an overlong command into a second command."
 }
 
+run_terminal_ui_check() {
+    render_output=$("$BUILD_DIR/33_advanced_terminal_ui" --benchmark 50)
+    expect_contains "$render_output" "Full-screen wave diff:" "Terminal UI benchmark did not render the full-screen wave."
+    # The bouncing box changes little per frame, so diffing must send far less.
+    if ! printf '%s\n' "$render_output" |
+        awk '/^Bouncing box/ { bytes[++n] = $(NF - 3) } END { exit !(n == 2 && bytes[2] * 10 < bytes[1]) }'; then
+        fail_with_output "Terminal UI renderer resent unchanged cells." "$render_output"
+    fi
+
+    list_output=$("$BUILD_DIR/33_advanced_terminal_ui" --benchmark-list 200)
+    expect_contains "$list_output" "1000000000 rows:" "Terminal UI list benchmark did not scroll a billion-row list."
+    # The virtual list formats one screenful per scroll, however long the list is.
+    if ! printf '%s\n' "$list_output" |
+        awk '/ rows: / { n++; if ($(NF - 4) != 38) bad = 1 } END { exit !(n == 3 && !bad) }'; then
+        fail_with_output "Terminal UI virtual list formatted rows that were not on screen." "$list_output"
+    fi
+}
+
+run_bench_runner_check() {
+    runner_bin=$BUILD_DIR/bench_runner
+    history_file=$BUILD_DIR/bench-history.csv
+
+    "$CC" $EFFECTIVE_CFLAGS "$ROOT_DIR/scripts/bench_runner.c" -o "$runner_bin"
+    runner_output=$("$runner_bin" --warmup 1 --repeat 3 --label hello --csv "$history_file" --commit aaa \
+        --profile smoke -- "$BUILD_DIR/1_hello_world")
+    expect_contains "$runner_output" "ms median" "Benchmark runner did not report a median time."
+    if ! awk -F, 'NR == 1 { ok = $1 == "timestamp" && $6 == "wall_median_ms" }
+        NR == 2 { ok = ok && $2 == "aaa" && $4 == "hello" && $5 == 3 && $10 > 0 }
+        END { exit !(ok && NR == 2) }' "$history_file"; then
+        fail_with_output "Benchmark runner wrote a bad history row." "$(cat "$history_file")"
+    fi
+    if "$runner_bin" --repeat 1 -- "$BUILD_DIR/no_such_program" 2>/dev/null; then
+        echo "Benchmark runner did not fail for a missing program." >&2
+        exit 1
+    fi
+
+    # A second commit, twice as slow, must show up as a regression.
+    awk -F, -v OFS=, 'NR == 2 { $2 = "bbb"; $6 = $6 * 2 + 1; print }' "$history_file" >> "$history_file"
+    compare_output=$(BENCH_HISTORY=$history_file sh "$ROOT_DIR/scripts/bench.sh" --compare)
+    expect_contains "$compare_output" "slower" "Benchmark comparison did not flag a slower commit."
+}
+
+run_capstone_checks() {
+    capstone_bin=$BUILD_DIR/35_capstone_awesome_text_adventure
+    generated_map=$BUILD_DIR/capstone_generated.map
+
+    load_output=$("$capstone_bin" --benchmark-load 2500 "$generated_map")
+    expect_contains "$load_output" "Loaded 2500 rooms" "Capstone loader did not load the generated benchmark world."
+    expect_contains "$load_output" "rooms/sec" "Capstone load benchmark did not report a load rate."
+    expect_contains "$load_output" "World image load time" "Capstone load benchmark did not time the compiled world image."
+
+    printf 'room 0 "Start"\nroom 1 "North"\nlink 0 n 1\nlink 1 s 0\n' > "$BUILD_DIR/capstone_headless.map"
+    headless_output=$(printf 'path 1\nnorth\ngo west\nxyzzy\ngo look\nSOUTH\nquit\nlook\n' |
+        "$capstone_bin" --headless "$BUILD_DIR/capstone_headless.map")
+    expect_contains "$headless_output" "> north
+North
+Exits: south" "Capstone headless mode did not move the player north."
+    expect_contains "$headless_output" "> go west
+You can't go that way." "Capstone headless mode did not reject a missing exit."
+    expect_contains "$headless_output" "Path to room 1 (1 step): north" "Capstone path command did not find the way north."
+    expect_contains "$headless_output" "> xyzzy
+I don't understand that command." "Capstone command lookup accepted an unknown verb."
+    expect_contains "$headless_output" "> go look
+That's not a valid direction." "Capstone command lookup treated a verb as a direction."
+    expect_contains "$headless_output" "> SOUTH
+Start" "Capstone command lookup did not handle an upper-case direction."
+    expect_contains "$headless_output" "Thank you for playing!" "Capstone headless mode did not finish the script."
+    if printf '%s' "$headless_output" | grep -q '> look'; then
+        fail_with_output "Capstone headless mode kept reading commands after quit." "$headless_output"
+    fi
+
+    rm -f "$BUILD_DIR/capstone_headless.map.sav"
+    save_output=$(printf 'north\nsave\nquit\n' | "$capstone_bin" --headless "$BUILD_DIR/capstone_headless.map")
+    expect_contains "$save_output" "Game saved." "Capstone save command did not finish writing the saved game."
+    restore_output=$(printf 'load\n' | "$capstone_bin" --headless "$BUILD_DIR/capstone_headless.map")
+    expect_contains "$restore_output" "> load
+Game loaded.
+North" "Capstone load command did not put the player back in the saved room."
+
+    command_output=$("$capstone_bin" --benchmark-commands "$BUILD_DIR/capstone_headless.map" 1000)
+    expect_contains "$command_output" "Ran 1000 commands" "Capstone command benchmark did not run every command."
+
+    printf 'room 0 "Start"\nroom 1 "North"\nroom 7 "Island"\nlink 0 n 1\nlink 7 s 0\n' > "$BUILD_DIR/capstone_island.map"
+    if validate_output=$("$capstone_bin" --validate "$BUILD_DIR/capstone_island.map"); then
+        fail_with_output "Capstone map validation accepted a map with an unreachable room." "$validate_output"
+    fi
+    expect_contains "$validate_output" "1 unreachable rooms: 7" "Capstone map validation did not report the unreachable room."
+
+    render_output=$("$capstone_bin" --benchmark-render "$BUILD_DIR/capstone_headless.map" 50)
+    expect_contains "$render_output" "Incremental redraw:" "Capstone render benchmark did not measure incremental redraws."
+    expect_contains "$render_output" "Full redraw:" "Capstone render benchmark did not measure full redraws."
+
+    "$capstone_bin" --generate 500 0 42 "$BUILD_DIR/capstone_maze_a.map" >/dev/null
+    "$capstone_bin" --generate 500 0 42 "$BUILD_DIR/capstone_maze_b.map" >/dev/null
+    if ! compare_output=$(cmp "$BUILD_DIR/capstone_maze_a.map" "$BUILD_DIR/capstone_maze_b.map" 2>&1); then
+        fail_with_output "Capstone world generator gave two different worlds for the same seed." "$compare_output"
+    fi
+    maze_output=$("$capstone_bin" --validate "$BUILD_DIR/capstone_maze_a.map")
+    expect_contains "$maze_output" "500 rooms, 500 reachable" "Capstone world generator made rooms that cannot be reached."
+
+    scale_output=$("$capstone_bin" --benchmark-scale 1000 "$generated_map")
+    expect_contains "$scale_output" "100 rooms: text load" "Capstone scaling benchmark skipped the smallest world."
+    expect_contains "$scale_output" "1000 rooms: text load" "Capstone scaling benchmark stopped before the largest world."
+}
+
+run_capstone_server_check() {
+    capstone_bin=$BUILD_DIR/35_capstone_awesome_text_adventure
+    server_log=$BUILD_DIR/capstone_server.log
+
+    for attempt in 1 2 3 4 5; do
+        port=$((45000 + ($$ + attempt) % 15000))
+        : > "$server_log"
+        "$capstone_bin" --server "$BUILD_DIR/capstone_headless.map" "$port" > "$server_log" 2>&1 &
+        SOCKET_SERVER_PID=$!
+
+        for _ in 1 2 3 4 5 6 7 8 9 10; do
+            if grep -F "Serving" "$server_log" >/dev/null 2>&1 || ! kill -0 "$SOCKET_SERVER_PID" >/dev/null 2>&1; then
+                break
+            fi
+
+            sleep 0.2
+        done
+
+        if kill -0 "$SOCKET_SERVER_PID" >/dev/null 2>&1; then
+            benchmark_output=$("$capstone_bin" --benchmark-server "$port" 20 10 2>&1)
+            kill "$SOCKET_SERVER_PID"
+            wait "$SOCKET_SERVER_PID"
+            SOCKET_SERVER_PID=
+
+            expect_contains "$benchmark_output" "Served 20 players: 220 commands" "Capstone server did not serve every benchmark player."
+            expect_contains "$(cat "$server_log")" "Server stopped after serving 20 players." "Capstone server did not stop cleanly."
+            return 0
+        fi
+
+        wait "$SOCKET_SERVER_PID" >/dev/null 2>&1 || true
+        SOCKET_SERVER_PID=
+
+        if grep -F "Bind failed: Operation not permitted" "$server_log" >/dev/null 2>&1; then
+            printf 'Skipping capstone server check (environment does not permit binding a local listening socket).\n'
+            return 0
+        fi
+    done
+
+    fail_with_output "Capstone server could not start." "$(cat "$server_log")"
+}
+
 run_sanitizer_regressions() {
     if [ -z "${SANITIZER_FLAGS:-}" ]; then
         printf 'Skipping sanitizer regressions (compiler does not support -fsanitize=address,undefined).\n'
@@ -271,17 +476,182 @@ run_sanitizer_regressions() {
     : > "$empty_file"
     ASAN_OPTIONS=detect_leaks=0 UBSAN_OPTIONS=halt_on_error=1 "$analyzer_san_bin" "$empty_file" >/dev/null 2>&1
 
+    # Hazard pointers exist to prevent use-after-free; AddressSanitizer would catch one.
+    lock_free_san_bin=$BUILD_DIR/20_lock_free_lists_san
+    "$CC" $EFFECTIVE_CFLAGS "$ROOT_DIR/Part 3 - The Advanced Path_ Towards Mastery/20_lock_free_lists.c" \
+        -o "$lock_free_san_bin" -pthread $SANITIZER_FLAGS
+    UBSAN_OPTIONS=halt_on_error=1 "$lock_free_san_bin" --benchmark 5000 >/dev/null
+
+    bitset_san_bin=$BUILD_DIR/21_bitsets_san
+    "$CC" $EFFECTIVE_CFLAGS "$ROOT_DIR/Part 3 - The Advanced Path_ Towards Mastery/21_bitsets.c" \
+        -o "$bitset_san_bin" $SANITIZER_FLAGS
+    UBSAN_OPTIONS=halt_on_error=1 "$bitset_san_bin" --benchmark 200003 >/dev/null
+
+    # The SIMD decoders load 16 bytes at a time; none of them may read past the encoded data.
+    compression_san_bin=$BUILD_DIR/21_integer_compression_san
+    "$CC" $EFFECTIVE_CFLAGS "$ROOT_DIR/Part 3 - The Advanced Path_ Towards Mastery/21_integer_compression.c" \
+        -o "$compression_san_bin" $SANITIZER_FLAGS
+    UBSAN_OPTIONS=halt_on_error=1 "$compression_san_bin" --benchmark 20003 >/dev/null
+
     cat > "$capstone_harness" <<EOF
+// The capstone asks for madvise(); that only works before the first header.
+#define _DEFAULT_SOURCE 1
 #include <stdlib.h>
 #include <string.h>
 
+// A tiny message log, so that the tests below can fill it up.
+#define LOG_SCROLLBACK_LINES 8
+#define LOG_BUFFER_SIZE 2048
+// Small world regions, so a small world image already needs evicting.
+#define REGION_SIZE (64 * 1024)
+#define MAX_RESIDENT_REGIONS 2
 #define main capstone_lesson_main
 #include "$ROOT_DIR/Part 5 - Expert Systems & Application Development/35_capstone_awesome_text_adventure.c"
 #undef main
 
+static int write_map(const char *path, const char *text)
+{
+    FILE *file = fopen(path, "w");
+
+    if (!file)
+    {
+        return 0;
+    }
+    fputs(text, file);
+    return fclose(file) == 0;
+}
+
+static int check_message_log(void)
+{
+    static MessageLog log;
+    static char message[2100];
+    int i;
+
+    // More messages than the log can count: only the newest 8 are kept.
+    for (i = 0; i < 20; i++)
+    {
+        snprintf(message, sizeof(message), "message %d", i);
+        message_log_add(&log, message);
+    }
+    if (log.count != 8 || strcmp(message_log_get(&log, 0), "message 12") != 0 ||
+        strcmp(message_log_get(&log, 7), "message 19") != 0)
+    {
+        return 0;
+    }
+
+    // More text than the log can hold: old messages are dropped, and the ones
+    // that are left must still be whole.
+    for (i = 0; i < 5; i++)
+    {
+        memset(message, 'a' + i, 700);
+        message[700] = '\0';
+        message_log_add(&log, message);
+    }
+    if (log.count < 2)
+    {
+        return 0;
+    }
+    for (i = 0; i < log.count; i++)
+    {
+        const char *stored = message_log_get(&log, i);
+        char expected = (char)('a' + 5 - log.count + i);
+
+        if (strlen(stored) != 700 || stored[0] != expected || stored[699] != expected)
+        {
+            return 0;
+        }
+    }
+
+    // Overlong messages are cut to LOG_MESSAGE_SIZE - 1 characters.
+    memset(message, 'z', 2000);
+    message[2000] = '\0';
+    message_log_add(&log, message);
+    return strlen(message_log_get(&log, log.count - 1)) == LOG_MESSAGE_SIZE - 1;
+}
+
+static int check_world_regions(void)
+{
+    char south[] = "south";
+    GameState *world;
+    FILE *map;
+    int ok;
+
+    // 20000 rooms make a 480 KB image: 8 regions, of which only 2 may stay loaded.
+    if (!generate_world_file("$BUILD_DIR/capstone_regions.map", 20000, 100, 1) ||
+        !compile_world("$BUILD_DIR/capstone_regions.map", "$BUILD_DIR/capstone_regions.img"))
+    {
+        return 0;
+    }
+    world = load_world("$BUILD_DIR/capstone_regions.img");
+    if (!world || !world->region_last_use || !place_player_at_start(world))
+    {
+        return 0;
+    }
+
+    // Walk from the top of the 142-room-wide grid to the bottom.
+    world->headless = 1;
+    for (int i = 0; i < 140; i++)
+    {
+        handle_go(world, south);
+    }
+
+    // Evicted rooms are read back from the file when they are used again.
+    ok = world->player.current_room->id == 140 * 142 && world->resident_regions <= MAX_RESIDENT_REGIONS &&
+         world->region_evictions >= 5 && find_room_by_id(world, 0)->id == 0 &&
+         room_exit(world, find_room_by_id(world, 0), EAST) == find_room_by_id(world, 1) &&
+         search_rooms(world, find_room_by_id(world, 0), NULL) == 20000;
+    cleanup(world);
+    if (!ok)
+    {
+        return 0;
+    }
+
+    // Ids with gaps take the binary search, which must count every region it
+    // reads, including the one holding the room it finds.
+    map = fopen("$BUILD_DIR/capstone_sparse.map", "w");
+    if (!map)
+    {
+        return 0;
+    }
+    for (int i = 0; i < 20000; i++)
+    {
+        fprintf(map, "room %d \"Room %d\"\n", 3 * i, 3 * i);
+    }
+    if (fclose(map) != 0 ||
+        !compile_world("$BUILD_DIR/capstone_sparse.map", "$BUILD_DIR/capstone_sparse.img"))
+    {
+        return 0;
+    }
+    world = load_world("$BUILD_DIR/capstone_sparse.img");
+    if (!world || !world->region_last_use || world->room_ids_dense)
+    {
+        return 0;
+    }
+    for (int i = 0; ok && i < 20000; i += 997)
+    {
+        Room *room = find_room_by_id(world, 3 * i);
+        size_t region = room ? (size_t)((char *)room - (char *)world->image) / REGION_SIZE : 0;
+
+        ok = room && room->id == 3 * i && world->region_last_use[region] != 0 &&
+             world->resident_regions <= MAX_RESIDENT_REGIONS;
+    }
+    ok = ok && find_room_by_id(world, 1) == NULL && world->region_evictions >= 5;
+    cleanup(world);
+    return ok;
+}
+
+static void cleanup_fields(GameState *game)
+{
+    free(game->rooms);
+    free(game->strings.data);
+    string_pool_free_index(&game->strings);
+    free(game->pending_links);
+}
+
 int main(void)
 {
     GameState game;
+    GameState *loaded;
     char room_line[700];
     char link_line[64];
     int i;
@@ -301,29 +671,85 @@ int main(void)
         return 1;
     }
 
-    game.all_rooms[0] = calloc(1, sizeof(Room));
-    game.all_rooms[1] = calloc(1, sizeof(Room));
-    if (!game.all_rooms[0] || !game.all_rooms[1])
+    strcpy(link_line, "link 0 abcdefghijk 1");
+    if (parse_link(link_line, &game) != 0)
     {
-        free(game.all_rooms[0]);
-        free(game.all_rooms[1]);
         return 1;
     }
+    cleanup_fields(&game);
 
-    game.all_rooms[0]->id = 0;
-    game.all_rooms[1]->id = 1;
-    game.num_rooms = 2;
+    if (!write_map("$BUILD_DIR/capstone_forward.map",
+                   "link 0 n 1\\nlink 1 s 0\\nroom 1 \\"North\\"\\nroom 0 \\"Start\\"\\n"))
+    {
+        return 1;
+    }
+    loaded = load_world("$BUILD_DIR/capstone_forward.map");
+    if (!loaded || loaded->num_rooms != 2 ||
+        room_exit(loaded, find_room_by_id(loaded, 0), NORTH) != find_room_by_id(loaded, 1) ||
+        room_exit(loaded, find_room_by_id(loaded, 1), SOUTH) != find_room_by_id(loaded, 0))
+    {
+        return 1;
+    }
+    cleanup(loaded);
 
-    strcpy(link_line, "link 0 abcdefghijk 1");
-    if (parse_link(link_line, &game) != 0)
+    if (!compile_world("$BUILD_DIR/capstone_forward.map", "$BUILD_DIR/capstone_forward.img") ||
+        !is_world_image("$BUILD_DIR/capstone_forward.img"))
+    {
+        return 1;
+    }
+    loaded = load_world("$BUILD_DIR/capstone_forward.img");
+    if (!loaded || loaded->num_rooms != 2 ||
+        strcmp(room_description(loaded, find_room_by_id(loaded, 1)), "North") != 0 ||
+        room_exit(loaded, find_room_by_id(loaded, 0), NORTH) != find_room_by_id(loaded, 1) ||
+        room_exit(loaded, find_room_by_id(loaded, 0), EAST) != NULL)
+    {
+        return 1;
+    }
+    cleanup(loaded);
+
+    if (!write_map("$BUILD_DIR/capstone_shared.map",
+                   "room 0 \\"Same\\"\\nroom 5 \\"Same\\"\\nroom 9 \\"Other\\"\\nlink 9 w 5\\n"))
+    {
+        return 1;
+    }
+    loaded = load_world("$BUILD_DIR/capstone_shared.map");
+    if (!loaded || loaded->num_rooms != 3 ||
+        find_room_by_id(loaded, 0)->description != find_room_by_id(loaded, 5)->description ||
+        loaded->strings.length != sizeof("Same") + sizeof("Other") || find_room_by_id(loaded, 4) != NULL ||
+        room_exit(loaded, find_room_by_id(loaded, 9), WEST) != find_room_by_id(loaded, 5))
+    {
+        return 1;
+    }
+    cleanup(loaded);
+
+    if (!write_map("$BUILD_DIR/capstone_truncated.img", "ADVWORLD\\001") ||
+        load_world("$BUILD_DIR/capstone_truncated.img") != NULL)
+    {
+        return 1;
+    }
+
+    if (!write_map("$BUILD_DIR/capstone_missing.map", "room 0 \\"Start\\"\\nlink 0 n 7\\n") ||
+        load_world("$BUILD_DIR/capstone_missing.map") != NULL)
+    {
+        return 1;
+    }
+
+    if (!write_map("$BUILD_DIR/capstone_duplicate.map", "room 0 \\"Start\\"\\nroom 0 \\"Again\\"\\n") ||
+        load_world("$BUILD_DIR/capstone_duplicate.map") != NULL)
+    {
+        return 1;
+    }
+
+    if (!check_message_log())
+    {
+        return 1;
+    }
+
+    if (!check_world_regions())
     {
-        free(game.all_rooms[0]);
-        free(game.all_rooms[1]);
         return 1;
     }
 
-    free(game.all_rooms[0]);
-    free(game.all_rooms[1]);
     return 0;
 }
 EOF
@@ -374,6 +800,9 @@ while IFS= read -r lesson_path; do
         ./Part\ 5\ -\ Expert\ Systems\ \&\ Application\ Development/31_make_files_for_multi_file_projects/*)
             continue
             ;;
+        ./scripts/*|./libcore/*)
+            continue
+            ;;
     esac
 
     lesson_path=${lesson_path#./}
@@ -388,10 +817,39 @@ make -C "$LESSON31_DIR" CC="$CC" CFLAGS="$EFFECTIVE_CFLAGS" >/dev/null
 test -x "$LESSON31_DIR/31_project_main"
 make -C "$LESSON31_DIR" clean >/dev/null
 
+printf 'Building %s\n' "$LIBCORE_DIR"
+make -C "$LIBCORE_DIR" clean >/dev/null
+make -C "$LIBCORE_DIR" CC="$CC" CFLAGS="$EFFECTIVE_CFLAGS -O2" >/dev/null
+libcore_output=$(cd "$LIBCORE_DIR" && ./core_check)
+expect_contains "$libcore_output" "libcore check passed." "libcore's checks failed."
+# core_bench exits with status 1 if the inline and library helpers disagree.
+libcore_output=$(cd "$LIBCORE_DIR" && ./core_bench 1000)
+expect_contains "$libcore_output" "parse_int" "core_bench did not time core_parse_int."
+make -C "$LIBCORE_DIR" clean >/dev/null
+# Again with the header-only fast paths in place of the library calls.
+make -C "$LIBCORE_DIR" CC="$CC" CFLAGS="$EFFECTIVE_CFLAGS -O2" CORE_INLINE=1 >/dev/null
+libcore_output=$(cd "$LIBCORE_DIR" && ./core_check)
+expect_contains "$libcore_output" "libcore check passed." "libcore's checks failed with CORE_INLINE."
+make -C "$LIBCORE_DIR" clean >/dev/null
+
+printf 'Building every lesson with the top-level Makefile\n'
+make -C "$ROOT_DIR" -j4 PROFILE=release BUILD_ROOT="$BUILD_DIR/make" CC="$CC" CFLAGS="$EFFECTIVE_CFLAGS" >/dev/null
+test -x "$BUILD_DIR/make/release/bin/35_capstone_awesome_text_adventure"
+test -x "$BUILD_DIR/make/release/bin/31_project_main"
+test -f "$BUILD_DIR/make/release/lib/libcore.a"
+# A second run must find nothing to rebuild.
+make -C "$ROOT_DIR" -q PROFILE=release BUILD_ROOT="$BUILD_DIR/make" CC="$CC" CFLAGS="$EFFECTIVE_CFLAGS" >/dev/null
+
 run_analyzer_check
 run_socket_check
 run_student_record_checks
+run_linked_list_check
+run_bit_manipulation_check
 run_tiny_shell_check
+run_terminal_ui_check
+run_bench_runner_check
+run_capstone_checks
+run_capstone_server_check
 run_sanitizer_regressions
 
 printf 'Smoke check passed. Compiled %d single-file lessons plus lesson 31.\n' "$compiled_count"